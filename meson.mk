@@ -24,5 +24,9 @@ EXTRA_DIST +=                                \
 	src/client/meson.build               \
 	src/meson.build                      \
 	tests/gnome-shell-client/meson.build \
+	tests/history/meson.build            \
+	tests/history-loader/meson.build     \
+	tests/replacer/meson.build           \
+	tests/search-provider/meson.build    \
 	tests/meson.build                    \
 	$(NULL)
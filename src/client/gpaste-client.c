@@ -6,24 +6,33 @@
 
 #include <gpaste-util.h>
 
+#include <glib/gstdio.h>
+
 #include <getopt.h>
 #include <stdio.h>
+#include <string.h>
+
+/* Above this size, contents are passed to the daemon through a memfd instead of the bus */
+#define G_PASTE_CLIENT_FD_THRESHOLD (64 * 1024)
 
 typedef struct {
-    GPasteClient *client;
-    gint          argc;
-    const gchar **args;
-    gchar        *pipe_data;
-    const gchar  *uuid;
-    gboolean      help;
-    gboolean      version;
-    gboolean      oneline;
-    gboolean      raw;
-    gboolean      reverse;
-    gboolean      use_index;
-    gboolean      zero;
-    const gchar  *decoration;
-    const gchar  *separator;
+    GPasteClient    *client;
+    gint             argc;
+    const gchar    **args;
+    gchar           *pipe_data;
+    const gchar     *uuid;
+    gboolean         help;
+    gboolean         version;
+    gboolean         oneline;
+    gboolean         raw;
+    gboolean         reverse;
+    gboolean         use_index;
+    gboolean         zero;
+    const gchar     *decoration;
+    const gchar     *separator;
+    GPasteSearchMode search_mode;
+    guint64          offset;
+    guint64          limit;
 } Context;
 
 /*
@@ -37,7 +46,11 @@ parse_cmdline (int     *argc,
 {
     struct option long_options[] = {
         { "decoration", required_argument, NULL,  'd'  },
+        { "fuzzy",      no_argument,       NULL,  'f'  },
         { "help",       no_argument,       NULL,  'h'  },
+        { "limit",      required_argument, NULL,  'm'  },
+        { "literal",    no_argument,       NULL,  'l'  },
+        { "offset",     required_argument, NULL,  'O'  },
         { "oneline",    no_argument,       NULL,  'o'  },
         { "raw",        no_argument,       NULL,  'r'  },
         { "reverse",    no_argument,       NULL,  'e'  },
@@ -49,16 +62,28 @@ parse_cmdline (int     *argc,
     };
     gint64 c;
 
-    while ((c = getopt_long(*argc, *argv, "d:hores:ivz", long_options, NULL)) != -1)
+    while ((c = getopt_long(*argc, *argv, "d:fhm:lO:ores:ivz", long_options, NULL)) != -1)
     {
         switch (c)
         {
         case 'd':
             ctx->decoration = optarg;
             break;
+        case 'f':
+            ctx->search_mode = G_PASTE_SEARCH_MODE_FUZZY;
+            break;
         case 'h':
             ctx->help = TRUE;
             break;
+        case 'm':
+            ctx->limit = g_ascii_strtoull (optarg, NULL, 10);
+            break;
+        case 'l':
+            ctx->search_mode = G_PASTE_SEARCH_MODE_LITERAL;
+            break;
+        case 'O':
+            ctx->offset = g_ascii_strtoull (optarg, NULL, 10);
+            break;
         case 'o':
             ctx->oneline = TRUE;
             break;
@@ -96,20 +121,38 @@ parse_cmdline (int     *argc,
     return TRUE;
 }
 
-static gchar *
-extract_pipe_data (void)
+static GString *
+read_pipe_data (void)
 {
     if (isatty (STDIN_FILENO))
         return NULL; /* We're not being piped */
 
-    g_autoptr (GString) data = g_string_new (NULL);
-    gint64 c;
+    GString *data = g_string_new (NULL);
+    gchar buffer[65536];
+    gsize r;
+
+    while ((r = fread (buffer, 1, sizeof (buffer), stdin)))
+        g_string_append_len (data, buffer, r);
+
+    return data;
+}
 
-    while ((c = fgetc (stdin)) != EOF)
-        data = g_string_append_c (data, (guchar)c);
-    g_string_append_c (data, '\0');
+static gchar *
+extract_pipe_data (void)
+{
+    g_autoptr (GString) data = read_pipe_data ();
+
+    return (data && *data->str) ? g_strdup (data->str) : NULL;
+}
+
+static const gchar *
+get_pipe_data (Context *ctx)
+{
+    /* Only consume stdin once we know we need it, see g_paste_add_from_stdin */
+    if (!ctx->pipe_data)
+        ctx->pipe_data = extract_pipe_data ();
 
-    return (*data->str) ? g_strdup (data->str) : NULL;
+    return ctx->pipe_data;
 }
 
 static const gchar *
@@ -175,6 +218,8 @@ show_help (void)
     printf ("  %s rename-password <%s> <%s>: %s\n", progname, _("old name"), _("new name"), _("rename the password"));
     /* Translators: help for gpaste get <uuid> */
     printf ("  %s get <uuid>: %s\n", progname, _("get the item <uuid> from the history"));
+    /* Translators: help for gpaste search <pattern> */
+    printf ("  %s search <%s>: %s\n", progname, _("pattern"), _("print the items matching <pattern> with uuids"));
     /* Translators: help for gpaste select <uuid> */
     printf ("  %s select <uuid>: %s\n", progname, _("set the item <uuid> from the history to the clipboard"));
     /* Translators: help for gpaste replace <uuid> <contents> */
@@ -185,12 +230,16 @@ show_help (void)
     printf ("  %s set-password <uuid> <%s>: %s\n", progname, _("name"), _("set the item <uuid> from the history as a password named <name>"));
     /* Translators: help for gpaste delete <uuid> */
     printf ("  %s delete <uuid>: %s\n", progname, _("delete item <uuid> from the history"));
+    /* Translators: help for gpaste delete <uuid> … <uuid> */
+    printf ("  %s delete <uuid> … <uuid>: %s\n", progname, _("delete the items matching the uuids from the history at once"));
     /* Translators: help for gpaste delete-passworf <name> */
     printf ("  %s delete-password <%s>: %s\n", progname, _("name"), _("delete the password <name> from the history"));
     /* Translators: help for gpaste file <path> */
     printf ("  %s file <%s>: %s\n", progname, _("path"), _("put the content of the file at <path> into the clipboard"));
     /* Translators: help for whatever | gpaste */
     printf ("  %s | %s: %s\n", _("whatever"), progname, _("set the output of whatever to clipboard"));
+    /* Translators: help for whatever | gpaste add --zero */
+    printf ("  %s | %s add --zero: %s\n", _("whatever"), progname, _("add each NUL-separated part of the output of whatever as its own item"));
     /* Translators: help for gpaste empty */
     printf ("  %s empty: %s\n", progname, _("empty the history"));
     /* Translators: help for gpaste start */
@@ -243,6 +292,18 @@ show_help (void)
     printf("  --decoration <%s>: %s\n", _("string"), _("add the given decoration to the beginning and the end of each item before merging"));
     /* Translators: help for --separator <string> */
     printf("  --separator <%s>: %s\n", _("string"), _("add the given separator between each item when merging"));
+
+    printf("\n");
+    printf(_("Search options:"));
+    printf("\n");
+    /* Translators: help for --literal */
+    printf("  --literal: %s\n", _("look for the pattern as plain text instead of a regular expression"));
+    /* Translators: help for --fuzzy */
+    printf("  --fuzzy: %s\n", _("look for items containing the characters of the pattern in that order"));
+    /* Translators: help for --offset <number> */
+    printf("  --offset <%s>: %s\n", _("number"), _("skip the given number of matching items"));
+    /* Translators: help for --limit <number> */
+    printf("  --limit <%s>: %s\n", _("number"), _("stop after the given number of matching items"));
 }
 
 static void
@@ -289,7 +350,7 @@ g_paste_history (Context *ctx,
                  GError **error)
 {
     GList *history = (ctx->raw) ?
-        g_paste_client_get_raw_history_sync (ctx->client, error) :
+        g_paste_client_get_raw_history_fd_sync (ctx->client, error) :
         g_paste_client_get_history_sync (ctx->client, error);
 
     if (*error)
@@ -477,14 +538,82 @@ g_paste_ui (Context *ctx   G_GNUC_UNUSED,
     return spawn ("Ui");
 }
 
+static gint
+g_paste_add_from_stdin (Context *ctx,
+                        GError **error)
+{
+    g_autoptr (GPasteSettings) settings = g_paste_settings_new ();
+    gsize length;
+    /* Splice what we're being piped straight into a memfd the daemon will map */
+    gint fd = g_paste_util_memfd_new_from_fd ("gpaste-client", STDIN_FILENO, g_paste_settings_get_max_text_item_size (settings), &length, error);
+
+    if (fd < 0)
+    {
+        if (g_error_matches (*error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE))
+        {
+            /* No need to read the rest, the daemon wouldn't keep it anyway */
+            g_clear_error (error);
+            g_critical (_("Cannot add data larger than the maximum text item size."));
+        }
+        return EXIT_FAILURE;
+    }
+
+    if (!length)
+    {
+        g_close (fd, NULL);
+        return -1; /* Nothing was piped after all */
+    }
+
+    g_paste_client_add_from_fd_sync (ctx->client, fd, error);
+    g_close (fd, NULL);
+
+    return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static gint
+g_paste_add_many_from_stdin (Context *ctx,
+                             GError **error)
+{
+    /* With --zero, each NUL-terminated part is an item of its own, like what find -print0 outputs */
+    g_autoptr (GString) data = read_pipe_data ();
+    g_autoptr (GPtrArray) texts = g_ptr_array_new ();
+
+    for (const gchar *text = data->str, *end = data->str + data->len; text < end; text += strlen (text) + 1)
+    {
+        if (!*text)
+            continue;
+
+        if (!g_utf8_validate (text, -1, NULL))
+        {
+            g_critical (_("Cannot add non utf8 data as text."));
+            return EXIT_FAILURE;
+        }
+
+        g_ptr_array_add (texts, (gpointer) text);
+    }
+
+    if (!texts->len)
+        return -1; /* Nothing was piped after all */
+
+    /* All of them in one go, the daemon saves and announces them at once */
+    g_paste_client_add_many_sync (ctx->client, (const gchar **) texts->pdata, texts->len, error);
+
+    return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 static gint
 g_paste_add (Context *ctx,
              GError **error)
 {
-    const gchar *data = (ctx->argc > 0) ? ctx->args[0] : ctx->pipe_data;
+    if (ctx->argc < 1)
+    {
+        if (isatty (STDIN_FILENO))
+            return -1;
 
-    if (!data)
-        return -1;
+        return (ctx->zero) ? g_paste_add_many_from_stdin (ctx, error) : g_paste_add_from_stdin (ctx, error);
+    }
+
+    const gchar *data = ctx->args[0];
 
     if (!g_utf8_validate(data, -1, NULL))
     {
@@ -492,7 +621,10 @@ g_paste_add (Context *ctx,
         return EXIT_FAILURE;
     }
 
-    g_paste_client_add_sync (ctx->client, data, error);
+    if (strlen (data) > G_PASTE_CLIENT_FD_THRESHOLD)
+        g_paste_client_add_fd_sync (ctx->client, data, error);
+    else
+        g_paste_client_add_sync (ctx->client, data, error);
 
     return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -501,7 +633,7 @@ static gint
 g_paste_add_password (Context *ctx,
                       GError **error)
 {
-    const gchar *data = (ctx->argc > 1) ? ctx->args[1] : ctx->pipe_data;
+    const gchar *data = (ctx->argc > 1) ? ctx->args[1] : get_pipe_data (ctx);
 
     if (!data)
         return EXIT_FAILURE;
@@ -530,7 +662,40 @@ static gint
 g_paste_delete (Context *ctx,
                 GError **error)
 {
-    g_paste_client_delete_sync (ctx->client, ctx->uuid, error);
+    if (ctx->argc < 1)
+        return -1;
+
+    if (ctx->argc == 1)
+    {
+        g_paste_client_delete_sync (ctx->client, ctx->uuid, error);
+
+        return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    g_autoptr (GPtrArray) uuids = g_ptr_array_new_with_free_func (g_free);
+
+    /* main already took care of the first one */
+    g_ptr_array_add (uuids, g_strdup (ctx->uuid));
+
+    /* Resolve all the indexes before deleting anything, so that they don't shift */
+    for (gint i = 1; i < ctx->argc; ++i)
+    {
+        if (ctx->use_index)
+        {
+            g_autoptr (GPasteClientItem) item = g_paste_client_get_element_at_index_sync (ctx->client, g_ascii_strtoull (ctx->args[i], NULL, 10), error);
+
+            if (*error)
+                return EXIT_FAILURE;
+
+            g_ptr_array_add (uuids, g_strdup (g_paste_client_item_get_uuid (item)));
+        }
+        else
+        {
+            g_ptr_array_add (uuids, g_strdup (ctx->args[i]));
+        }
+    }
+
+    g_paste_client_delete_many_sync (ctx->client, (const gchar **) uuids->pdata, uuids->len, error);
 
     return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -557,7 +722,29 @@ static gint
 g_paste_get (Context *ctx,
              GError **error)
 {
-    g_autofree gchar *value = ((ctx->raw) ? g_paste_client_get_raw_element_sync : g_paste_client_get_element_sync) (ctx->client, ctx->uuid, error);
+    /* GetElement only sends a preview, but the whole text is what we're asked for */
+    gboolean full = ctx->raw || g_paste_client_get_element_kind_sync (ctx->client, ctx->uuid, error) == G_PASTE_ITEM_KIND_TEXT;
+
+    if (*error)
+        return EXIT_FAILURE;
+
+    if (full)
+    {
+        /* We can't know the size beforehand, so always go through a memfd */
+        g_autoptr (GBytes) contents = g_paste_client_get_raw_element_fd_sync (ctx->client, ctx->uuid, error);
+
+        if (*error)
+            return EXIT_FAILURE;
+
+        gsize length;
+        gconstpointer data = g_bytes_get_data (contents, &length);
+
+        fwrite (data, 1, length, stdout);
+
+        return EXIT_SUCCESS;
+    }
+
+    g_autofree gchar *value = g_paste_client_get_element_sync (ctx->client, ctx->uuid, error);
 
     if (*error)
         return EXIT_FAILURE;
@@ -571,12 +758,15 @@ static gint
 g_paste_replace (Context *ctx,
                  GError **error)
 {
-    const gchar *data = (ctx->argc > 1) ? ctx->args[1] : ctx->pipe_data;
+    const gchar *data = (ctx->argc > 1) ? ctx->args[1] : get_pipe_data (ctx);
 
     if (!data)
         return EXIT_FAILURE;
 
-    g_paste_client_replace_sync (ctx->client, ctx->uuid, data, error);
+    if (strlen (data) > G_PASTE_CLIENT_FD_THRESHOLD)
+        g_paste_client_replace_fd_sync (ctx->client, ctx->uuid, data, error);
+    else
+        g_paste_client_replace_sync (ctx->client, ctx->uuid, data, error);
 
     return (*error) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -585,7 +775,7 @@ static gint
 g_paste_search (Context *ctx,
                 GError **error)
 {
-    g_auto (GStrv) results = g_paste_client_search_sync (ctx->client, ctx->args[0], error);
+    g_auto (GStrv) results = g_paste_client_search_with_options_sync (ctx->client, ctx->args[0], ctx->search_mode, ctx->offset, ctx->limit, error);
 
     if (*error)
         return EXIT_FAILURE;
@@ -716,11 +906,11 @@ g_paste_dispatch (gint         argc,
         { 2, "add-password",    1,        TRUE,  g_paste_add_password    },
         { 2, "bh",              1,        TRUE,  g_paste_backup_history  },
         { 2, "backup-history",  1,        TRUE,  g_paste_backup_history  },
-        { 2, "d",               0,        TRUE,  g_paste_delete          },
-        { 2, "del",             0,        TRUE,  g_paste_delete          },
-        { 2, "delete",          0,        TRUE,  g_paste_delete          },
-        { 2, "rm",              0,        TRUE,  g_paste_delete          },
-        { 2, "remove",          0,        TRUE,  g_paste_delete          },
+        { 2, "d",               G_MAXINT, TRUE,  g_paste_delete          },
+        { 2, "del",             G_MAXINT, TRUE,  g_paste_delete          },
+        { 2, "delete",          G_MAXINT, TRUE,  g_paste_delete          },
+        { 2, "rm",              G_MAXINT, TRUE,  g_paste_delete          },
+        { 2, "remove",          G_MAXINT, TRUE,  g_paste_delete          },
         { 2, "dp",              0,        TRUE,  g_paste_delete_password },
         { 2, "delete-password", 0,        TRUE,  g_paste_delete_password },
         { 2, "f",               0,        TRUE,  g_paste_file            },
@@ -775,13 +965,12 @@ main (gint argc, gchar *argv[])
     g_set_prgname (argv[0]);
 
     g_autoptr (GError) error = NULL;
-    Context ctx = { NULL, 0, NULL, NULL, NULL, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE, NULL, NULL };
+    Context ctx = { NULL, 0, NULL, NULL, NULL, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE, NULL, NULL, G_PASTE_SEARCH_MODE_REGEX, 0, 0 };
     gint status = EXIT_SUCCESS;
 
     if (parse_cmdline (&argc, &argv, &ctx))
     {
         g_autoptr (GPasteClient) client = ctx.client = g_paste_client_new_sync (&error);
-        g_autofree gchar *pipe_data = ctx.pipe_data = extract_pipe_data ();
         g_autofree gchar *uuid = NULL;
 
         if (ctx.use_index && ctx.argc > 0)
@@ -803,6 +992,8 @@ main (gint argc, gchar *argv[])
             status = g_paste_dispatch (argc, (argc > 0) ? argv[0] : NULL, &ctx, &error);
         }
 
+        g_free (ctx.pipe_data);
+
         if (error)
         {
             g_critical ("%s\n", (error) ? error->message : _("Couldn't connect to GPaste daemon"));
@@ -36,18 +36,13 @@ signal_handler (gpointer user_data)
     return G_SOURCE_REMOVE;
 }
 
-typedef struct
-{
-    GPasteDaemon *daemon;
-    GApplication *app;
-} Usr1Data;
-
 static gboolean
 usr1_handler (gpointer user_data)
 {
-    Usr1Data *data = user_data;
+    GPasteDaemon *g_paste_daemon = user_data;
 
-    reexec (data->daemon, data->app);
+    /* This ends up calling reexec through the reexecute-self signal */
+    g_paste_daemon_reexecute (g_paste_daemon);
 
     return G_SOURCE_REMOVE;
 }
@@ -61,44 +56,48 @@ enum
     C_LAST_SIGNAL
 };
 
+typedef struct
+{
+    GPasteBus        *bus;
+    GPasteDaemon     *daemon;
+    GPasteBusObject **search_provider;
+    GApplication     *gapp;
+} CallbackData;
+
 G_GNUC_NORETURN static void
 on_name_lost (GPasteBus *bus G_GNUC_UNUSED,
               gpointer   user_data)
 {
-    GApplication *app = user_data;
+    CallbackData *data = user_data;
 
     fprintf (stderr, "%s\n", _("Could not acquire DBus name."));
-    g_application_quit (app);
+    g_application_quit (data->gapp);
+
+    /* We don't go through the daemon teardown, don't lose the pending save */
+    g_paste_history_flush (g_paste_daemon_get_history (data->daemon));
 
     exit (EXIT_FAILURE);
 }
 
-typedef struct
-{
-    GPasteBus        *bus;
-    GPasteDaemon     *daemon;
-    GPasteBusObject **search_provider;
-    GApplication     *gapp;
-} CallbackData;
-
 static void
 register_bus_object (GPasteBus       *bus,
                      GPasteBusObject *object,
-                     GApplication    *gapp)
+                     CallbackData    *data)
 {
     g_autoptr (GError) error = NULL;
 
     if (!g_paste_bus_object_register_on_connection (object, g_paste_bus_get_connection (bus), &error))
-        on_name_lost (bus, gapp);
+        on_name_lost (bus, data);
 }
 
 static gboolean
 register_search_provider (gpointer user_data)
 {
     CallbackData *data = user_data;
-    GPasteBusObject *search_provider = *(data->search_provider) = g_paste_search_provider_new ();
+    /* We live in the same process as the history, no need to go through the bus */
+    GPasteBusObject *search_provider = *(data->search_provider) = g_paste_search_provider_new_for_history (g_paste_daemon_get_history (data->daemon));
 
-    register_bus_object (data->bus, search_provider, data->gapp);
+    register_bus_object (data->bus, search_provider, data);
 
     return G_SOURCE_REMOVE;
 }
@@ -109,7 +108,7 @@ on_bus_acquired (GPasteBus *bus,
 {
     CallbackData *data = user_data;
 
-    register_bus_object (bus, G_PASTE_BUS_OBJECT (data->daemon), data->gapp);
+    register_bus_object (bus, G_PASTE_BUS_OBJECT (data->daemon), data);
 
     g_source_set_name_by_id (g_idle_add (register_search_provider, user_data), "[GPaste] register_search_provider");
 }
@@ -138,7 +137,7 @@ main (gint argc, gchar *argv[])
         [C_NAME_LOST] = g_signal_connect (bus,
                                           "name-lost",
                                           G_CALLBACK (on_name_lost),
-                                          gapp),
+                                          data),
         [C_REEXECUTE_SELF] = g_signal_connect (g_paste_daemon,
                                                "reexecute-self",
                                                G_CALLBACK (reexec),
@@ -149,9 +148,7 @@ main (gint argc, gchar *argv[])
     g_source_set_name_by_id (g_unix_signal_add (SIGTERM, signal_handler, app), "[GPaste] SIGTERM listener");
     g_source_set_name_by_id (g_unix_signal_add (SIGINT,  signal_handler, app), "[GPaste] SIGINT listener");
 
-    Usr1Data usr1_data = { g_paste_daemon, gapp };
-
-    g_source_set_name_by_id (g_unix_signal_add (SIGUSR1, usr1_handler, &usr1_data), "[GPaste] SIGUSR1 listener");
+    g_source_set_name_by_id (g_unix_signal_add (SIGUSR1, usr1_handler, g_paste_daemon), "[GPaste] SIGUSR1 listener");
 #endif
 
     g_paste_bus_own_name (bus);
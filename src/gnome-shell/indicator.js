@@ -277,9 +277,15 @@ class GPasteIndicator extends PanelMenu.Button {
                     const offset = this._pageSwitcher.getPageOffset();
                     const size = Math.min(realSize - offset, maxSize);
 
-                    this._history.slice(resetTextFrom, size).forEach(function(i, index) {
-                        i.setIndex(offset + resetTextFrom + index);
-                    });
+                    if (resetTextFrom < size) {
+                        this._client.get_elements_range(offset + resetTextFrom, size - resetTextFrom, (client, result) => {
+                            const items = client.get_elements_range_finish(result);
+
+                            this._history.slice(resetTextFrom, resetTextFrom + items.length).forEach(function(i, index) {
+                                i.setPreview(offset + resetTextFrom + index, items[index]);
+                            });
+                        });
+                    }
                     this._history.slice(size, maxSize).forEach(function(i, index) {
                         i.setIndex(-1);
                     });
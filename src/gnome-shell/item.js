@@ -74,6 +74,14 @@ class GPasteItem extends PopupMenu.PopupMenuItem {
         }
     }
 
+    setPreview(index, item) {
+        const oldIndex = this._index;
+        this._index = index;
+        this._fakeIndex = false;
+        this._uuid = item.get_uuid();
+        this._setValue(item.get_value(), oldIndex);
+    }
+
     setUuid(uuid) {
         const oldIndex = this._index;
         this._index = -2;
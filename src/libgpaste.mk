@@ -4,22 +4,26 @@
 
 libgpaste_la_file = lib/libgpaste.la
 
-lib_libgpaste_la_private_headers =          \
-	%D%/libgpaste/gpaste-gdbus-macros.h \
-	%D%/libgpaste/gpaste-gtk-compat.h   \
+lib_libgpaste_la_private_headers =                 \
+	%D%/libgpaste/gpaste-gdbus-macros.h        \
+	%D%/libgpaste/gpaste-gtk-compat.h          \
+	%D%/libgpaste/client/gpaste-client-cache.h \
 	$(NULL)
 
-lib_libgpaste_la_misc_headers =               \
-	%D%/libgpaste/gpaste-gdbus-defines.h  \
-	%D%/libgpaste/gpaste-gsettings-keys.h \
-	%D%/libgpaste/gpaste-macros.h         \
-	%D%/libgpaste/util/gpaste-util.h      \
+lib_libgpaste_la_misc_headers =                  \
+	%D%/libgpaste/gpaste-gdbus-defines.h     \
+	%D%/libgpaste/gpaste-gsettings-keys.h    \
+	%D%/libgpaste/gpaste-macros.h            \
+	%D%/libgpaste/util/gpaste-replacer.h     \
+	%D%/libgpaste/util/gpaste-search-index.h \
+	%D%/libgpaste/util/gpaste-util.h         \
 	$(NULL)
 
 lib_libgpaste_la_public_headers =                                             \
 	%D%/libgpaste/gpaste.h                                                \
 	%D%/libgpaste/client/gpaste-client.h                                  \
 	%D%/libgpaste/client/gpaste-client-item.h                             \
+	%D%/libgpaste/core/gpaste-change-enums.h                              \
 	%D%/libgpaste/core/gpaste-clipboard.h                                 \
 	%D%/libgpaste/core/gpaste-clipboards-manager.h                        \
 	%D%/libgpaste/core/gpaste-history.h                                   \
@@ -28,6 +32,7 @@ lib_libgpaste_la_public_headers =                                             \
 	%D%/libgpaste/core/gpaste-password-item.h                             \
 	%D%/libgpaste/core/gpaste-text-item.h                                 \
 	%D%/libgpaste/core/gpaste-item-enums.h                                \
+	%D%/libgpaste/core/gpaste-search-enums.h                              \
 	%D%/libgpaste/core/gpaste-special-atom.h                              \
 	%D%/libgpaste/core/gpaste-update-enums.h                              \
 	%D%/libgpaste/core/gpaste-uris-item.h                                 \
@@ -36,7 +41,11 @@ lib_libgpaste_la_public_headers =                                             \
 	%D%/libgpaste/daemon/gpaste-daemon.h                                  \
 	%D%/libgpaste/daemon/gpaste-search-provider.h                         \
 	%D%/libgpaste/gnome-shell-client/gpaste-gnome-shell-client.h          \
+	%D%/libgpaste/io/gpaste-binary-backend.h                              \
 	%D%/libgpaste/io/gpaste-file-backend.h                                \
+	%D%/libgpaste/io/gpaste-history-catalog.h                             \
+	%D%/libgpaste/io/gpaste-history-index.h                               \
+	%D%/libgpaste/io/gpaste-journal-backend.h                             \
 	%D%/libgpaste/io/gpaste-storage-backend.h                             \
 	%D%/libgpaste/keybinder/gpaste-keybinder.h                            \
 	%D%/libgpaste/keybinder/gpaste-keybinding.h                           \
@@ -56,7 +65,9 @@ lib_libgpaste_la_public_headers =                                             \
 
 lib_libgpaste_la_source_files =                                               \
 	%D%/libgpaste/client/gpaste-client.c                                  \
+	%D%/libgpaste/client/gpaste-client-cache.c                            \
 	%D%/libgpaste/client/gpaste-client-item.c                             \
+	%D%/libgpaste/core/gpaste-change-enums.c                              \
 	%D%/libgpaste/core/gpaste-clipboard.c                                 \
 	%D%/libgpaste/core/gpaste-clipboards-manager.c                        \
 	%D%/libgpaste/core/gpaste-history.c                                   \
@@ -65,6 +76,7 @@ lib_libgpaste_la_source_files =                                               \
 	%D%/libgpaste/core/gpaste-password-item.c                             \
 	%D%/libgpaste/core/gpaste-text-item.c                                 \
 	%D%/libgpaste/core/gpaste-item-enums.c                                \
+	%D%/libgpaste/core/gpaste-search-enums.c                              \
 	%D%/libgpaste/core/gpaste-special-atom.c                              \
 	%D%/libgpaste/core/gpaste-update-enums.c                              \
 	%D%/libgpaste/core/gpaste-uris-item.c                                 \
@@ -73,7 +85,11 @@ lib_libgpaste_la_source_files =                                               \
 	%D%/libgpaste/daemon/gpaste-daemon.c                                  \
 	%D%/libgpaste/daemon/gpaste-search-provider.c                         \
 	%D%/libgpaste/gnome-shell-client/gpaste-gnome-shell-client.c          \
+	%D%/libgpaste/io/gpaste-binary-backend.c                              \
 	%D%/libgpaste/io/gpaste-file-backend.c                                \
+	%D%/libgpaste/io/gpaste-history-catalog.c                             \
+	%D%/libgpaste/io/gpaste-history-index.c                               \
+	%D%/libgpaste/io/gpaste-journal-backend.c                             \
 	%D%/libgpaste/io/gpaste-storage-backend.c                             \
 	%D%/libgpaste/keybinder/gpaste-keybinder.c                            \
 	%D%/libgpaste/keybinder/gpaste-keybinding.c                           \
@@ -89,6 +105,8 @@ lib_libgpaste_la_source_files =                                               \
 	%D%/libgpaste/settings-ui/gpaste-settings-ui-panel.c                  \
 	%D%/libgpaste/settings-ui/gpaste-settings-ui-stack.c                  \
 	%D%/libgpaste/settings-ui/gpaste-settings-ui-widget.c                 \
+	%D%/libgpaste/util/gpaste-replacer.c                                  \
+	%D%/libgpaste/util/gpaste-search-index.c                              \
 	%D%/libgpaste/util/gpaste-util.c                                      \
 	$(NULL)
 
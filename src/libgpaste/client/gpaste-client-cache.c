@@ -0,0 +1,386 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-change-enums.h>
+
+#include "gpaste-client-cache.h"
+
+/*
+ * A mirror of the history of the daemon, filled lazily as items are fetched
+ * and kept current by applying the changes announced by the daemon.
+ *
+ * Items are keyed by uuid, an entry existing only while we know its item to
+ * be in the history. Their positions are tracked separately, NULL meaning
+ * that we don't know which item is there yet. Once it missed some changes,
+ * the cache is invalid and stays empty until it gets a RESET.
+ */
+
+struct _GPasteClientCache
+{
+    GHashTable *items;
+    GPtrArray  *positions;
+    guint64     seq;
+    gboolean    valid;
+};
+
+typedef struct
+{
+    gchar         *value;
+    GPasteItemKind kind;
+} GPasteClientCacheEntry;
+
+static void
+g_paste_client_cache_entry_free (gpointer data)
+{
+    GPasteClientCacheEntry *entry = data;
+
+    g_free (entry->value);
+    g_free (entry);
+}
+
+static GPasteClientCacheEntry *
+g_paste_client_cache_ensure_entry (GPasteClientCache *self,
+                                   const gchar       *uuid)
+{
+    GPasteClientCacheEntry *entry = g_hash_table_lookup (self->items, uuid);
+
+    if (!entry)
+    {
+        entry = g_new0 (GPasteClientCacheEntry, 1);
+        entry->kind = G_PASTE_ITEM_KIND_INVALID;
+        g_hash_table_insert (self->items, g_strdup (uuid), entry);
+    }
+
+    return entry;
+}
+
+static gint
+g_paste_client_cache_get_enum_value (GType        type,
+                                     const gchar *nick,
+                                     gint         fallback)
+{
+    GEnumClass *klass = g_type_class_ref (type);
+    GEnumValue *v = g_enum_get_value_by_nick (klass, nick);
+    gint value = (v) ? v->value : fallback;
+
+    g_type_class_unref (klass);
+
+    return value;
+}
+
+static void
+g_paste_client_cache_reset (GPasteClientCache *self,
+                            guint64            length)
+{
+    g_hash_table_remove_all (self->items);
+    g_ptr_array_set_size (self->positions, 0);
+    g_ptr_array_set_size (self->positions, length);
+    self->valid = TRUE;
+}
+
+static gboolean
+g_paste_client_cache_apply_change (GPasteClientCache *self,
+                                   GPasteChangeKind   kind,
+                                   guint64            position,
+                                   guint64            old_position,
+                                   const gchar       *uuid,
+                                   const gchar       *item_kind)
+{
+    GPtrArray *positions = self->positions;
+    GPasteClientCacheEntry *entry;
+
+    if (kind == G_PASTE_CHANGE_KIND_RESET)
+    {
+        g_paste_client_cache_reset (self, position);
+        return TRUE;
+    }
+
+    if (!self->valid)
+        return FALSE;
+
+    switch (kind)
+    {
+    case G_PASTE_CHANGE_KIND_INSERT:
+        if (position > positions->len)
+            return FALSE;
+        g_ptr_array_insert (positions, position, g_strdup (uuid));
+        entry = g_paste_client_cache_ensure_entry (self, uuid);
+        /* The item may already be gone when the change is announced */
+        if (*item_kind)
+            entry->kind = g_paste_client_cache_get_enum_value (G_PASTE_TYPE_ITEM_KIND, item_kind, G_PASTE_ITEM_KIND_INVALID);
+        return TRUE;
+    case G_PASTE_CHANGE_KIND_REMOVE:
+        if (position >= positions->len)
+            return FALSE;
+        g_ptr_array_remove_index (positions, position);
+        g_hash_table_remove (self->items, uuid);
+        return TRUE;
+    case G_PASTE_CHANGE_KIND_MOVE:
+        if (old_position >= positions->len || position >= positions->len)
+            return FALSE;
+        g_free (g_ptr_array_steal_index (positions, old_position));
+        g_ptr_array_insert (positions, position, g_strdup (uuid));
+        return TRUE;
+    case G_PASTE_CHANGE_KIND_REPLACE:
+        if (position >= positions->len)
+            return FALSE;
+        g_free (positions->pdata[position]);
+        positions->pdata[position] = g_strdup (uuid);
+        entry = g_hash_table_lookup (self->items, uuid);
+        if (entry)
+            g_clear_pointer (&entry->value, g_free);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * g_paste_client_cache_apply_changes:
+ * @self: a #GPasteClientCache
+ * @seq: the sequence number of the history after the changes
+ * @changes: the "a(sttsss)" changes announced by the daemon
+ *
+ * Apply the changes that led the history to @seq
+ *
+ * Returns: whether the cache is still valid
+ */
+gboolean
+g_paste_client_cache_apply_changes (GPasteClientCache *self,
+                                    guint64            seq,
+                                    GVariant          *changes)
+{
+    g_return_val_if_fail (self, FALSE);
+    g_return_val_if_fail (g_variant_is_of_type (changes, G_VARIANT_TYPE ("a(sttsss)")), FALSE);
+
+    GVariantIter iter;
+    const gchar *kind, *uuid, *item_kind, *preview;
+    guint64 position, old_position;
+
+    g_variant_iter_init (&iter, changes);
+    while (g_variant_iter_next (&iter, "(&stt&s&s&s)", &kind, &position, &old_position, &uuid, &item_kind, &preview))
+    {
+        GPasteChangeKind k = g_paste_client_cache_get_enum_value (G_PASTE_TYPE_CHANGE_KIND, kind, G_PASTE_CHANGE_KIND_INVALID);
+
+        if (!g_paste_client_cache_apply_change (self, k, position, old_position, uuid, item_kind))
+        {
+            g_paste_client_cache_invalidate (self);
+            break;
+        }
+    }
+
+    self->seq = seq;
+
+    return self->valid;
+}
+
+/*
+ * g_paste_client_cache_invalidate:
+ * @self: a #GPasteClientCache
+ *
+ * Forget everything until the next RESET
+ */
+void
+g_paste_client_cache_invalidate (GPasteClientCache *self)
+{
+    g_return_if_fail (self);
+
+    g_hash_table_remove_all (self->items);
+    g_ptr_array_set_size (self->positions, 0);
+    self->valid = FALSE;
+}
+
+/*
+ * g_paste_client_cache_is_valid:
+ * @self: a #GPasteClientCache
+ *
+ * Returns: whether the cache can be trusted
+ */
+gboolean
+g_paste_client_cache_is_valid (const GPasteClientCache *self)
+{
+    g_return_val_if_fail (self, FALSE);
+
+    return self->valid;
+}
+
+/*
+ * g_paste_client_cache_get_seq:
+ * @self: a #GPasteClientCache
+ *
+ * Returns: the sequence number of the last changes we applied
+ */
+guint64
+g_paste_client_cache_get_seq (const GPasteClientCache *self)
+{
+    g_return_val_if_fail (self, 0);
+
+    return self->seq;
+}
+
+/*
+ * g_paste_client_cache_get_value:
+ * @self: a #GPasteClientCache
+ * @uuid: the uuid of the item
+ *
+ * Returns: (nullable): the value of the item, if we know it
+ */
+const gchar *
+g_paste_client_cache_get_value (const GPasteClientCache *self,
+                                const gchar             *uuid)
+{
+    g_return_val_if_fail (self, NULL);
+    g_return_val_if_fail (uuid, NULL);
+
+    const GPasteClientCacheEntry *entry = g_hash_table_lookup (self->items, uuid);
+
+    return (entry) ? entry->value : NULL;
+}
+
+/*
+ * g_paste_client_cache_get_kind:
+ * @self: a #GPasteClientCache
+ * @uuid: the uuid of the item
+ *
+ * Returns: the kind of the item, or %G_PASTE_ITEM_KIND_INVALID if we don't know it
+ */
+GPasteItemKind
+g_paste_client_cache_get_kind (const GPasteClientCache *self,
+                               const gchar             *uuid)
+{
+    g_return_val_if_fail (self, G_PASTE_ITEM_KIND_INVALID);
+    g_return_val_if_fail (uuid, G_PASTE_ITEM_KIND_INVALID);
+
+    const GPasteClientCacheEntry *entry = g_hash_table_lookup (self->items, uuid);
+
+    return (entry) ? entry->kind : G_PASTE_ITEM_KIND_INVALID;
+}
+
+/*
+ * g_paste_client_cache_get_uuid_at:
+ * @self: a #GPasteClientCache
+ * @index: the index of the item
+ *
+ * Returns: (nullable): the uuid of the item at @index, if we know it
+ */
+const gchar *
+g_paste_client_cache_get_uuid_at (const GPasteClientCache *self,
+                                  guint64                  index)
+{
+    g_return_val_if_fail (self, NULL);
+
+    return (index < self->positions->len) ? self->positions->pdata[index] : NULL;
+}
+
+/*
+ * g_paste_client_cache_set_value:
+ * @self: a #GPasteClientCache
+ * @uuid: the uuid of the item
+ * @value: the value the daemon just gave us
+ *
+ * Remember the value of an item, which must be in the history
+ */
+void
+g_paste_client_cache_set_value (GPasteClientCache *self,
+                                const gchar       *uuid,
+                                const gchar       *value)
+{
+    g_return_if_fail (self);
+    g_return_if_fail (uuid);
+
+    if (!self->valid)
+        return;
+
+    GPasteClientCacheEntry *entry = g_paste_client_cache_ensure_entry (self, uuid);
+
+    g_free (entry->value);
+    entry->value = g_strdup (value);
+}
+
+/*
+ * g_paste_client_cache_set_kind:
+ * @self: a #GPasteClientCache
+ * @uuid: the uuid of the item
+ * @kind: the kind the daemon just gave us
+ *
+ * Remember the kind of an item, which must be in the history
+ */
+void
+g_paste_client_cache_set_kind (GPasteClientCache *self,
+                               const gchar       *uuid,
+                               GPasteItemKind     kind)
+{
+    g_return_if_fail (self);
+    g_return_if_fail (uuid);
+
+    if (!self->valid)
+        return;
+
+    g_paste_client_cache_ensure_entry (self, uuid)->kind = kind;
+}
+
+/*
+ * g_paste_client_cache_set_uuid_at:
+ * @self: a #GPasteClientCache
+ * @index: the index of the item
+ * @uuid: the uuid the daemon just gave us
+ *
+ * Remember which item is at @index
+ */
+void
+g_paste_client_cache_set_uuid_at (GPasteClientCache *self,
+                                  guint64            index,
+                                  const gchar       *uuid)
+{
+    g_return_if_fail (self);
+    g_return_if_fail (uuid);
+
+    GPtrArray *positions = self->positions;
+
+    if (!self->valid || index >= positions->len)
+        return;
+
+    g_free (positions->pdata[index]);
+    positions->pdata[index] = g_strdup (uuid);
+    g_paste_client_cache_ensure_entry (self, uuid);
+}
+
+/*
+ * g_paste_client_cache_free:
+ * @self: a #GPasteClientCache
+ *
+ * Free the cache
+ */
+void
+g_paste_client_cache_free (GPasteClientCache *self)
+{
+    g_return_if_fail (self);
+
+    g_hash_table_unref (self->items);
+    g_ptr_array_unref (self->positions);
+    g_free (self);
+}
+
+/*
+ * g_paste_client_cache_new:
+ *
+ * Create a new, invalid, cache
+ *
+ * Returns: a newly allocated #GPasteClientCache
+ *          free it with g_paste_client_cache_free
+ */
+GPasteClientCache *
+g_paste_client_cache_new (void)
+{
+    GPasteClientCache *self = g_new (GPasteClientCache, 1);
+
+    self->items = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_paste_client_cache_entry_free);
+    self->positions = g_ptr_array_new_with_free_func (g_free);
+    self->seq = 0;
+    self->valid = FALSE;
+
+    return self;
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_CLIENT_CACHE_H__
+#define __G_PASTE_CLIENT_CACHE_H__
+
+#include <gpaste-item-enums.h>
+#include <gpaste-macros.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GPasteClientCache GPasteClientCache;
+
+GPasteClientCache *g_paste_client_cache_new           (void);
+void               g_paste_client_cache_free          (GPasteClientCache       *self);
+
+void               g_paste_client_cache_invalidate    (GPasteClientCache       *self);
+gboolean           g_paste_client_cache_is_valid      (const GPasteClientCache *self);
+guint64            g_paste_client_cache_get_seq       (const GPasteClientCache *self);
+gboolean           g_paste_client_cache_apply_changes (GPasteClientCache       *self,
+                                                       guint64                  seq,
+                                                       GVariant                *changes);
+
+const gchar       *g_paste_client_cache_get_value     (const GPasteClientCache *self,
+                                                       const gchar             *uuid);
+GPasteItemKind     g_paste_client_cache_get_kind      (const GPasteClientCache *self,
+                                                       const gchar             *uuid);
+const gchar       *g_paste_client_cache_get_uuid_at   (const GPasteClientCache *self,
+                                                       guint64                  index);
+
+void               g_paste_client_cache_set_value     (GPasteClientCache       *self,
+                                                       const gchar             *uuid,
+                                                       const gchar             *value);
+void               g_paste_client_cache_set_kind      (GPasteClientCache       *self,
+                                                       const gchar             *uuid,
+                                                       GPasteItemKind           kind);
+void               g_paste_client_cache_set_uuid_at   (GPasteClientCache       *self,
+                                                       guint64                  index,
+                                                       const gchar             *uuid);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_CLIENT_CACHE_H__*/
@@ -13,8 +13,9 @@ struct _GPasteClientItem
 
 typedef struct
 {
-    gchar *uuid;
-    gchar *value;
+    gchar         *uuid;
+    gchar         *value;
+    GPasteItemKind kind;
 } GPasteClientItemPrivate;
 
 G_PASTE_DEFINE_TYPE_WITH_PRIVATE (ClientItem, client_item, G_TYPE_OBJECT)
@@ -51,6 +52,23 @@ g_paste_client_item_get_value (const GPasteClientItem *self)
     return priv->value;
 }
 
+/**
+ * g_paste_client_item_get_kind:
+ * @self: a #GPasteClientItem instance
+ *
+ * Returns the kind of the item, or %G_PASTE_ITEM_KIND_INVALID
+ * if the daemon didn't tell us
+ */
+G_PASTE_VISIBLE GPasteItemKind
+g_paste_client_item_get_kind (const GPasteClientItem *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT_ITEM (self), G_PASTE_ITEM_KIND_INVALID);
+
+    const GPasteClientItemPrivate *priv = _g_paste_client_item_get_instance_private (self);
+
+    return priv->kind;
+}
+
 static void
 g_paste_client_item_finalize (GObject *object)
 {
@@ -96,3 +114,31 @@ g_paste_client_item_new (const gchar *uuid,
 
     return self;
 }
+
+/**
+ * g_paste_client_item_new_with_kind:
+ * @uuid: the uuid of the item
+ * @kind: the kind of the item
+ * @value: the value of the item
+ *
+ * Create a new instance of #GPasteClientItem knowing its kind
+ *
+ * Returns: (transfer full): a newly allocated #GPasteClientItem
+ *                           free it with g_object_unref
+ */
+G_PASTE_VISIBLE GPasteClientItem *
+g_paste_client_item_new_with_kind (const gchar   *uuid,
+                                   GPasteItemKind kind,
+                                   const gchar   *value)
+{
+    GPasteClientItem *self = g_paste_client_item_new (uuid, value);
+
+    if (self)
+    {
+        GPasteClientItemPrivate *priv = g_paste_client_item_get_instance_private (self);
+
+        priv->kind = kind;
+    }
+
+    return self;
+}
@@ -11,6 +11,7 @@
 #ifndef __G_PASTE_CLIENT_ITEM_H__
 #define __G_PASTE_CLIENT_ITEM_H__
 
+#include <gpaste-item-enums.h>
 #include <gpaste-macros.h>
 
 G_BEGIN_DECLS
@@ -19,11 +20,15 @@ G_BEGIN_DECLS
 
 G_PASTE_FINAL_TYPE (ClientItem, client_item, CLIENT_ITEM, GObject)
 
-const gchar *g_paste_client_item_get_uuid  (const GPasteClientItem *self);
-const gchar *g_paste_client_item_get_value (const GPasteClientItem *self);
+const gchar   *g_paste_client_item_get_uuid  (const GPasteClientItem *self);
+const gchar   *g_paste_client_item_get_value (const GPasteClientItem *self);
+GPasteItemKind g_paste_client_item_get_kind  (const GPasteClientItem *self);
 
-GPasteClientItem *g_paste_client_item_new (const gchar *uuid,
-                                           const gchar *value);
+GPasteClientItem *g_paste_client_item_new           (const gchar   *uuid,
+                                                     const gchar   *value);
+GPasteClientItem *g_paste_client_item_new_with_kind (const gchar   *uuid,
+                                                     GPasteItemKind kind,
+                                                     const gchar   *value);
 
 G_END_DECLS
 
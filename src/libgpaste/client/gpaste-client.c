@@ -5,18 +5,33 @@
  */
 
 #include "gpaste-gdbus-macros.h"
+#include "gpaste-client-cache.h"
 
 #include <gpaste-update-enums.h>
 
+#include <gio/gunixfdlist.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+
 struct _GPasteClient
 {
     GDBusProxy parent_instance;
 };
 
-G_PASTE_DEFINE_TYPE (Client, client, G_TYPE_DBUS_PROXY)
+typedef struct
+{
+    GPasteClientCache *cache;
+    gboolean           syncing;
+
+    guint64            c_owner;
+} GPasteClientPrivate;
+
+G_PASTE_DEFINE_TYPE_WITH_PRIVATE (Client, client, G_TYPE_DBUS_PROXY)
 
 enum
 {
+    CHANGED,
     DELETE_HISTORY,
     EMPTY_HISTORY,
     SHOW_HISTORY,
@@ -48,6 +63,9 @@ static guint64 signals[LAST_SIGNAL] = { 0 };
 #define DBUS_CALL_THREE_PARAMS_ASYNC(method, params) \
     DBUS_CALL_THREE_PARAMS_ASYNC_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
 
+#define DBUS_CALL_FOUR_PARAMS_ASYNC(method, params) \
+    DBUS_CALL_FOUR_PARAMS_ASYNC_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
+
 /****************************/
 /* Methods / Async - Finish */
 /****************************/
@@ -67,9 +85,18 @@ static guint64 signals[LAST_SIGNAL] = { 0 };
 #define DBUS_ASYNC_FINISH_RET_ITEMS \
     DBUS_ASYNC_FINISH_RET_ITEMS_BASE (CLIENT)
 
+#define DBUS_ASYNC_FINISH_RET_HISTORY_MATCHES \
+    DBUS_ASYNC_FINISH_RET_HISTORY_MATCHES_BASE (CLIENT)
+
+#define DBUS_ASYNC_FINISH_RET_PREVIEWS \
+    DBUS_ASYNC_FINISH_RET_PREVIEWS_BASE (CLIENT)
+
 #define DBUS_ASYNC_FINISH_RET_UINT64 \
     DBUS_ASYNC_FINISH_RET_UINT64_BASE (CLIENT)
 
+#define DBUS_ASYNC_FINISH_RET_CHANGES(seq) \
+    DBUS_ASYNC_FINISH_RET_CHANGES_BASE (CLIENT, seq)
+
 /******************/
 /* Methods / Sync */
 /******************/
@@ -101,15 +128,36 @@ static guint64 signals[LAST_SIGNAL] = { 0 };
 #define DBUS_CALL_ONE_PARAM_RET_ITEM(method, param_type, param_name) \
     DBUS_CALL_ONE_PARAM_RET_ITEM_BASE (CLIENT, param_type, param_name, G_PASTE_DAEMON_##method)
 
+#define DBUS_CALL_ONE_PARAM_RET_HISTORY_MATCHES(method, param_type, param_name) \
+    DBUS_CALL_ONE_PARAM_RET_HISTORY_MATCHES_BASE (CLIENT, param_type, param_name, G_PASTE_DAEMON_##method)
+
+#define DBUS_CALL_ONE_PARAM_RET_CHANGES(method, param_type, param_name, seq) \
+    DBUS_CALL_ONE_PARAM_RET_CHANGES_BASE (CLIENT, param_type, param_name, G_PASTE_DAEMON_##method, seq)
+
+#define DBUS_CALL_ONE_PARAMV_NO_RETURN(method, paramv) \
+    DBUS_CALL_ONE_PARAMV_NO_RETURN_BASE (CLIENT, paramv, G_PASTE_DAEMON_##method)
+
 #define DBUS_CALL_ONE_PARAMV_RET_ITEMS(method, paramv) \
     DBUS_CALL_ONE_PARAMV_RET_ITEMS_BASE (CLIENT, G_PASTE_DAEMON_##method, paramv)
 
 #define DBUS_CALL_TWO_PARAMS_NO_RETURN(method, params) \
     DBUS_CALL_TWO_PARAMS_NO_RETURN_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
 
+#define DBUS_CALL_TWO_PARAMS_RET_STRV(method, params) \
+    DBUS_CALL_TWO_PARAMS_RET_STRV_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
+
+#define DBUS_CALL_TWO_PARAMS_RET_PREVIEWS(method, params) \
+    DBUS_CALL_TWO_PARAMS_RET_PREVIEWS_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
+
 #define DBUS_CALL_THREE_PARAMS_NO_RETURN(method, params) \
     DBUS_CALL_THREE_PARAMS_NO_RETURN_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
 
+#define DBUS_CALL_FOUR_PARAMS_RET_STRV(method, params) \
+    DBUS_CALL_FOUR_PARAMS_RET_STRV_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
+
+#define DBUS_CALL_FOUR_PARAMS_RET_PREVIEWS(method, params) \
+    DBUS_CALL_FOUR_PARAMS_RET_PREVIEWS_BASE (CLIENT, params, G_PASTE_DAEMON_##method)
+
 /**************/
 /* Properties */
 /**************/
@@ -179,6 +227,415 @@ static guint64 signals[LAST_SIGNAL] = { 0 };
                   1,                               \
                   G_TYPE_##type)
 
+/*********/
+/* Cache */
+/*********/
+
+typedef struct
+{
+    gchar  *uuid;
+    guint64 index;
+    guint64 seq;
+} GPasteClientLookup;
+
+static void
+g_paste_client_lookup_free (gpointer data)
+{
+    GPasteClientLookup *lookup = data;
+
+    g_free (lookup->uuid);
+    g_free (lookup);
+}
+
+static GPasteItemKind
+g_paste_client_get_item_kind (const gchar *kind)
+{
+    GEnumValue *k = (kind) ? g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_ITEM_KIND), kind) : NULL;
+
+    return (k) ? (GPasteItemKind) k->value : G_PASTE_ITEM_KIND_INVALID;
+}
+
+/* The cache, if it is enabled and up to date */
+static GPasteClientCache *
+g_paste_client_private_get_cache (const GPasteClientPrivate *priv)
+{
+    if (!priv->cache || priv->syncing || !g_paste_client_cache_is_valid (priv->cache))
+        return NULL;
+
+    return priv->cache;
+}
+
+/* The cache, if nothing changed since we started looking for something */
+static GPasteClientCache *
+g_paste_client_private_get_cache_for_lookup (const GPasteClientPrivate *priv,
+                                             const GPasteClientLookup  *lookup)
+{
+    GPasteClientCache *cache = g_paste_client_private_get_cache (priv);
+
+    return (cache && g_paste_client_cache_get_seq (cache) == lookup->seq) ? cache : NULL;
+}
+
+static GTask *
+g_paste_client_lookup_new (GPasteClient       *self,
+                           gpointer            source_tag,
+                           const gchar        *uuid,
+                           guint64             index,
+                           GAsyncReadyCallback callback,
+                           gpointer            user_data)
+{
+    const GPasteClientPrivate *priv = _g_paste_client_get_instance_private (self);
+    GPasteClientLookup *lookup = g_new (GPasteClientLookup, 1);
+    GTask *task = g_task_new (self, NULL, callback, user_data);
+
+    lookup->uuid = g_strdup (uuid);
+    lookup->index = index;
+    lookup->seq = g_paste_client_cache_get_seq (priv->cache);
+
+    g_task_set_source_tag (task, source_tag);
+    g_task_set_task_data (task, lookup, g_paste_client_lookup_free);
+
+    return task;
+}
+
+static void g_paste_client_sync_cache (GPasteClient *self);
+
+static void
+g_paste_client_on_cache_synced (GObject      *source_object,
+                                GAsyncResult *res,
+                                gpointer      user_data G_GNUC_UNUSED)
+{
+    GPasteClient *self = G_PASTE_CLIENT (source_object);
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+    g_autoptr (GError) error = NULL;
+    guint64 seq = 0;
+    g_autoptr (GVariant) changes = g_paste_client_get_changes_since_finish (self, res, &seq, &error);
+
+    /* The cache was disabled in the meantime */
+    if (!priv->cache)
+        return;
+
+    priv->syncing = FALSE;
+
+    if (!changes)
+    {
+        /* We'll try again when the daemon tells us about new changes or comes back */
+        g_debug ("client: failed to sync the cache: %s", error->message);
+        g_paste_client_cache_invalidate (priv->cache);
+    }
+    else if (!g_paste_client_cache_apply_changes (priv->cache, seq, changes))
+    {
+        g_paste_client_sync_cache (self);
+    }
+}
+
+static void
+g_paste_client_sync_cache (GPasteClient *self)
+{
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+    GPasteClientCache *cache = priv->cache;
+
+    if (priv->syncing)
+        return;
+
+    priv->syncing = TRUE;
+    /* Starting from 0 gets us a RESET, we then fetch the items lazily */
+    g_paste_client_get_changes_since (self,
+                                      (g_paste_client_cache_is_valid (cache)) ? g_paste_client_cache_get_seq (cache) : 0,
+                                      g_paste_client_on_cache_synced,
+                                      NULL); /* user_data */
+}
+
+static void
+g_paste_client_private_reset_cache (GPasteClient *self)
+{
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+
+    if (!priv->cache)
+        return;
+
+    g_paste_client_cache_invalidate (priv->cache);
+    g_paste_client_sync_cache (self);
+}
+
+static void
+g_paste_client_private_on_changed (GPasteClient *self,
+                                   guint64       seq,
+                                   GVariant     *changes)
+{
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+    GPasteClientCache *cache = priv->cache;
+
+    /* While syncing, the answer will include these changes */
+    if (!cache || priv->syncing)
+        return;
+
+    if (g_paste_client_cache_is_valid (cache))
+    {
+        guint64 cache_seq = g_paste_client_cache_get_seq (cache);
+
+        if (seq <= cache_seq)
+            return;
+        if (seq == cache_seq + 1 && g_paste_client_cache_apply_changes (cache, seq, changes))
+            return;
+    }
+
+    /* We missed some changes */
+    g_paste_client_sync_cache (self);
+}
+
+static void
+g_paste_client_on_name_owner_changed (GPasteClient *self,
+                                      GParamSpec   *pspec G_GNUC_UNUSED,
+                                      gpointer      user_data G_GNUC_UNUSED)
+{
+    g_autofree gchar *owner = g_dbus_proxy_get_name_owner (G_DBUS_PROXY (self));
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+
+    /* A new daemon has a new history */
+    g_paste_client_cache_invalidate (priv->cache);
+
+    if (owner)
+        g_paste_client_sync_cache (self);
+}
+
+static void
+g_paste_client_on_element_fetched (GObject      *source_object,
+                                   GAsyncResult *res,
+                                   gpointer      user_data)
+{
+    g_autoptr (GTask) task = user_data;
+    GPasteClient *self = G_PASTE_CLIENT (source_object);
+    GError *error = NULL;
+    g_autoptr (GVariant) result = g_dbus_proxy_call_finish (G_DBUS_PROXY (self), res, &error);
+
+    if (!result)
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    const GPasteClientLookup *lookup = g_task_get_task_data (task);
+    GPasteClientCache *cache = g_paste_client_private_get_cache_for_lookup (_g_paste_client_get_instance_private (self), lookup);
+    gchar *value;
+
+    g_variant_get (result, "(s)", &value);
+
+    if (cache)
+        g_paste_client_cache_set_value (cache, lookup->uuid, value);
+
+    g_task_return_pointer (task, value, g_free);
+}
+
+static void
+g_paste_client_on_element_at_index_fetched (GObject      *source_object,
+                                            GAsyncResult *res,
+                                            gpointer      user_data)
+{
+    g_autoptr (GTask) task = user_data;
+    GPasteClient *self = G_PASTE_CLIENT (source_object);
+    GError *error = NULL;
+    g_autoptr (GVariant) result = g_dbus_proxy_call_finish (G_DBUS_PROXY (self), res, &error);
+
+    if (!result)
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    const GPasteClientLookup *lookup = g_task_get_task_data (task);
+    GPasteClientCache *cache = g_paste_client_private_get_cache_for_lookup (_g_paste_client_get_instance_private (self), lookup);
+    const gchar *uuid, *value;
+
+    g_variant_get (result, "(&s&s)", &uuid, &value);
+
+    if (cache)
+    {
+        g_paste_client_cache_set_uuid_at (cache, lookup->index, uuid);
+        g_paste_client_cache_set_value (cache, uuid, value);
+    }
+
+    g_task_return_pointer (task, g_paste_client_item_new (uuid, value), g_object_unref);
+}
+
+static void
+g_paste_client_on_element_kind_fetched (GObject      *source_object,
+                                        GAsyncResult *res,
+                                        gpointer      user_data)
+{
+    g_autoptr (GTask) task = user_data;
+    GPasteClient *self = G_PASTE_CLIENT (source_object);
+    GError *error = NULL;
+    g_autoptr (GVariant) result = g_dbus_proxy_call_finish (G_DBUS_PROXY (self), res, &error);
+
+    if (!result)
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    const GPasteClientLookup *lookup = g_task_get_task_data (task);
+    GPasteClientCache *cache = g_paste_client_private_get_cache_for_lookup (_g_paste_client_get_instance_private (self), lookup);
+    const gchar *nick;
+
+    g_variant_get (result, "(&s)", &nick);
+
+    GPasteItemKind kind = g_paste_client_get_item_kind (nick);
+
+    if (cache && kind != G_PASTE_ITEM_KIND_INVALID)
+        g_paste_client_cache_set_kind (cache, lookup->uuid, kind);
+
+    g_task_return_int (task, kind);
+}
+
+/******************************/
+/* Methods / File descriptors */
+/******************************/
+
+/*
+ * Big contents don't go through the bus but through a sealed memfd, which
+ * travels along with the message and is then read or mapped on the other side.
+ */
+
+static GUnixFDList *
+g_paste_client_fd_list_new (const gchar *name,
+                            const gchar *text,
+                            GError     **error)
+{
+    gint fd = g_paste_util_memfd_new (name, text, strlen (text), error);
+
+    if (fd < 0)
+        return NULL;
+
+    return g_unix_fd_list_new_from_array (&fd, 1);
+}
+
+static GUnixFDList *
+g_paste_client_fd_list_new_from_fd (gint     fd,
+                                    GError **error)
+{
+    g_autoptr (GUnixFDList) fd_list = g_unix_fd_list_new ();
+
+    /* The fd gets duplicated, the caller still owns it */
+    if (g_unix_fd_list_append (fd_list, fd, error) < 0)
+        return NULL;
+
+    return g_steal_pointer (&fd_list);
+}
+
+static GBytes *
+g_paste_client_get_fd_result (GVariant    *result,
+                              GUnixFDList *fd_list,
+                              GError     **error)
+{
+    gint32 index;
+
+    g_variant_get (result, "(h)", &index);
+
+    if (!fd_list || index < 0 || index >= g_unix_fd_list_get_length (fd_list))
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "no file descriptor received");
+        return NULL;
+    }
+
+    gint fd = g_unix_fd_list_get (fd_list, index, error);
+
+    if (fd < 0)
+        return NULL;
+
+    GBytes *contents = g_paste_util_memfd_read (fd, G_MAXSIZE, error);
+
+    g_close (fd, NULL);
+
+    return contents;
+}
+
+static GList *
+g_paste_client_get_history_fd_result (GVariant    *result,
+                                      GUnixFDList *fd_list,
+                                      GError     **error)
+{
+    g_autoptr (GBytes) contents = g_paste_client_get_fd_result (result, fd_list, error);
+
+    if (!contents)
+        return NULL;
+
+    /* The daemon serialized the same "a(ss)" GetRawHistory answers with */
+    g_autoptr (GVariant) history = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE ("a(ss)"), contents, FALSE));
+
+    return g_paste_util_get_dbus_items_result (history);
+}
+
+/* @error is why we couldn't get @fd_list, if we couldn't */
+static void
+g_paste_client_call_with_fd (GPasteClient       *self,
+                             const gchar        *method,
+                             GVariant           *parameters,
+                             GUnixFDList        *fd_list,
+                             GError             *error,
+                             gpointer            source_tag,
+                             GAsyncReadyCallback callback,
+                             gpointer            user_data)
+{
+    if (!fd_list)
+    {
+        g_variant_unref (g_variant_ref_sink (parameters));
+        g_task_report_error (self, callback, user_data, source_tag, error);
+        return;
+    }
+
+    g_dbus_proxy_call_with_unix_fd_list (G_DBUS_PROXY (self),
+                                         method,
+                                         parameters,
+                                         G_DBUS_CALL_FLAGS_NONE,
+                                         -1,
+                                         fd_list,
+                                         NULL, /* cancellable */
+                                         callback,
+                                         user_data);
+}
+
+static void
+g_paste_client_call_with_fd_sync (GPasteClient *self,
+                                  const gchar  *method,
+                                  GVariant     *parameters,
+                                  GUnixFDList  *fd_list,
+                                  GError      **error)
+{
+    if (!fd_list)
+    {
+        g_variant_unref (g_variant_ref_sink (parameters));
+        return;
+    }
+
+    g_autoptr (GVariant) result = g_dbus_proxy_call_with_unix_fd_list_sync (G_DBUS_PROXY (self),
+                                                                            method,
+                                                                            parameters,
+                                                                            G_DBUS_CALL_FLAGS_NONE,
+                                                                            -1,
+                                                                            fd_list,
+                                                                            NULL, /* out_fd_list */
+                                                                            NULL, /* cancellable */
+                                                                            error);
+}
+
+static GVariant *
+g_paste_client_call_for_fd_sync (GPasteClient *self,
+                                 const gchar  *method,
+                                 GVariant     *parameters,
+                                 GUnixFDList **fd_list,
+                                 GError      **error)
+{
+    return g_dbus_proxy_call_with_unix_fd_list_sync (G_DBUS_PROXY (self),
+                                                     method,
+                                                     parameters,
+                                                     G_DBUS_CALL_FLAGS_NONE,
+                                                     -1,
+                                                     NULL, /* fd_list */
+                                                     fd_list,
+                                                     NULL, /* cancellable */
+                                                     error);
+}
+
 /******************/
 /* Methods / Sync */
 /******************/
@@ -213,6 +670,30 @@ g_paste_client_add_sync (GPasteClient *self,
     DBUS_CALL_ONE_PARAM_NO_RETURN (ADD, string, text);
 }
 
+/**
+ * g_paste_client_add_fd_sync:
+ * @self: a #GPasteClient instance
+ * @text: the text to add
+ * @error: a #GError
+ *
+ * Add an item to the #GPasteDaemon, passing it through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_fd_sync (GPasteClient *self,
+                            const gchar  *text,
+                            GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (text);
+    g_return_if_fail (!error || !(*error));
+
+    GVariant *parameter = g_variant_new_handle (0);
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new (G_PASTE_DAEMON_ADD_FD, text, error);
+
+    g_paste_client_call_with_fd_sync (self, G_PASTE_DAEMON_ADD_FD, g_variant_new_tuple (&parameter, 1), fd_list, error);
+}
+
 /**
  * g_paste_client_add_file_sync:
  * @self: a #GPasteClient instance
@@ -237,6 +718,51 @@ g_paste_client_add_file_sync (GPasteClient *self,
     DBUS_CALL_ONE_PARAM_NO_RETURN (ADD_FILE, string, ((absolute_path) ? absolute_path : file));
 }
 
+/**
+ * g_paste_client_add_from_fd_sync:
+ * @self: a #GPasteClient instance
+ * @fd: the file descriptor holding the text to add
+ * @error: a #GError
+ *
+ * Add an item to the #GPasteDaemon, which reads it straight from @fd.
+ * @fd must be a memfd, such as the ones g_paste_util_memfd_new_from_fd
+ * creates, or a regular file.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_from_fd_sync (GPasteClient *self,
+                                 gint          fd,
+                                 GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (fd >= 0);
+    g_return_if_fail (!error || !(*error));
+
+    GVariant *parameter = g_variant_new_handle (0);
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new_from_fd (fd, error);
+
+    g_paste_client_call_with_fd_sync (self, G_PASTE_DAEMON_ADD_FD, g_variant_new_tuple (&parameter, 1), fd_list, error);
+}
+
+/**
+ * g_paste_client_add_many_sync:
+ * @self: a #GPasteClient instance
+ * @texts: (array length=n_texts): the texts to add, the last one ending up in the clipboard
+ * @n_texts: the number of texts
+ * @error: a #GError
+ *
+ * Add several items to the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_many_sync (GPasteClient  *self,
+                              const gchar  **texts,
+                              guint64        n_texts,
+                              GError       **error)
+{
+    GVariant *param = g_variant_new_strv (texts, n_texts);
+    DBUS_CALL_ONE_PARAMV_NO_RETURN (ADD_MANY, param);
+}
+
 /**
  * g_paste_client_add_password_sync:
  * @self: a #GPasteClient instance
@@ -315,6 +841,27 @@ g_paste_client_delete_history_sync (GPasteClient *self,
     DBUS_CALL_ONE_PARAM_NO_RETURN (DELETE_HISTORY, string, name);
 }
 
+/**
+ * g_paste_client_delete_many_sync:
+ * @self: a #GPasteClient instance
+ * @uuids: (array length=n_uuids): the uuids of the elements we want to delete
+ * @n_uuids: the number of uuids
+ * @error: a #GError
+ *
+ * Delete several items from the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them.
+ * Nothing gets deleted if one of the uuids doesn't match any item.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_delete_many_sync (GPasteClient  *self,
+                                 const gchar  **uuids,
+                                 guint64        n_uuids,
+                                 GError       **error)
+{
+    GVariant *param = g_variant_new_strv (uuids, n_uuids);
+    DBUS_CALL_ONE_PARAMV_NO_RETURN (DELETE_MANY, param);
+}
+
 /**
  * g_paste_client_delete_password_sync:
  * @self: a #GPasteClient instance
@@ -347,6 +894,36 @@ g_paste_client_empty_history_sync (GPasteClient *self,
     DBUS_CALL_ONE_PARAM_NO_RETURN (EMPTY_HISTORY, string, name);
 }
 
+/**
+ * g_paste_client_get_changes_since_sync:
+ * @self: a #GPasteClient instance
+ * @seq: the last sequence number we know about
+ * @current_seq: (out) (optional): the current sequence number of the history
+ * @error: a #GError
+ *
+ * Get the changes which happened to the history after @seq, as
+ * an array of (kind, position, old position, uuid, item kind, preview),
+ * see the "changed" signal
+ *
+ * Returns: (transfer full): the "a(sttsss)" changes
+ */
+G_PASTE_VISIBLE GVariant *
+g_paste_client_get_changes_since_sync (GPasteClient *self,
+                                       guint64       seq,
+                                       guint64      *current_seq,
+                                       GError      **error)
+{
+    DBUS_CALL_ONE_PARAM_RET_CHANGES (GET_CHANGES_SINCE, uint64, seq, current_seq);
+}
+
+static gchar *
+_g_paste_client_get_element_sync (GPasteClient *self,
+                                  const gchar  *uuid,
+                                  GError      **error)
+{
+    DBUS_CALL_ONE_PARAM_RET_STRING (GET_ELEMENT, string, uuid);
+}
+
 /**
  * g_paste_client_get_element_sync:
  * @self: a #GPasteClient instance
@@ -362,7 +939,28 @@ g_paste_client_get_element_sync (GPasteClient *self,
                                  const gchar  *uuid,
                                  GError      **error)
 {
-    DBUS_CALL_ONE_PARAM_RET_STRING (GET_ELEMENT, string, uuid);
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+
+    GPasteClientCache *cache = g_paste_client_private_get_cache (_g_paste_client_get_instance_private (self));
+    const gchar *cached = (cache) ? g_paste_client_cache_get_value (cache, uuid) : NULL;
+
+    if (cached)
+        return g_strdup (cached);
+
+    gchar *value = _g_paste_client_get_element_sync (self, uuid, error);
+
+    if (cache && value)
+        g_paste_client_cache_set_value (cache, uuid, value);
+
+    return value;
+}
+
+static GPasteClientItem *
+_g_paste_client_get_element_at_index_sync (GPasteClient *self,
+                                           guint64       index,
+                                           GError      **error)
+{
+    DBUS_CALL_ONE_PARAM_RET_ITEM (GET_ELEMENT_AT_INDEX, uint64, index);
 }
 
 /**
@@ -380,7 +978,25 @@ g_paste_client_get_element_at_index_sync (GPasteClient *self,
                                           guint64       index,
                                           GError      **error)
 {
-    DBUS_CALL_ONE_PARAM_RET_ITEM (GET_ELEMENT_AT_INDEX, uint64, index);
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+
+    GPasteClientCache *cache = g_paste_client_private_get_cache (_g_paste_client_get_instance_private (self));
+    const gchar *uuid = (cache) ? g_paste_client_cache_get_uuid_at (cache, index) : NULL;
+    const gchar *cached = (uuid) ? g_paste_client_cache_get_value (cache, uuid) : NULL;
+
+    if (cached)
+        return g_paste_client_item_new_with_kind (uuid, g_paste_client_cache_get_kind (cache, uuid), cached);
+
+    GPasteClientItem *item = _g_paste_client_get_element_at_index_sync (self, index, error);
+
+    if (cache && item)
+    {
+        uuid = g_paste_client_item_get_uuid (item);
+        g_paste_client_cache_set_uuid_at (cache, index, uuid);
+        g_paste_client_cache_set_value (cache, uuid, g_paste_client_item_get_value (item));
+    }
+
+    return item;
 }
 
 static gchar *
@@ -406,10 +1022,22 @@ g_paste_client_get_element_kind_sync (GPasteClient *self,
                                       const gchar  *uuid,
                                       GError      **error)
 {
-    g_autofree gchar *kind = _g_paste_client_get_element_kind_sync (self, uuid, error);
-    GEnumValue *k = (kind) ? g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_ITEM_KIND), kind) : NULL;
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), G_PASTE_ITEM_KIND_INVALID);
+
+    GPasteClientCache *cache = g_paste_client_private_get_cache (_g_paste_client_get_instance_private (self));
+    GPasteItemKind kind = (cache) ? g_paste_client_cache_get_kind (cache, uuid) : G_PASTE_ITEM_KIND_INVALID;
+
+    if (kind != G_PASTE_ITEM_KIND_INVALID)
+        return kind;
+
+    g_autofree gchar *nick = _g_paste_client_get_element_kind_sync (self, uuid, error);
+
+    kind = g_paste_client_get_item_kind (nick);
+
+    if (cache && kind != G_PASTE_ITEM_KIND_INVALID)
+        g_paste_client_cache_set_kind (cache, uuid, kind);
 
-    return (k) ? k->value : G_PASTE_ITEM_KIND_INVALID;
+    return kind;
 }
 
 /**
@@ -433,6 +1061,33 @@ g_paste_client_get_elements_sync (GPasteClient  *self,
     DBUS_CALL_ONE_PARAMV_RET_ITEMS (GET_ELEMENTS, param);
 }
 
+/**
+ * g_paste_client_get_elements_range_sync:
+ * @self: a #GPasteClient instance
+ * @offset: the index of the first element we want to get
+ * @count: the number of elements we want to get
+ * @error: a #GError
+ *
+ * Get a page of items from the #GPasteDaemon, with their kind and
+ * their display string, bounded by the element-size setting.
+ * The page is cut short at the end of the history.
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_get_elements_range_sync (GPasteClient *self,
+                                        guint64       offset,
+                                        guint64       count,
+                                        GError      **error)
+{
+    GVariant *params[] = {
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (count)
+    };
+
+    DBUS_CALL_TWO_PARAMS_RET_PREVIEWS (GET_ELEMENTS_RANGE, params);
+}
+
 /**
  * g_paste_client_get_history_sync:
  * @self: a #GPasteClient instance
@@ -501,6 +1156,35 @@ g_paste_client_get_raw_element_sync (GPasteClient *self,
     DBUS_CALL_ONE_PARAM_RET_STRING (GET_RAW_ELEMENT, string, uuid);
 }
 
+/**
+ * g_paste_client_get_raw_element_fd_sync:
+ * @self: a #GPasteClient instance
+ * @uuid: the uuid of the element we want to get
+ * @error: a #GError
+ *
+ * Get an item from the #GPasteDaemon, through a memfd instead of the bus
+ *
+ * Returns: (transfer full): the contents of the item, not nul-terminated
+ */
+G_PASTE_VISIBLE GBytes *
+g_paste_client_get_raw_element_fd_sync (GPasteClient *self,
+                                        const gchar  *uuid,
+                                        GError      **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+    g_return_val_if_fail (uuid, NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    GVariant *parameter = g_variant_new_string (uuid);
+    g_autoptr (GUnixFDList) fd_list = NULL;
+    g_autoptr (GVariant) result = g_paste_client_call_for_fd_sync (self, G_PASTE_DAEMON_GET_RAW_ELEMENT_FD, g_variant_new_tuple (&parameter, 1), &fd_list, error);
+
+    if (!result)
+        return NULL;
+
+    return g_paste_client_get_fd_result (result, fd_list, error);
+}
+
 /**
  * g_paste_client_get_raw_history_sync:
  * @self: a #GPasteClient instance
@@ -517,6 +1201,31 @@ g_paste_client_get_raw_history_sync (GPasteClient *self,
     DBUS_CALL_NO_PARAM_RET_ITEMS (GET_RAW_HISTORY);
 }
 
+/**
+ * g_paste_client_get_raw_history_fd_sync:
+ * @self: a #GPasteClient instance
+ * @error: a #GError
+ *
+ * Get the history from the #GPasteDaemon, through a memfd instead of the bus
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): a newly allocated array of string
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_get_raw_history_fd_sync (GPasteClient *self,
+                                        GError      **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    g_autoptr (GUnixFDList) fd_list = NULL;
+    g_autoptr (GVariant) result = g_paste_client_call_for_fd_sync (self, G_PASTE_DAEMON_GET_RAW_HISTORY_FD, g_variant_new_tuple (NULL, 0), &fd_list, error);
+
+    if (!result)
+        return NULL;
+
+    return g_paste_client_get_history_fd_result (result, fd_list, error);
+}
+
 /**
  * g_paste_client_list_histories_sync:
  * @self: a #GPasteClient instance
@@ -624,38 +1333,183 @@ g_paste_client_rename_password_sync (GPasteClient *self,
  * @contents: the replacement contents
  * @error: a #GError
  *
- * Replace the contents of an item
+ * Replace the contents of an item
+ */
+G_PASTE_VISIBLE void
+g_paste_client_replace_sync (GPasteClient *self,
+                             const gchar  *uuid,
+                             const gchar  *contents,
+                             GError      **error)
+{
+    GVariant *params[] = {
+        g_variant_new_string (uuid),
+        g_variant_new_string (contents)
+    };
+
+    DBUS_CALL_TWO_PARAMS_NO_RETURN (REPLACE, params);
+}
+
+/**
+ * g_paste_client_replace_fd_sync:
+ * @self: a #GPasteClient instance
+ * @uuid: the uuid of the element we want to replace
+ * @contents: the replacement contents
+ * @error: a #GError
+ *
+ * Replace the contents of an item, passing them through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_replace_fd_sync (GPasteClient *self,
+                                const gchar  *uuid,
+                                const gchar  *contents,
+                                GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (uuid);
+    g_return_if_fail (contents);
+    g_return_if_fail (!error || !(*error));
+
+    GVariant *params[] = {
+        g_variant_new_string (uuid),
+        g_variant_new_handle (0)
+    };
+
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new (G_PASTE_DAEMON_REPLACE_FD, contents, error);
+
+    g_paste_client_call_with_fd_sync (self, G_PASTE_DAEMON_REPLACE_FD, g_variant_new_tuple (params, 2), fd_list, error);
+}
+
+/**
+ * g_paste_client_search_sync:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in history
+ *
+ * Returns: (transfer full): The uuids of the matching items
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_client_search_sync (GPasteClient *self,
+                            const gchar  *pattern,
+                            GError      **error)
+{
+    DBUS_CALL_ONE_PARAM_RET_STRV (SEARCH, string, pattern);
+}
+
+/**
+ * g_paste_client_search_all_histories_sync:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in histories
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in all the histories,
+ * without having the daemon load them
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The matching items,
+ *          the value of each one being the name of its history
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_search_all_histories_sync (GPasteClient *self,
+                                          const gchar  *pattern,
+                                          GError      **error)
+{
+    DBUS_CALL_ONE_PARAM_RET_HISTORY_MATCHES (SEARCH_ALL_HISTORIES, string, pattern);
+}
+
+/**
+ * g_paste_client_search_previews_sync:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @mode: how to match @pattern
+ * @offset: the number of matching items to skip
+ * @limit: the maximum number of items to return, 0 for no limit
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in history, getting their kind
+ * and a preview of their contents, bounded by the element-size setting,
+ * along with their uuids
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The matching items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_search_previews_sync (GPasteClient    *self,
+                                     const gchar     *pattern,
+                                     GPasteSearchMode mode,
+                                     guint64          offset,
+                                     guint64          limit,
+                                     GError         **error)
+{
+    GVariant *params[] = {
+        g_variant_new_string (pattern),
+        g_variant_new_string (g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SEARCH_MODE), mode)->value_nick),
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (limit)
+    };
+
+    DBUS_CALL_FOUR_PARAMS_RET_PREVIEWS (SEARCH_PREVIEWS, params);
+}
+
+/**
+ * g_paste_client_search_with_options_sync:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @mode: how to match @pattern
+ * @offset: the number of matching items to skip
+ * @limit: the maximum number of items to return, 0 for no limit
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in history, as a plain text,
+ * a regex or a fuzzy subsequence depending on @mode
+ *
+ * Returns: (transfer full): The uuids of the matching items
  */
-G_PASTE_VISIBLE void
-g_paste_client_replace_sync (GPasteClient *self,
-                             const gchar  *uuid,
-                             const gchar  *contents,
-                             GError      **error)
+G_PASTE_VISIBLE GStrv
+g_paste_client_search_with_options_sync (GPasteClient    *self,
+                                         const gchar     *pattern,
+                                         GPasteSearchMode mode,
+                                         guint64          offset,
+                                         guint64          limit,
+                                         GError         **error)
 {
     GVariant *params[] = {
-        g_variant_new_string (uuid),
-        g_variant_new_string (contents)
+        g_variant_new_string (pattern),
+        g_variant_new_string (g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SEARCH_MODE), mode)->value_nick),
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (limit)
     };
 
-    DBUS_CALL_TWO_PARAMS_NO_RETURN (REPLACE, params);
+    DBUS_CALL_FOUR_PARAMS_RET_STRV (SEARCH_WITH_OPTIONS, params);
 }
 
 /**
- * g_paste_client_search_sync:
+ * g_paste_client_search_within_sync:
  * @self: a #GPasteClient instance
  * @pattern: the pattern to look for in history
+ * @uuids: (array length=n_uuids): the uuids of the items to search in
+ * @n_uuids: the number of uuids
  * @error: a #GError
  *
- * Search for items matching @pattern in history
+ * Search for items matching @pattern among @uuids, typically
+ * the results of a previous search for a less specific pattern,
+ * plus the items @pattern designates by uuid or password name
  *
  * Returns: (transfer full): The uuids of the matching items
  */
 G_PASTE_VISIBLE GStrv
-g_paste_client_search_sync (GPasteClient *self,
-                            const gchar  *pattern,
-                            GError      **error)
+g_paste_client_search_within_sync (GPasteClient *self,
+                                   const gchar  *pattern,
+                                   const gchar **uuids,
+                                   guint64       n_uuids,
+                                   GError      **error)
 {
-    DBUS_CALL_ONE_PARAM_RET_STRV (SEARCH, string, pattern);
+    GVariant *params[] = {
+        g_variant_new_string (pattern),
+        g_variant_new_strv (uuids, n_uuids)
+    };
+
+    DBUS_CALL_TWO_PARAMS_RET_STRV (SEARCH_WITHIN, params);
 }
 
 /**
@@ -798,6 +1652,33 @@ g_paste_client_add (GPasteClient       *self,
     DBUS_CALL_ONE_PARAM_ASYNC (ADD, string, text);
 }
 
+/**
+ * g_paste_client_add_fd:
+ * @self: a #GPasteClient instance
+ * @text: the text to add
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Add an item to the #GPasteDaemon, passing it through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_fd (GPasteClient       *self,
+                       const gchar        *text,
+                       GAsyncReadyCallback callback,
+                       gpointer            user_data)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (text);
+
+    GVariant *parameter = g_variant_new_handle (0);
+    GError *error = NULL;
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new (G_PASTE_DAEMON_ADD_FD, text, &error);
+
+    g_paste_client_call_with_fd (self, G_PASTE_DAEMON_ADD_FD, g_variant_new_tuple (&parameter, 1), fd_list, error, g_paste_client_add_fd, callback, user_data);
+}
+
 /**
  * g_paste_client_add_file:
  * @self: a #GPasteClient instance
@@ -825,6 +1706,57 @@ g_paste_client_add_file (GPasteClient       *self,
     DBUS_CALL_ONE_PARAM_ASYNC (ADD_FILE, string, ((absolute_path) ? absolute_path : file));
 }
 
+/**
+ * g_paste_client_add_from_fd:
+ * @self: a #GPasteClient instance
+ * @fd: the file descriptor holding the text to add
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Add an item to the #GPasteDaemon, which reads it straight from @fd.
+ * @fd must be a memfd, such as the ones g_paste_util_memfd_new_from_fd
+ * creates, or a regular file.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_from_fd (GPasteClient       *self,
+                            gint                fd,
+                            GAsyncReadyCallback callback,
+                            gpointer            user_data)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (fd >= 0);
+
+    GVariant *parameter = g_variant_new_handle (0);
+    GError *error = NULL;
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new_from_fd (fd, &error);
+
+    g_paste_client_call_with_fd (self, G_PASTE_DAEMON_ADD_FD, g_variant_new_tuple (&parameter, 1), fd_list, error, g_paste_client_add_from_fd, callback, user_data);
+}
+
+/**
+ * g_paste_client_add_many:
+ * @self: a #GPasteClient instance
+ * @texts: (array length=n_texts): the texts to add, the last one ending up in the clipboard
+ * @n_texts: the number of texts
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Add several items to the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_many (GPasteClient       *self,
+                         const gchar       **texts,
+                         guint64             n_texts,
+                         GAsyncReadyCallback callback,
+                         gpointer            user_data)
+{
+    GVariant *param = g_variant_new_strv (texts, n_texts);
+    DBUS_CALL_ONE_PARAMV_ASYNC (ADD_MANY, param);
+}
+
 /**
  * g_paste_client_add_password:
  * @self: a #GPasteClient instance
@@ -915,6 +1847,30 @@ g_paste_client_delete_history (GPasteClient       *self,
     DBUS_CALL_ONE_PARAM_ASYNC (DELETE_HISTORY, string, name);
 }
 
+/**
+ * g_paste_client_delete_many:
+ * @self: a #GPasteClient instance
+ * @uuids: (array length=n_uuids): the uuids of the elements we want to delete
+ * @n_uuids: the number of uuids
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Delete several items from the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them.
+ * Nothing gets deleted if one of the uuids doesn't match any item.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_delete_many (GPasteClient       *self,
+                            const gchar       **uuids,
+                            guint64             n_uuids,
+                            GAsyncReadyCallback callback,
+                            gpointer            user_data)
+{
+    GVariant *param = g_variant_new_strv (uuids, n_uuids);
+    DBUS_CALL_ONE_PARAMV_ASYNC (DELETE_MANY, param);
+}
+
 /**
  * g_paste_client_delete_password:
  * @self: a #GPasteClient instance
@@ -953,6 +1909,25 @@ g_paste_client_empty_history (GPasteClient       *self,
     DBUS_CALL_ONE_PARAM_ASYNC (EMPTY_HISTORY, string, name);
 }
 
+/**
+ * g_paste_client_get_changes_since:
+ * @self: a #GPasteClient instance
+ * @seq: the last sequence number we know about
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Get the changes which happened to the history after @seq
+ */
+G_PASTE_VISIBLE void
+g_paste_client_get_changes_since (GPasteClient       *self,
+                                  guint64             seq,
+                                  GAsyncReadyCallback callback,
+                                  gpointer            user_data)
+{
+    DBUS_CALL_ONE_PARAM_ASYNC (GET_CHANGES_SINCE, uint64, seq);
+}
+
 /**
  * g_paste_client_get_element:
  * @self: a #GPasteClient instance
@@ -969,7 +1944,34 @@ g_paste_client_get_element (GPasteClient       *self,
                             GAsyncReadyCallback callback,
                             gpointer            user_data)
 {
-    DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT, string, uuid);
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+
+    const GPasteClientPrivate *priv = _g_paste_client_get_instance_private (self);
+
+    if (!priv->cache)
+    {
+        DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT, string, uuid);
+        return;
+    }
+
+    g_autoptr (GTask) task = g_paste_client_lookup_new (self, g_paste_client_get_element, uuid, 0, callback, user_data);
+    GPasteClientCache *cache = g_paste_client_private_get_cache (priv);
+    const gchar *cached = (cache) ? g_paste_client_cache_get_value (cache, uuid) : NULL;
+
+    if (cached)
+    {
+        g_task_return_pointer (task, g_strdup (cached), g_free);
+        return;
+    }
+
+    g_dbus_proxy_call (G_DBUS_PROXY (self),
+                       G_PASTE_DAEMON_GET_ELEMENT,
+                       g_variant_new ("(s)", uuid),
+                       G_DBUS_CALL_FLAGS_NONE,
+                       -1,
+                       NULL, /* cancellable */
+                       g_paste_client_on_element_fetched,
+                       g_object_ref (task));
 }
 
 /**
@@ -988,7 +1990,37 @@ g_paste_client_get_element_at_index (GPasteClient       *self,
                                      GAsyncReadyCallback callback,
                                      gpointer            user_data)
 {
-    DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT_AT_INDEX, uint64, index);
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+
+    const GPasteClientPrivate *priv = _g_paste_client_get_instance_private (self);
+
+    if (!priv->cache)
+    {
+        DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT_AT_INDEX, uint64, index);
+        return;
+    }
+
+    g_autoptr (GTask) task = g_paste_client_lookup_new (self, g_paste_client_get_element_at_index, NULL, index, callback, user_data);
+    GPasteClientCache *cache = g_paste_client_private_get_cache (priv);
+    const gchar *uuid = (cache) ? g_paste_client_cache_get_uuid_at (cache, index) : NULL;
+    const gchar *cached = (uuid) ? g_paste_client_cache_get_value (cache, uuid) : NULL;
+
+    if (cached)
+    {
+        g_task_return_pointer (task,
+                               g_paste_client_item_new_with_kind (uuid, g_paste_client_cache_get_kind (cache, uuid), cached),
+                               g_object_unref);
+        return;
+    }
+
+    g_dbus_proxy_call (G_DBUS_PROXY (self),
+                       G_PASTE_DAEMON_GET_ELEMENT_AT_INDEX,
+                       g_variant_new ("(t)", index),
+                       G_DBUS_CALL_FLAGS_NONE,
+                       -1,
+                       NULL, /* cancellable */
+                       g_paste_client_on_element_at_index_fetched,
+                       g_object_ref (task));
 }
 
 /**
@@ -1007,7 +2039,34 @@ g_paste_client_get_element_kind (GPasteClient       *self,
                                  GAsyncReadyCallback callback,
                                  gpointer            user_data)
 {
-    DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT_KIND, string, uuid);
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+
+    const GPasteClientPrivate *priv = _g_paste_client_get_instance_private (self);
+
+    if (!priv->cache)
+    {
+        DBUS_CALL_ONE_PARAM_ASYNC (GET_ELEMENT_KIND, string, uuid);
+        return;
+    }
+
+    g_autoptr (GTask) task = g_paste_client_lookup_new (self, g_paste_client_get_element_kind, uuid, 0, callback, user_data);
+    GPasteClientCache *cache = g_paste_client_private_get_cache (priv);
+    GPasteItemKind kind = (cache) ? g_paste_client_cache_get_kind (cache, uuid) : G_PASTE_ITEM_KIND_INVALID;
+
+    if (kind != G_PASTE_ITEM_KIND_INVALID)
+    {
+        g_task_return_int (task, kind);
+        return;
+    }
+
+    g_dbus_proxy_call (G_DBUS_PROXY (self),
+                       G_PASTE_DAEMON_GET_ELEMENT_KIND,
+                       g_variant_new ("(s)", uuid),
+                       G_DBUS_CALL_FLAGS_NONE,
+                       -1,
+                       NULL, /* cancellable */
+                       g_paste_client_on_element_kind_fetched,
+                       g_object_ref (task));
 }
 
 /**
@@ -1032,6 +2091,34 @@ g_paste_client_get_elements (GPasteClient       *self,
     DBUS_CALL_ONE_PARAMV_ASYNC (GET_ELEMENTS, param);
 }
 
+/**
+ * g_paste_client_get_elements_range:
+ * @self: a #GPasteClient instance
+ * @offset: the index of the first element we want to get
+ * @count: the number of elements we want to get
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Get a page of items from the #GPasteDaemon, with their kind and
+ * their display string, bounded by the element-size setting.
+ * The page is cut short at the end of the history.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_get_elements_range (GPasteClient       *self,
+                                   guint64             offset,
+                                   guint64             count,
+                                   GAsyncReadyCallback callback,
+                                   gpointer            user_data)
+{
+    GVariant *params[] = {
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (count)
+    };
+
+    DBUS_CALL_TWO_PARAMS_ASYNC (GET_ELEMENTS_RANGE, params);
+}
+
 /**
  * g_paste_client_get_history:
  * @self: a #GPasteClient instance
@@ -1104,6 +2191,38 @@ g_paste_client_get_raw_element (GPasteClient       *self,
     DBUS_CALL_ONE_PARAM_ASYNC (GET_RAW_ELEMENT, string, uuid);
 }
 
+/**
+ * g_paste_client_get_raw_element_fd:
+ * @self: a #GPasteClient instance
+ * @uuid: the uuid of the element we want to get
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Get an item from the #GPasteDaemon, through a memfd instead of the bus
+ */
+G_PASTE_VISIBLE void
+g_paste_client_get_raw_element_fd (GPasteClient       *self,
+                                   const gchar        *uuid,
+                                   GAsyncReadyCallback callback,
+                                   gpointer            user_data)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (uuid);
+
+    GVariant *parameter = g_variant_new_string (uuid);
+
+    g_dbus_proxy_call_with_unix_fd_list (G_DBUS_PROXY (self),
+                                         G_PASTE_DAEMON_GET_RAW_ELEMENT_FD,
+                                         g_variant_new_tuple (&parameter, 1),
+                                         G_DBUS_CALL_FLAGS_NONE,
+                                         -1,
+                                         NULL, /* fd_list */
+                                         NULL, /* cancellable */
+                                         callback,
+                                         user_data);
+}
+
 /**
  * g_paste_client_get_raw_history:
  * @self: a #GPasteClient instance
@@ -1121,6 +2240,33 @@ g_paste_client_get_raw_history (GPasteClient       *self,
     DBUS_CALL_NO_PARAM_ASYNC (GET_RAW_HISTORY);
 }
 
+/**
+ * g_paste_client_get_raw_history_fd:
+ * @self: a #GPasteClient instance
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Get the history from the #GPasteDaemon, through a memfd instead of the bus
+ */
+G_PASTE_VISIBLE void
+g_paste_client_get_raw_history_fd (GPasteClient       *self,
+                                   GAsyncReadyCallback callback,
+                                   gpointer            user_data)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+
+    g_dbus_proxy_call_with_unix_fd_list (G_DBUS_PROXY (self),
+                                         G_PASTE_DAEMON_GET_RAW_HISTORY_FD,
+                                         g_variant_new_tuple (NULL, 0),
+                                         G_DBUS_CALL_FLAGS_NONE,
+                                         -1,
+                                         NULL, /* fd_list */
+                                         NULL, /* cancellable */
+                                         callback,
+                                         user_data);
+}
+
 /**
  * g_paste_client_list_histories:
  * @self: a #GPasteClient instance
@@ -1237,46 +2383,197 @@ g_paste_client_rename_password (GPasteClient       *self,
 /**
  * g_paste_client_replace:
  * @self: a #GPasteClient instance
- * @uuid: the uuid of the element we want to replace
- * @contents: the replacement contents
+ * @uuid: the uuid of the element we want to replace
+ * @contents: the replacement contents
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: The data to pass to @callback.
+ *
+ * Replace the contents of an item
+ */
+G_PASTE_VISIBLE void
+g_paste_client_replace (GPasteClient       *self,
+                        const gchar        *uuid,
+                        const gchar        *contents,
+                        GAsyncReadyCallback callback,
+                        gpointer            user_data)
+{
+    GVariant *params[] = {
+        g_variant_new_string (uuid),
+        g_variant_new_string (contents)
+    };
+
+    DBUS_CALL_TWO_PARAMS_ASYNC (REPLACE, params);
+}
+
+/**
+ * g_paste_client_replace_fd:
+ * @self: a #GPasteClient instance
+ * @uuid: the uuid of the element we want to replace
+ * @contents: the replacement contents
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Replace the contents of an item, passing them through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_replace_fd (GPasteClient       *self,
+                           const gchar        *uuid,
+                           const gchar        *contents,
+                           GAsyncReadyCallback callback,
+                           gpointer            user_data)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (uuid);
+    g_return_if_fail (contents);
+
+    GVariant *params[] = {
+        g_variant_new_string (uuid),
+        g_variant_new_handle (0)
+    };
+
+    GError *error = NULL;
+    g_autoptr (GUnixFDList) fd_list = g_paste_client_fd_list_new (G_PASTE_DAEMON_REPLACE_FD, contents, &error);
+
+    g_paste_client_call_with_fd (self, G_PASTE_DAEMON_REPLACE_FD, g_variant_new_tuple (params, 2), fd_list, error, g_paste_client_replace_fd, callback, user_data);
+}
+
+/**
+ * g_paste_client_search:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Search for items matching @pattern in history
+ */
+G_PASTE_VISIBLE void
+g_paste_client_search (GPasteClient       *self,
+                       const gchar        *pattern,
+                       GAsyncReadyCallback callback,
+                       gpointer            user_data)
+{
+    DBUS_CALL_ONE_PARAM_ASYNC (SEARCH, string, pattern);
+}
+
+/**
+ * g_paste_client_search_all_histories:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in histories
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Search for items matching @pattern in all the histories,
+ * without having the daemon load them
+ */
+G_PASTE_VISIBLE void
+g_paste_client_search_all_histories (GPasteClient       *self,
+                                     const gchar        *pattern,
+                                     GAsyncReadyCallback callback,
+                                     gpointer            user_data)
+{
+    DBUS_CALL_ONE_PARAM_ASYNC (SEARCH_ALL_HISTORIES, string, pattern);
+}
+
+/**
+ * g_paste_client_search_previews:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @mode: how to match @pattern
+ * @offset: the number of matching items to skip
+ * @limit: the maximum number of items to return, 0 for no limit
+ * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
+ * care about the result of the method invocation.
+ * @user_data: (nullable): The data to pass to @callback.
+ *
+ * Search for items matching @pattern in history, getting their kind
+ * and a preview of their contents, bounded by the element-size setting,
+ * along with their uuids
+ */
+G_PASTE_VISIBLE void
+g_paste_client_search_previews (GPasteClient       *self,
+                                const gchar        *pattern,
+                                GPasteSearchMode    mode,
+                                guint64             offset,
+                                guint64             limit,
+                                GAsyncReadyCallback callback,
+                                gpointer            user_data)
+{
+    GVariant *params[] = {
+        g_variant_new_string (pattern),
+        g_variant_new_string (g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SEARCH_MODE), mode)->value_nick),
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (limit)
+    };
+
+    DBUS_CALL_FOUR_PARAMS_ASYNC (SEARCH_PREVIEWS, params);
+}
+
+/**
+ * g_paste_client_search_with_options:
+ * @self: a #GPasteClient instance
+ * @pattern: the pattern to look for in history
+ * @mode: how to match @pattern
+ * @offset: the number of matching items to skip
+ * @limit: the maximum number of items to return, 0 for no limit
  * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
  * care about the result of the method invocation.
- * @user_data: The data to pass to @callback.
+ * @user_data: (nullable): The data to pass to @callback.
  *
- * Replace the contents of an item
+ * Search for items matching @pattern in history, as a plain text,
+ * a regex or a fuzzy subsequence depending on @mode
  */
 G_PASTE_VISIBLE void
-g_paste_client_replace (GPasteClient       *self,
-                        const gchar        *uuid,
-                        const gchar        *contents,
-                        GAsyncReadyCallback callback,
-                        gpointer            user_data)
+g_paste_client_search_with_options (GPasteClient       *self,
+                                    const gchar        *pattern,
+                                    GPasteSearchMode    mode,
+                                    guint64             offset,
+                                    guint64             limit,
+                                    GAsyncReadyCallback callback,
+                                    gpointer            user_data)
 {
     GVariant *params[] = {
-        g_variant_new_string (uuid),
-        g_variant_new_string (contents)
+        g_variant_new_string (pattern),
+        g_variant_new_string (g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SEARCH_MODE), mode)->value_nick),
+        g_variant_new_uint64 (offset),
+        g_variant_new_uint64 (limit)
     };
 
-    DBUS_CALL_TWO_PARAMS_ASYNC (REPLACE, params);
+    DBUS_CALL_FOUR_PARAMS_ASYNC (SEARCH_WITH_OPTIONS, params);
 }
 
 /**
- * g_paste_client_search:
+ * g_paste_client_search_within:
  * @self: a #GPasteClient instance
  * @pattern: the pattern to look for in history
+ * @uuids: (array length=n_uuids): the uuids of the items to search in
+ * @n_uuids: the number of uuids
  * @callback: (nullable): A #GAsyncReadyCallback to call when the request is satisfied or %NULL if you don't
  * care about the result of the method invocation.
  * @user_data: (nullable): The data to pass to @callback.
  *
- * Search for items matching @pattern in history
+ * Search for items matching @pattern among @uuids, typically
+ * the results of a previous search for a less specific pattern,
+ * plus the items @pattern designates by uuid or password name
  */
 G_PASTE_VISIBLE void
-g_paste_client_search (GPasteClient       *self,
-                       const gchar        *pattern,
-                       GAsyncReadyCallback callback,
-                       gpointer            user_data)
+g_paste_client_search_within (GPasteClient       *self,
+                              const gchar        *pattern,
+                              const gchar       **uuids,
+                              guint64             n_uuids,
+                              GAsyncReadyCallback callback,
+                              gpointer            user_data)
 {
-    DBUS_CALL_ONE_PARAM_ASYNC (SEARCH, string, pattern);
+    GVariant *params[] = {
+        g_variant_new_string (pattern),
+        g_variant_new_strv (uuids, n_uuids)
+    };
+
+    DBUS_CALL_TWO_PARAMS_ASYNC (SEARCH_WITHIN, params);
 }
 
 /**
@@ -1434,6 +2731,34 @@ g_paste_client_add_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/**
+ * g_paste_client_add_fd_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Add an item to the #GPasteDaemon, passing it through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_fd_finish (GPasteClient *self,
+                              GAsyncResult *result,
+                              GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (G_IS_ASYNC_RESULT (result));
+    g_return_if_fail (!error || !(*error));
+
+    /* We failed to create the memfd before even calling the daemon */
+    if (g_async_result_is_tagged (result, g_paste_client_add_fd))
+    {
+        g_task_propagate_boolean (G_TASK (result), error);
+        return;
+    }
+
+    g_autoptr (GVariant) _result = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (self), NULL, result, error);
+}
+
 /**
  * g_paste_client_add_file_finish:
  * @self: a #GPasteClient instance
@@ -1450,6 +2775,50 @@ g_paste_client_add_file_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/**
+ * g_paste_client_add_from_fd_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Add an item to the #GPasteDaemon, which reads it straight from a file descriptor
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_from_fd_finish (GPasteClient *self,
+                                   GAsyncResult *result,
+                                   GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (G_IS_ASYNC_RESULT (result));
+    g_return_if_fail (!error || !(*error));
+
+    /* We failed to duplicate the fd before even calling the daemon */
+    if (g_async_result_is_tagged (result, g_paste_client_add_from_fd))
+    {
+        g_task_propagate_boolean (G_TASK (result), error);
+        return;
+    }
+
+    g_autoptr (GVariant) _result = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (self), NULL, result, error);
+}
+
+/**
+ * g_paste_client_add_many_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Add several items to the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them
+ */
+G_PASTE_VISIBLE void
+g_paste_client_add_many_finish (GPasteClient *self,
+                                GAsyncResult *result,
+                                GError      **error)
+{
+    DBUS_ASYNC_FINISH_NO_RETURN;
+}
+
 /**
  * g_paste_client_add_password_finish:
  * @self: a #GPasteClient instance
@@ -1514,6 +2883,24 @@ g_paste_client_delete_history_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/**
+ * g_paste_client_delete_many_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Delete several items from the #GPasteDaemon at once, the history
+ * being saved and the change announced only once for all of them.
+ * Nothing gets deleted if one of the uuids doesn't match any item.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_delete_many_finish (GPasteClient *self,
+                                   GAsyncResult *result,
+                                   GError      **error)
+{
+    DBUS_ASYNC_FINISH_NO_RETURN;
+}
+
 /**
  * g_paste_client_delete_password_finish:
  * @self: a #GPasteClient instance
@@ -1546,6 +2933,28 @@ g_paste_client_empty_history_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/**
+ * g_paste_client_get_changes_since_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @seq: (out) (optional): the current sequence number of the history
+ * @error: a #GError
+ *
+ * Get the changes which happened to the history, as an array of
+ * (kind, position, old position, uuid, item kind, preview),
+ * see the "changed" signal
+ *
+ * Returns: (transfer full): the "a(sttsss)" changes
+ */
+G_PASTE_VISIBLE GVariant *
+g_paste_client_get_changes_since_finish (GPasteClient *self,
+                                         GAsyncResult *result,
+                                         guint64      *seq,
+                                         GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_CHANGES (seq);
+}
+
 /**
  * g_paste_client_get_element_finish:
  * @self: a #GPasteClient instance
@@ -1561,6 +2970,9 @@ g_paste_client_get_element_finish (GPasteClient *self,
                                    GAsyncResult *result,
                                    GError      **error)
 {
+    if (g_async_result_is_tagged (result, g_paste_client_get_element))
+        return g_task_propagate_pointer (G_TASK (result), error);
+
     DBUS_ASYNC_FINISH_RET_STRING;
 }
 
@@ -1579,6 +2991,9 @@ g_paste_client_get_element_at_index_finish (GPasteClient *self,
                                             GAsyncResult *result,
                                             GError      **error)
 {
+    if (g_async_result_is_tagged (result, g_paste_client_get_element_at_index))
+        return g_task_propagate_pointer (G_TASK (result), error);
+
     DBUS_ASYNC_FINISH_RET_ITEM;
 }
 
@@ -1605,10 +3020,16 @@ g_paste_client_get_element_kind_finish (GPasteClient *self,
                                         GAsyncResult *result,
                                         GError      **error)
 {
+    if (g_async_result_is_tagged (result, g_paste_client_get_element_kind))
+    {
+        gssize kind = g_task_propagate_int (G_TASK (result), error);
+
+        return (kind < 0) ? G_PASTE_ITEM_KIND_INVALID : (GPasteItemKind) kind;
+    }
+
     g_autofree gchar *kind = _g_paste_client_get_element_kind_finish (self, result, error);
-    GEnumValue *k = (kind) ? g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_ITEM_KIND), kind) : NULL;
 
-    return (k) ? k->value : G_PASTE_ITEM_KIND_INVALID;
+    return g_paste_client_get_item_kind (kind);
 }
 
 /**
@@ -1629,6 +3050,24 @@ g_paste_client_get_elements_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_RET_ITEMS;
 }
 
+/**
+ * g_paste_client_get_elements_range_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Get a page of items from the #GPasteDaemon
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_get_elements_range_finish (GPasteClient *self,
+                                          GAsyncResult *result,
+                                          GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_PREVIEWS;
+}
+
 /**
  * g_paste_client_get_history_finish:
  * @self: a #GPasteClient instance
@@ -1701,6 +3140,34 @@ g_paste_client_get_raw_element_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_RET_STRING;
 }
 
+/**
+ * g_paste_client_get_raw_element_fd_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Get an item from the #GPasteDaemon, through a memfd instead of the bus
+ *
+ * Returns: (transfer full): the contents of the item, not nul-terminated
+ */
+G_PASTE_VISIBLE GBytes *
+g_paste_client_get_raw_element_fd_finish (GPasteClient *self,
+                                          GAsyncResult *result,
+                                          GError      **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+    g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    g_autoptr (GUnixFDList) fd_list = NULL;
+    g_autoptr (GVariant) _result = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (self), &fd_list, result, error);
+
+    if (!_result)
+        return NULL;
+
+    return g_paste_client_get_fd_result (_result, fd_list, error);
+}
+
 /**
  * g_paste_client_get_raw_history_finish:
  * @self: a #GPasteClient instance
@@ -1719,6 +3186,34 @@ g_paste_client_get_raw_history_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_RET_ITEMS;
 }
 
+/**
+ * g_paste_client_get_raw_history_fd_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Get the history from the #GPasteDaemon, through a memfd instead of the bus
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): a newly allocated array of string
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_get_raw_history_fd_finish (GPasteClient *self,
+                                          GAsyncResult *result,
+                                          GError      **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_CLIENT (self), NULL);
+    g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    g_autoptr (GUnixFDList) fd_list = NULL;
+    g_autoptr (GVariant) _result = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (self), &fd_list, result, error);
+
+    if (!_result)
+        return NULL;
+
+    return g_paste_client_get_history_fd_result (_result, fd_list, error);
+}
+
 /**
  * g_paste_client_list_histories_finish:
  * @self: a #GPasteClient instance
@@ -1817,6 +3312,34 @@ g_paste_client_replace_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/**
+ * g_paste_client_replace_fd_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Replace the contents of an item, passing them through a memfd
+ * instead of the bus, which is cheaper for big contents
+ */
+G_PASTE_VISIBLE void
+g_paste_client_replace_fd_finish (GPasteClient *self,
+                                  GAsyncResult *result,
+                                  GError      **error)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+    g_return_if_fail (G_IS_ASYNC_RESULT (result));
+    g_return_if_fail (!error || !(*error));
+
+    /* We failed to create the memfd before even calling the daemon */
+    if (g_async_result_is_tagged (result, g_paste_client_replace_fd))
+    {
+        g_task_propagate_boolean (G_TASK (result), error);
+        return;
+    }
+
+    g_autoptr (GVariant) _result = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (self), NULL, result, error);
+}
+
 /**
  * g_paste_client_search_finish:
  * @self: a #GPasteClient instance
@@ -1835,6 +3358,80 @@ g_paste_client_search_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_RET_STRV;
 }
 
+/**
+ * g_paste_client_search_all_histories_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in all the histories
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The matching items,
+ *          the value of each one being the name of its history
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_search_all_histories_finish (GPasteClient *self,
+                                            GAsyncResult *result,
+                                            GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_HISTORY_MATCHES;
+}
+
+/**
+ * g_paste_client_search_previews_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in history, getting their kind
+ * and a preview of their contents along with their uuids
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The matching items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_client_search_previews_finish (GPasteClient *self,
+                                       GAsyncResult *result,
+                                       GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_PREVIEWS;
+}
+
+/**
+ * g_paste_client_search_with_options_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Search for items matching @pattern in history, depending on @mode
+ *
+ * Returns: (transfer full): The uuids of the matching items
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_client_search_with_options_finish (GPasteClient *self,
+                                           GAsyncResult *result,
+                                           GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_STRV;
+}
+
+/**
+ * g_paste_client_search_within_finish:
+ * @self: a #GPasteClient instance
+ * @result: A #GAsyncResult obtained from the #GAsyncReadyCallback passed to the async call.
+ * @error: a #GError
+ *
+ * Search for items matching @pattern among @uuids
+ *
+ * Returns: (transfer full): The uuids of the matching items
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_client_search_within_finish (GPasteClient *self,
+                                     GAsyncResult *result,
+                                     GError      **error)
+{
+    DBUS_ASYNC_FINISH_RET_STRV;
+}
+
 /**
  * g_paste_client_select_finish:
  * @self: a #GPasteClient instance
@@ -1931,6 +3528,50 @@ g_paste_client_upload_finish (GPasteClient *self,
     DBUS_ASYNC_FINISH_NO_RETURN;
 }
 
+/*********/
+/* Cache */
+/*********/
+
+/**
+ * g_paste_client_set_cache_enabled:
+ * @self: a #GPasteClient instance
+ * @enabled: whether to keep a copy of the history
+ *
+ * Keep a copy of the history of the #GPasteDaemon, kept up to date through
+ * the "changed" signal, so that g_paste_client_get_element(),
+ * g_paste_client_get_element_kind() and g_paste_client_get_element_at_index()
+ * only ask the daemon about an item the first time.
+ * The copy only sees the changes once the signal has been dispatched by
+ * the main loop.
+ */
+G_PASTE_VISIBLE void
+g_paste_client_set_cache_enabled (GPasteClient *self,
+                                  gboolean      enabled)
+{
+    g_return_if_fail (_G_PASTE_IS_CLIENT (self));
+
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (self);
+
+    if (!enabled == !priv->cache)
+        return;
+
+    if (enabled)
+    {
+        priv->cache = g_paste_client_cache_new ();
+        priv->c_owner = g_signal_connect (self,
+                                          "notify::g-name-owner",
+                                          G_CALLBACK (g_paste_client_on_name_owner_changed),
+                                          NULL); /* user_data */
+        g_paste_client_sync_cache (self);
+    }
+    else
+    {
+        g_signal_handler_disconnect (self, priv->c_owner);
+        g_clear_pointer (&priv->cache, g_paste_client_cache_free);
+        priv->syncing = FALSE;
+    }
+}
+
 /**************/
 /* Properties */
 /**************/
@@ -1971,10 +3612,32 @@ g_paste_client_g_signal (GDBusProxy  *proxy,
 {
     GPasteClient *self = G_PASTE_CLIENT (proxy);
 
+    /* The history we mirror may not be there anymore */
+    if (g_paste_str_equal (signal_name, G_PASTE_DAEMON_SIG_DELETE_HISTORY) ||
+        g_paste_str_equal (signal_name, G_PASTE_DAEMON_SIG_EMPTY_HISTORY) ||
+        g_paste_str_equal (signal_name, G_PASTE_DAEMON_SIG_SWITCH_HISTORY))
+    {
+        g_paste_client_private_reset_cache (self);
+    }
+
     HANDLE_SIGNAL (SHOW_HISTORY)
     else HANDLE_SIGNAL_WITH_DATA (DELETE_HISTORY, const gchar *, g_variant_get_string (variant, NULL))
     else HANDLE_SIGNAL_WITH_DATA (EMPTY_HISTORY,  const gchar *, g_variant_get_string (variant, NULL))
     else HANDLE_SIGNAL_WITH_DATA (SWITCH_HISTORY, const gchar *, g_variant_get_string (variant, NULL))
+    else if (g_paste_str_equal (signal_name, G_PASTE_DAEMON_SIG_CHANGED))
+    {
+        GVariantIter params_iter;
+        g_variant_iter_init (&params_iter, parameters);
+        g_autoptr (GVariant) v1 = g_variant_iter_next_value (&params_iter);
+        g_autoptr (GVariant) v2 = g_variant_iter_next_value (&params_iter);
+        g_paste_client_private_on_changed (self, g_variant_get_uint64 (v1), v2);
+        g_signal_emit (self,
+                       signals[CHANGED],
+                       0, /* detail */
+                       g_variant_get_uint64 (v1),
+                       v2,
+                       NULL);
+    }
     else if (g_paste_str_equal (signal_name, G_PASTE_DAEMON_SIG_UPDATE))
     {
         GVariantIter params_iter;
@@ -2014,14 +3677,53 @@ g_paste_client_g_properties_changed (GDBusProxy          *proxy,
     }
 }
 
+static void
+g_paste_client_finalize (GObject *object)
+{
+    GPasteClientPrivate *priv = g_paste_client_get_instance_private (G_PASTE_CLIENT (object));
+
+    if (priv->cache)
+        g_paste_client_cache_free (priv->cache);
+
+    G_OBJECT_CLASS (g_paste_client_parent_class)->finalize (object);
+}
+
 static void
 g_paste_client_class_init (GPasteClientClass *klass)
 {
     GDBusProxyClass *proxy_class = G_DBUS_PROXY_CLASS (klass);
 
+    G_OBJECT_CLASS (klass)->finalize = g_paste_client_finalize;
+
     proxy_class->g_signal = g_paste_client_g_signal;
     proxy_class->g_properties_changed = g_paste_client_g_properties_changed;
 
+    /**
+     * GPasteClient::changed:
+     * @client: the object on which the signal was emitted
+     * @seq: the sequence number of the history after the changes
+     * @changes: the changes, as an "a(sttsss)" #GVariant
+     *
+     * The "changed" signal is emitted whenever anything changed in the history,
+     * along with what changed. Each change is a (kind, position, old position,
+     * uuid, item kind, preview) tuple, the kind being a #GPasteChangeKind nick.
+     * They have to be applied in order. A RESET change means that the whole
+     * history has to be fetched again, its position being the new length.
+     * If @seq is not the one after the last one we got, some changes were missed
+     * and can be fetched with g_paste_client_get_changes_since().
+     */
+    signals[CHANGED] = g_signal_new ("changed",
+                                     G_PASTE_TYPE_CLIENT,
+                                     G_SIGNAL_RUN_LAST,
+                                     0, /* class offset */
+                                     NULL, /* accumulator */
+                                     NULL, /* accumulator data */
+                                     g_cclosure_marshal_generic,
+                                     G_TYPE_NONE,
+                                     2, /* number of params */
+                                     G_TYPE_UINT64,
+                                     G_TYPE_VARIANT);
+
     /**
      * GPasteClient::delete-history:
      * @client: the object on which the signal was emitted
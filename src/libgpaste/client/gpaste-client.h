@@ -13,6 +13,7 @@
 
 #include <gpaste-client-item.h>
 #include <gpaste-item-enums.h>
+#include <gpaste-search-enums.h>
 
 G_BEGIN_DECLS
 
@@ -29,9 +30,19 @@ void     g_paste_client_about_sync                      (GPasteClient  *self,
 void     g_paste_client_add_sync                        (GPasteClient  *self,
                                                          const gchar   *text,
                                                          GError       **error);
+void     g_paste_client_add_fd_sync                     (GPasteClient  *self,
+                                                         const gchar   *text,
+                                                         GError       **error);
 void     g_paste_client_add_file_sync                   (GPasteClient  *self,
                                                          const gchar   *file,
                                                          GError       **error);
+void     g_paste_client_add_from_fd_sync                (GPasteClient  *self,
+                                                         gint           fd,
+                                                         GError       **error);
+void     g_paste_client_add_many_sync                   (GPasteClient  *self,
+                                                         const gchar  **texts,
+                                                         guint64        n_texts,
+                                                         GError       **error);
 void     g_paste_client_add_password_sync               (GPasteClient  *self,
                                                          const gchar   *name,
                                                          const gchar   *password,
@@ -46,6 +57,10 @@ void     g_paste_client_delete_sync                     (GPasteClient  *self,
 void     g_paste_client_delete_history_sync             (GPasteClient  *self,
                                                          const gchar   *name,
                                                          GError       **error);
+void     g_paste_client_delete_many_sync                (GPasteClient  *self,
+                                                         const gchar  **uuids,
+                                                         guint64        n_uuids,
+                                                         GError       **error);
 void     g_paste_client_delete_password_sync            (GPasteClient  *self,
                                                          const gchar   *name,
                                                          GError       **error);
@@ -59,6 +74,10 @@ GList   *g_paste_client_get_elements_sync               (GPasteClient  *self,
                                                          const gchar  **uuids,
                                                          guint64        n_uuids,
                                                          GError       **error);
+GList   *g_paste_client_get_elements_range_sync         (GPasteClient  *self,
+                                                         guint64        offset,
+                                                         guint64        count,
+                                                         GError       **error);
 GList   *g_paste_client_get_history_sync                (GPasteClient  *self,
                                                          GError       **error);
 gchar   *g_paste_client_get_history_name_sync           (GPasteClient  *self,
@@ -69,8 +88,13 @@ guint64  g_paste_client_get_history_size_sync           (GPasteClient  *self,
 gchar   *g_paste_client_get_raw_element_sync            (GPasteClient  *self,
                                                          const gchar   *uuid,
                                                          GError       **error);
+GBytes  *g_paste_client_get_raw_element_fd_sync         (GPasteClient  *self,
+                                                         const gchar   *uuid,
+                                                         GError       **error);
 GList   *g_paste_client_get_raw_history_sync            (GPasteClient  *self,
                                                          GError       **error);
+GList   *g_paste_client_get_raw_history_fd_sync         (GPasteClient  *self,
+                                                         GError       **error);
 GStrv    g_paste_client_list_histories_sync             (GPasteClient  *self,
                                                          GError       **error);
 void     g_paste_client_merge_sync                      (GPasteClient  *self,
@@ -92,9 +116,21 @@ void     g_paste_client_replace_sync                    (GPasteClient  *self,
                                                          const gchar   *uuid,
                                                          const gchar   *contents,
                                                          GError       **error);
+void     g_paste_client_replace_fd_sync                 (GPasteClient  *self,
+                                                         const gchar   *uuid,
+                                                         const gchar   *contents,
+                                                         GError       **error);
 GStrv    g_paste_client_search_sync                     (GPasteClient  *self,
                                                          const gchar   *pattern,
                                                          GError       **error);
+GList   *g_paste_client_search_all_histories_sync       (GPasteClient  *self,
+                                                         const gchar   *pattern,
+                                                         GError       **error);
+GStrv    g_paste_client_search_within_sync              (GPasteClient  *self,
+                                                         const gchar   *pattern,
+                                                         const gchar  **uuids,
+                                                         guint64        n_uuids,
+                                                         GError       **error);
 void     g_paste_client_select_sync                     (GPasteClient  *self,
                                                          const gchar   *uuid,
                                                          GError       **error);
@@ -114,12 +150,28 @@ void     g_paste_client_upload_sync                     (GPasteClient  *self,
                                                          const gchar   *uuid,
                                                          GError       **error);
 
+GVariant         *g_paste_client_get_changes_since_sync    (GPasteClient  *self,
+                                                            guint64        seq,
+                                                            guint64       *current_seq,
+                                                            GError       **error);
 GPasteClientItem *g_paste_client_get_element_at_index_sync (GPasteClient  *self,
                                                             guint64        index,
                                                             GError       **error);
 GPasteItemKind    g_paste_client_get_element_kind_sync     (GPasteClient *self,
                                                             const gchar  *uuid,
                                                             GError      **error);
+GList            *g_paste_client_search_previews_sync      (GPasteClient    *self,
+                                                            const gchar     *pattern,
+                                                            GPasteSearchMode mode,
+                                                            guint64          offset,
+                                                            guint64          limit,
+                                                            GError         **error);
+GStrv             g_paste_client_search_with_options_sync  (GPasteClient    *self,
+                                                            const gchar     *pattern,
+                                                            GPasteSearchMode mode,
+                                                            guint64          offset,
+                                                            guint64          limit,
+                                                            GError         **error);
 /*******************/
 /* Methods / Async */
 /*******************/
@@ -131,10 +183,23 @@ void g_paste_client_add                        (GPasteClient       *self,
                                                 const gchar        *text,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_add_fd                     (GPasteClient       *self,
+                                                const gchar        *text,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_add_file                   (GPasteClient       *self,
                                                 const gchar        *file,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_add_from_fd                (GPasteClient       *self,
+                                                gint                fd,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+void g_paste_client_add_many                   (GPasteClient       *self,
+                                                const gchar       **texts,
+                                                guint64             n_texts,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_add_password               (GPasteClient       *self,
                                                 const gchar        *name,
                                                 const gchar        *password,
@@ -153,6 +218,11 @@ void g_paste_client_delete_history             (GPasteClient       *self,
                                                 const gchar        *name,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_delete_many                (GPasteClient       *self,
+                                                const gchar       **uuids,
+                                                guint64             n_uuids,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_delete_password            (GPasteClient       *self,
                                                 const gchar        *name,
                                                 GAsyncReadyCallback callback,
@@ -161,6 +231,10 @@ void g_paste_client_empty_history              (GPasteClient       *self,
                                                 const gchar        *name,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_get_changes_since          (GPasteClient       *self,
+                                                guint64             seq,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_get_element                (GPasteClient       *self,
                                                 const gchar        *uuid,
                                                 GAsyncReadyCallback callback,
@@ -178,6 +252,11 @@ void g_paste_client_get_elements               (GPasteClient       *self,
                                                 guint64             n_uuids,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_get_elements_range         (GPasteClient       *self,
+                                                guint64             offset,
+                                                guint64             count,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_get_history                (GPasteClient       *self,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
@@ -192,9 +271,16 @@ void g_paste_client_get_raw_element            (GPasteClient       *self,
                                                 const gchar        *uuid,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_get_raw_element_fd         (GPasteClient       *self,
+                                                const gchar        *uuid,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_get_raw_history            (GPasteClient       *self,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_get_raw_history_fd         (GPasteClient       *self,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_list_histories             (GPasteClient       *self,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
@@ -222,10 +308,39 @@ void g_paste_client_replace                    (GPasteClient       *self,
                                                 const gchar        *contents,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_replace_fd                 (GPasteClient       *self,
+                                                const gchar        *uuid,
+                                                const gchar        *contents,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_search                     (GPasteClient       *self,
                                                 const gchar        *pattern,
                                                 GAsyncReadyCallback callback,
                                                 gpointer            user_data);
+void g_paste_client_search_all_histories       (GPasteClient       *self,
+                                                const gchar        *pattern,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+void g_paste_client_search_previews            (GPasteClient       *self,
+                                                const gchar        *pattern,
+                                                GPasteSearchMode    mode,
+                                                guint64             offset,
+                                                guint64             limit,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+void g_paste_client_search_with_options        (GPasteClient       *self,
+                                                const gchar        *pattern,
+                                                GPasteSearchMode    mode,
+                                                guint64             offset,
+                                                guint64             limit,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+void g_paste_client_search_within              (GPasteClient       *self,
+                                                const gchar        *pattern,
+                                                const gchar       **uuids,
+                                                guint64             n_uuids,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
 void g_paste_client_select                     (GPasteClient       *self,
                                                 const gchar        *uuid,
                                                 GAsyncReadyCallback callback,
@@ -261,9 +376,18 @@ void     g_paste_client_about_finish                      (GPasteClient *self,
 void     g_paste_client_add_finish                        (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+void     g_paste_client_add_fd_finish                     (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 void     g_paste_client_add_file_finish                   (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+void     g_paste_client_add_from_fd_finish                (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
+void     g_paste_client_add_many_finish                   (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 void     g_paste_client_add_password_finish               (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
@@ -276,6 +400,9 @@ void     g_paste_client_delete_finish                     (GPasteClient *self,
 void     g_paste_client_delete_history_finish             (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+void     g_paste_client_delete_many_finish                (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 void     g_paste_client_delete_password_finish            (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
@@ -288,6 +415,9 @@ gchar   *g_paste_client_get_element_finish                (GPasteClient *self,
 GList   *g_paste_client_get_elements_finish               (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+GList   *g_paste_client_get_elements_range_finish         (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 GList   *g_paste_client_get_history_finish                (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
@@ -300,9 +430,15 @@ guint64  g_paste_client_get_history_size_finish           (GPasteClient *self,
 gchar   *g_paste_client_get_raw_element_finish            (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+GBytes  *g_paste_client_get_raw_element_fd_finish         (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 GList   *g_paste_client_get_raw_history_finish            (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+GList   *g_paste_client_get_raw_history_fd_finish         (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 GStrv    g_paste_client_list_histories_finish             (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
@@ -321,9 +457,24 @@ void     g_paste_client_rename_password_finish            (GPasteClient *self,
 void     g_paste_client_replace_finish                    (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+void     g_paste_client_replace_fd_finish                 (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 GStrv    g_paste_client_search_finish                     (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
+GList   *g_paste_client_search_all_histories_finish       (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
+GList   *g_paste_client_search_previews_finish            (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
+GStrv    g_paste_client_search_with_options_finish        (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
+GStrv    g_paste_client_search_within_finish              (GPasteClient *self,
+                                                           GAsyncResult *result,
+                                                           GError      **error);
 void     g_paste_client_select_finish                     (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
@@ -343,6 +494,10 @@ void     g_paste_client_upload_finish                     (GPasteClient *self,
                                                            GAsyncResult *result,
                                                            GError      **error);
 
+GVariant         *g_paste_client_get_changes_since_finish    (GPasteClient *self,
+                                                              GAsyncResult *result,
+                                                              guint64      *seq,
+                                                              GError      **error);
 GPasteClientItem *g_paste_client_get_element_at_index_finish (GPasteClient *self,
                                                               GAsyncResult *result,
                                                               GError      **error);
@@ -350,6 +505,13 @@ GPasteItemKind    g_paste_client_get_element_kind_finish     (GPasteClient *self
                                                               GAsyncResult *result,
                                                               GError      **error);
 
+/*********/
+/* Cache */
+/*********/
+
+void g_paste_client_set_cache_enabled (GPasteClient *self,
+                                       gboolean      enabled);
+
 /**************/
 /* Properties */
 /**************/
@@ -0,0 +1,28 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-change-enums.h>
+#include <gpaste-macros.h>
+
+G_PASTE_VISIBLE GType
+g_paste_change_kind_get_type (void)
+{
+    static GType etype = 0;
+    if (!etype)
+    {
+        static const GEnumValue values[] = {
+            { G_PASTE_CHANGE_KIND_INSERT,  "G_PASTE_CHANGE_KIND_INSERT",  "INSERT"  },
+            { G_PASTE_CHANGE_KIND_REMOVE,  "G_PASTE_CHANGE_KIND_REMOVE",  "REMOVE"  },
+            { G_PASTE_CHANGE_KIND_MOVE,    "G_PASTE_CHANGE_KIND_MOVE",    "MOVE"    },
+            { G_PASTE_CHANGE_KIND_REPLACE, "G_PASTE_CHANGE_KIND_REPLACE", "REPLACE" },
+            { G_PASTE_CHANGE_KIND_RESET,   "G_PASTE_CHANGE_KIND_RESET",   "RESET"   },
+            { G_PASTE_CHANGE_KIND_INVALID, NULL,                          NULL      }
+        };
+        etype = g_enum_register_static (g_intern_static_string ("GPasteChangeKind"), values);
+        g_type_class_ref (etype);
+    }
+    return etype;
+}
@@ -0,0 +1,32 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_CHANGE_ENUMS_H__
+#define __G_PASTE_CHANGE_ENUMS_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    G_PASTE_CHANGE_KIND_INSERT = 1,
+    G_PASTE_CHANGE_KIND_REMOVE,
+    G_PASTE_CHANGE_KIND_MOVE,
+    G_PASTE_CHANGE_KIND_REPLACE,
+    G_PASTE_CHANGE_KIND_RESET,
+    G_PASTE_CHANGE_KIND_INVALID = 0
+} GPasteChangeKind;
+
+#define G_PASTE_TYPE_CHANGE_KIND (g_paste_change_kind_get_type ())
+GType g_paste_change_kind_get_type (void);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_CHANGE_ENUMS_H__*/
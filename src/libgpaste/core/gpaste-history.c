@@ -5,8 +5,10 @@
  */
 
 #include <gpaste-history.h>
+#include <gpaste-history-catalog.h>
 #include <gpaste-image-item.h>
 #include <gpaste-gsettings-keys.h>
+#include <gpaste-search-index.h>
 #include <gpaste-storage-backend.h>
 #include <gpaste-update-enums.h>
 #include <gpaste-uris-item.h>
@@ -28,14 +30,52 @@ typedef struct
 {
     GPasteStorageBackend *backend;
     GPasteSettings       *settings;
-    GList                *history;
+    GSequence            *history;
+    guint64               length;
     guint64               size;
 
+    /* Lazily built GList view of history, for g_paste_history_get_history */
+    GList                *history_list;
+    gboolean              history_list_valid;
+
+    /* uuid (owned by the item) -> GSequenceIter in history */
+    GHashTable           *uuid_index;
+    /* item hash -> GPtrArray of GSequenceIter in history, passwords excluded */
+    GHashTable           *hash_index;
+    /* trigrams of the values (and password names) -> GSequenceIter in history */
+    GPasteSearchIndex    *search_index;
+    /* Recently used GPasteHistoryCachedRegex, most recent first */
+    GQueue               *regex_cache;
+
     gchar                *name;
 
+    /* Max-heap of GPasteHistorySizeNode, by size, for eviction */
     /* Note: we never track the first (active) item here */
-    const gchar          *biggest_uuid;
-    guint64               biggest_size;
+    GArray               *size_heap;
+    /* GSequenceIter -> position in size_heap + 1 */
+    GHashTable           *size_heap_index;
+
+    /* GPasteHistoryChange not announced yet */
+    GQueue               *pending_changes;
+    /* The last announced GPasteHistoryChange, oldest first */
+    GQueue               *changes;
+    guint64               seq;
+    /* Some changes up to this seq may have been dropped from changes */
+    guint64               changes_floor;
+
+    /* Updates are held back while frozen, see g_paste_history_freeze_updates */
+    guint64               frozen;
+    gboolean              update_pending;
+    GPasteUpdateAction    pending_action;
+    GPasteUpdateTarget    pending_target;
+    guint64               pending_position;
+
+    /* Pending coalesced save */
+    guint                 save_source;
+    /* Protects saving, which is TRUE while a save runs in a worker thread */
+    GMutex                save_mutex;
+    GCond                 save_cond;
+    gboolean              saving;
 
     guint64               c_signals[C_LAST_SIGNAL];
 } GPasteHistoryPrivate;
@@ -47,1070 +87,2454 @@ enum
     SELECTED,
     SWITCH,
     UPDATE,
+    CHANGED,
 
     LAST_SIGNAL
 };
 
 static guint64 signals[LAST_SIGNAL] = { 0 };
 
-static void
-g_paste_history_private_elect_new_biggest (GPasteHistoryPrivate *priv)
+typedef struct
 {
-    g_debug ("history: elect biggest");
+    GSequenceIter *elem;
+    guint64        size;
+} GPasteHistorySizeNode;
+
+#define SIZE_HEAP_NODE(priv, i) g_array_index ((priv)->size_heap, GPasteHistorySizeNode, i)
 
-    priv->biggest_uuid = NULL;
-    priv->biggest_size = 0;
+static void
+g_paste_history_private_size_heap_set (GPasteHistoryPrivate *priv,
+                                       guint                 pos,
+                                       GPasteHistorySizeNode node)
+{
+    SIZE_HEAP_NODE (priv, pos) = node;
+    g_hash_table_insert (priv->size_heap_index, node.elem, GUINT_TO_POINTER (pos + 1));
+}
 
-    GList *history = priv->history;
+static void
+g_paste_history_private_size_heap_sift_up (GPasteHistoryPrivate *priv,
+                                           guint                 pos)
+{
+    GPasteHistorySizeNode node = SIZE_HEAP_NODE (priv, pos);
 
-    if (history)
+    while (pos)
     {
-        for (history = history->next; history; history = history->next)
-        {
-            GPasteItem *item = history->data;
-            guint64 size = g_paste_item_get_size (item);
+        guint parent = (pos - 1) / 2;
 
-            if (size > priv->biggest_size)
-            {
-                priv->biggest_uuid = g_paste_item_get_uuid (item);
-                priv->biggest_size = size;
-            }
-        }
+        if (SIZE_HEAP_NODE (priv, parent).size >= node.size)
+            break;
+
+        g_paste_history_private_size_heap_set (priv, pos, SIZE_HEAP_NODE (priv, parent));
+        pos = parent;
     }
+
+    g_paste_history_private_size_heap_set (priv, pos, node);
 }
 
 static void
-g_paste_history_private_remove (GPasteHistoryPrivate *priv,
-                                GList                *elem,
-                                gboolean              remove_leftovers)
+g_paste_history_private_size_heap_sift_down (GPasteHistoryPrivate *priv,
+                                             guint                 pos)
 {
-    if (!elem)
-        return;
+    GPasteHistorySizeNode node = SIZE_HEAP_NODE (priv, pos);
+    guint len = priv->size_heap->len;
 
-    GPasteItem *item = elem->data;
+    for (;;)
+    {
+        guint child = 2 * pos + 1;
 
-    priv->size -= g_paste_item_get_size (item);
+        if (child >= len)
+            break;
+        if (child + 1 < len && SIZE_HEAP_NODE (priv, child + 1).size > SIZE_HEAP_NODE (priv, child).size)
+            ++child;
+        if (node.size >= SIZE_HEAP_NODE (priv, child).size)
+            break;
 
-    if (remove_leftovers)
-    {
-        if (_G_PASTE_IS_IMAGE_ITEM (item))
-        {
-            g_autoptr (GFile) image = g_file_new_for_path (g_paste_item_get_value (item));
-            g_file_delete (image,
-                           NULL, /* cancellable */
-                           NULL); /* error */
-        }
-        g_object_unref (item);
+        g_paste_history_private_size_heap_set (priv, pos, SIZE_HEAP_NODE (priv, child));
+        pos = child;
     }
-    priv->history = g_list_delete_link (priv->history, elem);
+
+    g_paste_history_private_size_heap_set (priv, pos, node);
 }
 
 static void
-g_paste_history_selected (GPasteHistory *self,
-                          GPasteItem    *item)
+g_paste_history_private_size_heap_update (GPasteHistoryPrivate *priv,
+                                          GSequenceIter        *elem)
 {
-    g_debug ("history: selected");
+    guint pos = GPOINTER_TO_UINT (g_hash_table_lookup (priv->size_heap_index, elem));
 
-    g_signal_emit (self,
-                   signals[SELECTED],
-                   0, /* detail */
-                   item,
-                   NULL);
-}
+    if (!pos--)
+        return;
 
-static void
-g_paste_history_emit_switch (GPasteHistory *self,
-                             const gchar   *name)
-{
-    g_debug ("history: switch");
+    guint64 old_size = SIZE_HEAP_NODE (priv, pos).size;
+    guint64 size = g_paste_item_get_size (g_sequence_get (elem));
 
-    g_signal_emit (self,
-                   signals[SWITCH],
-                   0, /* detail */
-                   name,
-                   NULL);
+    SIZE_HEAP_NODE (priv, pos).size = size;
+
+    if (size > old_size)
+        g_paste_history_private_size_heap_sift_up (priv, pos);
+    else if (size < old_size)
+        g_paste_history_private_size_heap_sift_down (priv, pos);
 }
 
 static void
-g_paste_history_update (GPasteHistory     *self,
-                        GPasteUpdateAction action,
-                        GPasteUpdateTarget target,
-                        guint64            position)
+g_paste_history_private_size_heap_insert (GPasteHistoryPrivate *priv,
+                                          GSequenceIter        *elem)
 {
-    g_paste_history_save (self, NULL);
+    if (g_hash_table_contains (priv->size_heap_index, elem))
+    {
+        g_paste_history_private_size_heap_update (priv, elem);
+        return;
+    }
 
-    g_debug ("history: update");
+    GPasteHistorySizeNode node = { elem, g_paste_item_get_size (g_sequence_get (elem)) };
 
-    g_signal_emit (self,
-                   signals[UPDATE],
-                   0, /* detail */
-                   action,
-                   target,
-                   position,
-                   NULL);
+    g_array_append_val (priv->size_heap, node);
+    g_paste_history_private_size_heap_sift_up (priv, priv->size_heap->len - 1);
 }
 
 static void
-g_paste_history_activate_first (GPasteHistory *self,
-                                gboolean       select)
+g_paste_history_private_size_heap_remove (GPasteHistoryPrivate *priv,
+                                          GSequenceIter        *elem)
 {
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
-    GList *history = priv->history;
+    guint pos = GPOINTER_TO_UINT (g_hash_table_lookup (priv->size_heap_index, elem));
 
-    if (!history)
+    if (!pos--)
         return;
 
-    GPasteItem *first = history->data;
+    g_hash_table_remove (priv->size_heap_index, elem);
 
-    priv->size -= g_paste_item_get_size (first);
-    g_paste_item_set_state (first, G_PASTE_ITEM_STATE_ACTIVE);
-    priv->size += g_paste_item_get_size (first);
+    guint last = priv->size_heap->len - 1;
 
-    if (select)
-        g_paste_history_selected (self, first);
+    if (pos != last)
+    {
+        guint64 removed_size = SIZE_HEAP_NODE (priv, pos).size;
+        GPasteHistorySizeNode node = SIZE_HEAP_NODE (priv, last);
+
+        g_array_set_size (priv->size_heap, last);
+        g_paste_history_private_size_heap_set (priv, pos, node);
+
+        if (node.size > removed_size)
+            g_paste_history_private_size_heap_sift_up (priv, pos);
+        else
+            g_paste_history_private_size_heap_sift_down (priv, pos);
+    }
+    else
+    {
+        g_array_set_size (priv->size_heap, last);
+    }
 }
 
-static GList *
-g_paste_history_private_get_item_by_uuid (const GPasteHistoryPrivate *priv,
-                                          const gchar                *uuid,
-                                          guint64                    *index)
+static GSequenceIter *
+g_paste_history_private_size_heap_get_biggest (const GPasteHistoryPrivate *priv)
 {
-    guint64 idx = 0;
+    return (priv->size_heap->len) ? SIZE_HEAP_NODE (priv, 0).elem : NULL;
+}
+
+#define G_PASTE_HISTORY_REGEX_CACHE_SIZE 8
+
+typedef struct
+{
+    gchar  *pattern;
+    GRegex *regex;
+} GPasteHistoryCachedRegex;
+
+static void
+g_paste_history_cached_regex_free (gpointer data)
+{
+    GPasteHistoryCachedRegex *cached = data;
+
+    g_free (cached->pattern);
+    g_regex_unref (cached->regex);
+    g_free (cached);
+}
 
-    for (GList *history = priv->history; history; history = history->next, ++idx)
+/* Searches tend to be repeated (paging through results, refreshing a view), don't compile them each time */
+static GRegex *
+g_paste_history_private_get_regex (GPasteHistoryPrivate *priv,
+                                   const gchar          *pattern,
+                                   GError              **error)
+{
+    for (GList *l = priv->regex_cache->head; l; l = g_list_next (l))
     {
-        const GPasteItem *item = history->data;
+        GPasteHistoryCachedRegex *cached = l->data;
 
-        if (g_paste_str_equal (g_paste_item_get_uuid (item), uuid))
+        if (g_paste_str_equal (cached->pattern, pattern))
         {
-            if (index)
-                *index = idx;
-            return history;
+            if (l != priv->regex_cache->head)
+            {
+                g_queue_unlink (priv->regex_cache, l);
+                g_queue_push_head_link (priv->regex_cache, l);
+            }
+            return g_regex_ref (cached->regex);
         }
     }
 
-    return NULL;
+    GRegex *regex = g_regex_new (pattern,
+                                 G_REGEX_CASELESS|G_REGEX_MULTILINE|G_REGEX_DOTALL|G_REGEX_OPTIMIZE,
+                                 G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY,
+                                 error);
+
+    if (!regex)
+        return NULL;
+
+    GPasteHistoryCachedRegex *cached = g_new (GPasteHistoryCachedRegex, 1);
+
+    cached->pattern = g_strdup (pattern);
+    cached->regex = g_regex_ref (regex);
+    g_queue_push_head (priv->regex_cache, cached);
+
+    if (priv->regex_cache->length > G_PASTE_HISTORY_REGEX_CACHE_SIZE)
+        g_paste_history_cached_regex_free (g_queue_pop_tail (priv->regex_cache));
+
+    return regex;
 }
 
-static GPasteItem *
-g_paste_history_private_get_by_uuid (const GPasteHistoryPrivate *priv,
-                                     const gchar                *uuid)
+static void
+g_paste_history_private_invalidate_list (GPasteHistoryPrivate *priv)
 {
-    GList *item = g_paste_history_private_get_item_by_uuid (priv, uuid, NULL);
-
-    return (item) ? item->data : NULL;
+    g_clear_pointer (&priv->history_list, g_list_free);
+    priv->history_list_valid = FALSE;
 }
 
 static void
-g_paste_history_private_check_memory_usage (GPasteHistoryPrivate *priv)
+g_paste_history_private_search_index_item (GPasteHistoryPrivate *priv,
+                                           GSequenceIter        *elem)
 {
-    guint64 max_memory = g_paste_settings_get_max_memory_usage (priv->settings) * 1024 * 1024;
+    const GPasteItem *item = g_sequence_get (elem);
+    const gchar *value = g_paste_item_get_value (item);
 
-    while (priv->size > max_memory && priv->biggest_uuid)
+    if (_G_PASTE_IS_PASSWORD_ITEM (item))
     {
-        GList *biggest = g_paste_history_private_get_item_by_uuid (priv, priv->biggest_uuid, NULL);
-
-        g_return_if_fail (biggest);
+        /* Passwords can also be found by name */
+        const gchar *name = g_paste_password_item_get_name (_G_PASTE_PASSWORD_ITEM (item));
+        g_autofree gchar *text = g_strjoin ("\n", value, name, NULL);
 
-        g_paste_history_private_remove (priv, biggest, TRUE);
-        g_paste_history_private_elect_new_biggest (priv);
+        g_paste_search_index_add (priv->search_index, elem, text);
+    }
+    else
+    {
+        g_paste_search_index_add (priv->search_index, elem, value);
     }
 }
 
 static void
-g_paste_history_private_check_size (GPasteHistoryPrivate *priv)
+g_paste_history_private_index_item (GPasteHistoryPrivate *priv,
+                                    GSequenceIter        *elem)
 {
-    GList *history = priv->history;
-    guint64 max_history_size = g_paste_settings_get_max_history_size (priv->settings);
-    guint64 length = g_list_length (history);
+    GPasteItem *item = g_sequence_get (elem);
 
-    if (length > max_history_size)
-    {
-        history = g_list_nth (history, max_history_size);
-        g_return_if_fail (history);
-        history->prev->next = NULL;
-        history->prev = NULL;
-
-        for (GList *_history = history; _history; _history = g_list_next (_history))
-            priv->size -= g_paste_item_get_size (_history->data);
-        g_list_free_full (history,
-                          g_object_unref);
-    }
-}
+    /* Every item entering the history goes through here, compute its preview once and for all */
+    g_paste_item_set_preview_size (item, g_paste_settings_get_element_size (priv->settings));
 
-static gboolean
-g_paste_history_private_is_growing_line (GPasteHistoryPrivate *priv,
-                                         GPasteItem           *old,
-                                         GPasteItem           *new)
-{
-    if (_G_PASTE_IS_IMAGE_ITEM (old) && _G_PASTE_IS_IMAGE_ITEM (new))
-        return g_paste_image_item_is_growing (_G_PASTE_IMAGE_ITEM (new), _G_PASTE_IMAGE_ITEM (old));
+    g_hash_table_insert (priv->uuid_index, (gpointer) g_paste_item_get_uuid (item), elem);
+    g_paste_history_private_search_index_item (priv, elem);
 
-    if (!(g_paste_settings_get_growing_lines (priv->settings) &&
-        _G_PASTE_IS_TEXT_ITEM (old) && _G_PASTE_IS_TEXT_ITEM (new) &&
-        !_G_PASTE_IS_PASSWORD_ITEM (old) && !_G_PASTE_IS_PASSWORD_ITEM (new)))
-            return FALSE;
+    /* Passwords are never equal to anything, no need to track them for dedup */
+    if (_G_PASTE_IS_PASSWORD_ITEM (item))
+        return;
 
-    const gchar *n = g_paste_item_get_value (new);
-    const gchar *o = g_paste_item_get_value (old);
+    guint64 hash = g_paste_item_get_hash (item);
+    GPtrArray *bucket = g_hash_table_lookup (priv->hash_index, &hash);
 
-    return (g_str_has_prefix (n, o) || g_str_has_suffix (n, o));
+    if (!bucket)
+    {
+        bucket = g_ptr_array_sized_new (1);
+        g_hash_table_insert (priv->hash_index, g_memdup (&hash, sizeof (guint64)), bucket);
+    }
+
+    g_ptr_array_add (bucket, elem);
 }
 
 static void
-_g_paste_history_add (GPasteHistory *self,
-                      GPasteItem    *item,
-                      gboolean       new_selection)
+g_paste_history_private_unindex_item (GPasteHistoryPrivate *priv,
+                                      GSequenceIter        *elem)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (_G_PASTE_IS_ITEM (item));
+    const GPasteItem *item = g_sequence_get (elem);
 
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
-    guint64 max_memory = g_paste_settings_get_max_memory_usage (priv->settings) * 1024 * 1024;
+    g_hash_table_remove (priv->uuid_index, g_paste_item_get_uuid (item));
+    g_paste_search_index_remove (priv->search_index, elem);
 
-    if (g_paste_item_get_size (item) > max_memory)
-        return;
+    guint64 hash = g_paste_item_get_hash (item);
+    GPtrArray *bucket = g_hash_table_lookup (priv->hash_index, &hash);
 
-    GList *history = priv->history;
-    gboolean election_needed = FALSE;
-    GPasteUpdateTarget target = G_PASTE_UPDATE_TARGET_ALL;
+    if (bucket && g_ptr_array_remove_fast (bucket, elem) && !bucket->len)
+        g_hash_table_remove (priv->hash_index, &hash);
+}
 
-    g_debug ("history: add");
+static GSequenceIter *
+g_paste_history_private_lookup_equal (const GPasteHistoryPrivate *priv,
+                                      const GPasteItem           *item)
+{
+    guint64 hash = g_paste_item_get_hash (item);
+    const GPtrArray *bucket = g_hash_table_lookup (priv->hash_index, &hash);
 
-    if (history)
-    {
-        GPasteItem *old_first = history->data;
+    if (!bucket)
+        return NULL;
 
-        if (g_paste_item_equals (old_first, item))
-            return;
+    for (guint i = 0; i < bucket->len; ++i)
+    {
+        GSequenceIter *elem = g_ptr_array_index (bucket, i);
 
-        if (new_selection && g_paste_history_private_is_growing_line (priv, old_first, item))
-        {
-            target = G_PASTE_UPDATE_TARGET_POSITION;
-            g_paste_history_private_remove (priv, history, FALSE);
-        }
-        else
-        {
-            /* size may change when state is idle */
-            priv->size -= g_paste_item_get_size (old_first);
-            g_paste_item_set_state (old_first, G_PASTE_ITEM_STATE_IDLE);
+        if (g_paste_item_equals (g_sequence_get (elem), item))
+            return elem;
+    }
 
-            guint64 size = g_paste_item_get_size (old_first);
+    return NULL;
+}
 
-            priv->size += size;
+static void
+g_paste_history_private_rebuild_index (GPasteHistoryPrivate *priv)
+{
+    g_hash_table_remove_all (priv->uuid_index);
+    g_hash_table_remove_all (priv->hash_index);
+    g_paste_search_index_clear (priv->search_index);
+    g_hash_table_remove_all (priv->size_heap_index);
+    g_array_set_size (priv->size_heap, 0);
 
-            if (size >= priv->biggest_size)
-            {
-                priv->biggest_uuid = g_paste_item_get_uuid (old_first);
-                priv->biggest_size = size;
-            }
+    GSequenceIter *first = g_sequence_get_begin_iter (priv->history);
 
-            for (history = history->next; history; history = history->next)
-            {
-                if (g_paste_item_equals (history->data, item) || (new_selection && g_paste_history_private_is_growing_line (priv, history->data, item)))
-                {
-                    if (g_paste_str_equal (priv->biggest_uuid, g_paste_item_get_uuid (history->data)))
-                        election_needed = TRUE;
-                    g_paste_history_private_remove (priv, history, FALSE);
-                    break;
-                }
-            }
-        }
+    for (GSequenceIter *history = first; !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+    {
+        g_paste_history_private_index_item (priv, history);
+        if (history != first)
+            g_paste_history_private_size_heap_insert (priv, history);
     }
+}
 
-    priv->history = g_list_prepend (priv->history, item);
+static GPasteItem *
+g_paste_history_private_get_first (const GPasteHistoryPrivate *priv)
+{
+    GSequenceIter *first = g_sequence_get_begin_iter (priv->history);
 
-    g_paste_history_activate_first (self, FALSE);
-    priv->size += g_paste_item_get_size (item);
+    return (g_sequence_iter_is_end (first)) ? NULL : g_sequence_get (first);
+}
 
-    g_paste_history_private_check_size (priv);
+/* How many changes we keep around for g_paste_history_get_changes_since */
+#define G_PASTE_HISTORY_MAX_CHANGES 512
 
-    if (election_needed)
-        g_paste_history_private_elect_new_biggest (priv);
+static void
+g_paste_history_change_free (gpointer data)
+{
+    GPasteHistoryChange *change = data;
 
-    g_paste_history_private_check_memory_usage (priv);
-    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, target, 0);
+    g_free (change->uuid);
+    g_free (change);
 }
 
-/**
- * g_paste_history_add:
- * @self: a #GPasteHistory instance
- * @item: (transfer full): the #GPasteItem to add
- *
- * Add a #GPasteItem to the #GPasteHistory
- */
-G_PASTE_VISIBLE void
-g_paste_history_add (GPasteHistory *self,
-                     GPasteItem    *item)
+static void
+g_paste_history_changes_clear (GQueue *changes)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (_G_PASTE_IS_ITEM (item));
-
-    _g_paste_history_add (self, item, TRUE);
+    g_queue_foreach (changes, (GFunc) g_paste_history_change_free, NULL);
+    g_queue_clear (changes);
 }
 
 static void
-g_paste_history_remove_common (GPasteHistory        *self,
-                               GPasteHistoryPrivate *priv,
-                               GList                *item,
-                               guint64               index)
+g_paste_history_private_record_change (GPasteHistoryPrivate *priv,
+                                       GPasteChangeKind      kind,
+                                       guint64               position,
+                                       const gchar          *uuid)
 {
-    if (!item)
-        return;
+    GQueue *pending = priv->pending_changes;
 
-    gboolean was_biggest = g_paste_str_equal (priv->biggest_uuid, g_paste_item_get_uuid (item->data));
+    if (kind == G_PASTE_CHANGE_KIND_RESET)
+    {
+        /* Nothing that happened before matters anymore */
+        g_paste_history_changes_clear (pending);
+    }
+    else if (!g_queue_is_empty (pending))
+    {
+        const GPasteHistoryChange *first = g_queue_peek_head (pending);
+        GPasteHistoryChange *last = g_queue_peek_tail (pending);
 
-    g_paste_history_private_remove (priv, item, TRUE);
+        /* Everything will be fetched again anyway */
+        if (first->kind == G_PASTE_CHANGE_KIND_RESET)
+            return;
 
-    if (!index)
-        g_paste_history_activate_first (self, TRUE);
+        /* An item removed and put right back was just moved */
+        if (kind == G_PASTE_CHANGE_KIND_INSERT && last->kind == G_PASTE_CHANGE_KIND_REMOVE && g_paste_str_equal (last->uuid, uuid))
+        {
+            last->kind = G_PASTE_CHANGE_KIND_MOVE;
+            last->old_position = last->position;
+            last->position = position;
+            return;
+        }
+    }
 
-    if (was_biggest)
-        g_paste_history_private_elect_new_biggest (priv);
+    GPasteHistoryChange *change = g_new (GPasteHistoryChange, 1);
 
-    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REMOVE, G_PASTE_UPDATE_TARGET_POSITION, index);
+    change->seq = 0; /* Set when announced */
+    change->kind = kind;
+    change->position = position;
+    change->old_position = position;
+    change->uuid = g_strdup (uuid);
+
+    g_queue_push_tail (pending, change);
 }
 
-/**
- * g_paste_history_remove:
- * @self: a #GPasteHistory instance
- * @index: the index of the #GPasteItem to delete
- *
- * Delete a #GPasteItem from the #GPasteHistory
- */
-G_PASTE_VISIBLE void
-g_paste_history_remove (GPasteHistory *self,
-                        guint64        index)
+static GSequenceIter *
+g_paste_history_private_prepend (GPasteHistoryPrivate *priv,
+                                 GPasteItem           *item)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
-    GList *history = priv->history;
+    GSequenceIter *elem = g_sequence_prepend (priv->history, item);
 
-    g_debug ("history: remove '%" G_GUINT64_FORMAT "'", index);
+    g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_INSERT, 0, g_paste_item_get_uuid (item));
+    ++priv->length;
+    g_paste_history_private_index_item (priv, elem);
+    g_paste_history_private_invalidate_list (priv);
 
-    if (index >= g_list_length (history))
-        return;
+    return elem;
+}
 
-    GList *item = g_list_nth (history, index);
+static void
+g_paste_history_private_clear (GPasteHistoryPrivate *priv)
+{
+    g_hash_table_remove_all (priv->uuid_index);
+    g_hash_table_remove_all (priv->hash_index);
+    g_paste_search_index_clear (priv->search_index);
+    g_hash_table_remove_all (priv->size_heap_index);
+    g_array_set_size (priv->size_heap, 0);
+    g_paste_history_private_invalidate_list (priv);
+
+    for (GSequenceIter *history = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+        g_object_unref (g_sequence_get (history));
+    g_sequence_remove_range (g_sequence_get_begin_iter (priv->history), g_sequence_get_end_iter (priv->history));
+
+    priv->length = 0;
+    priv->size = 0;
 
-    g_paste_history_remove_common (self, priv, item, index);
+    g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_RESET, 0, NULL);
 }
 
-/**
- * g_paste_history_remove_by_uuid:
- * @self: a #GPasteHistory instance
- * @uuid: the uuid of the #GPasteItem to delete
- *
- * Delete a #GPasteItem from the #GPasteHistory
- *
- * Returns: whether we removed anything
- */
-G_PASTE_VISIBLE gboolean
-g_paste_history_remove_by_uuid (GPasteHistory *self,
-                                const gchar   *uuid)
+static void
+g_paste_history_private_remove (GPasteHistoryPrivate *priv,
+                                GSequenceIter        *elem,
+                                gboolean              remove_leftovers)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), FALSE);
-
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    if (!elem)
+        return;
 
-    g_debug ("history: remove '%s", uuid);
+    GPasteItem *item = g_sequence_get (elem);
 
-    guint64 index;
-    GList *item = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
+    g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_REMOVE, g_sequence_iter_get_position (elem), g_paste_item_get_uuid (item));
 
-    if (!item)
-        return FALSE;
+    priv->size -= g_paste_item_get_size (item);
+    g_paste_history_private_unindex_item (priv, elem);
+    g_paste_history_private_size_heap_remove (priv, elem);
 
-    g_paste_history_remove_common (self, priv, item, index);
-    return TRUE;
+    if (remove_leftovers)
+    {
+        if (_G_PASTE_IS_IMAGE_ITEM (item))
+        {
+            g_autoptr (GFile) image = g_file_new_for_path (g_paste_item_get_value (item));
+            g_file_delete (image,
+                           NULL, /* cancellable */
+                           NULL); /* error */
+        }
+        g_object_unref (item);
+    }
+    g_sequence_remove (elem);
+    --priv->length;
+    g_paste_history_private_invalidate_list (priv);
 }
-/**
- * g_paste_history_refresh_item_size:
- * @self: a #GPasteHistory instance
- * @item: the #GPasteItem to refresh
- * @old_size: the former size of the item
- *
- * Refresh the cached size of the #GPasteItem
- */
-G_PASTE_VISIBLE void
-g_paste_history_refresh_item_size (GPasteHistory    *self,
-                                   const GPasteItem *item,
-                                   guint64           old_size)
+
+static void
+g_paste_history_selected (GPasteHistory *self,
+                          GPasteItem    *item)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (_G_PASTE_IS_ITEM (item));
+    g_debug ("history: selected");
 
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    g_signal_emit (self,
+                   signals[SELECTED],
+                   0, /* detail */
+                   item,
+                   NULL);
+}
 
-    if (!g_list_find (priv->history, item))
-        return;
+static void
+g_paste_history_emit_switch (GPasteHistory *self,
+                             const gchar   *name)
+{
+    g_debug ("history: switch");
 
-    guint64 size = g_paste_item_get_size (item);
+    g_signal_emit (self,
+                   signals[SWITCH],
+                   0, /* detail */
+                   name,
+                   NULL);
+}
 
-    g_return_if_fail (old_size <= size);
+/***************************/
+/* Begin background saving */
+/***************************/
 
-    priv->size += (size - old_size);
+typedef struct
+{
+    GPasteStorageBackend *backend;
+    gchar                *name;
+    GList                *history;
+} GPasteHistorySnapshot;
 
-    if (size > priv->biggest_size)
-        g_paste_history_private_elect_new_biggest (priv);
+static void
+g_paste_history_snapshot_free (gpointer data)
+{
+    GPasteHistorySnapshot *snapshot = data;
 
-    g_paste_history_private_check_memory_usage (priv);
+    g_object_unref (snapshot->backend);
+    g_free (snapshot->name);
+    g_list_free_full (snapshot->history, g_object_unref);
+    g_free (snapshot);
 }
 
-static GPasteItem *
-g_paste_history_private_get (const GPasteHistoryPrivate *priv,
-                             guint64                     index)
+static void
+g_paste_history_private_wait_for_save (GPasteHistoryPrivate *priv)
 {
-    GList *history = priv->history;
-
-    if (index >= g_list_length (history))
-        return NULL;
-
-    return G_PASTE_ITEM (g_list_nth_data (history, index));
+    g_mutex_lock (&priv->save_mutex);
+    while (priv->saving)
+        g_cond_wait (&priv->save_cond, &priv->save_mutex);
+    g_mutex_unlock (&priv->save_mutex);
 }
 
-/**
- * g_paste_history_get:
- * @self: a #GPasteHistory instance
- * @index: the index of the #GPasteItem
- *
- * Get a #GPasteItem from the #GPasteHistory
- *
- * Returns: a read-only #GPasteItem
- */
-G_PASTE_VISIBLE const GPasteItem *
-g_paste_history_get (GPasteHistory *self,
-                     guint64        index)
+static void
+g_paste_history_private_cancel_save (GPasteHistoryPrivate *priv)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
-
-    return g_paste_history_private_get (_g_paste_history_get_instance_private (self), index);
+    if (priv->save_source)
+    {
+        g_source_remove (priv->save_source);
+        priv->save_source = 0;
+    }
 }
 
-/**
- * g_paste_history_get_by_uuid:
- * @self: a #GPasteHistory instance
- * @uuid: the uuid of the #GPasteItem
- *
- * Get a #GPasteItem from the #GPasteHistory
- *
- * Returns: a read-only #GPasteItem
- */
-G_PASTE_VISIBLE const GPasteItem *
-g_paste_history_get_by_uuid (GPasteHistory *self,
-                             const gchar   *uuid)
+static void
+g_paste_history_save_thread (GTask        *task G_GNUC_UNUSED,
+                             gpointer      source_object,
+                             gpointer      task_data,
+                             GCancellable *cancellable G_GNUC_UNUSED)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (G_PASTE_HISTORY (source_object));
+    const GPasteHistorySnapshot *snapshot = task_data;
 
-    return g_paste_history_private_get_by_uuid (_g_paste_history_get_instance_private (self), uuid);
+    /* g_file_replace writes to a temporary file and renames it over the old one on close */
+    g_paste_storage_backend_write_history (snapshot->backend, snapshot->name, snapshot->history);
+
+    g_mutex_lock (&priv->save_mutex);
+    priv->saving = FALSE;
+    g_cond_broadcast (&priv->save_cond);
+    g_mutex_unlock (&priv->save_mutex);
 }
 
-/**
- * g_paste_history_dup:
- * @self: a #GPasteHistory instance
- * @index: the index of the #GPasteItem
- *
- * Get a #GPasteItem from the #GPasteHistory
- * free it with g_object_unref
- *
- * Returns: (transfer full): a #GPasteItem
- */
-G_PASTE_VISIBLE GPasteItem *
-g_paste_history_dup (GPasteHistory *self,
-                     guint64        index)
+static void
+g_paste_history_save_done (GObject      *source_object G_GNUC_UNUSED,
+                           GAsyncResult *res G_GNUC_UNUSED,
+                           gpointer      user_data G_GNUC_UNUSED)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
-
-    return g_object_ref (g_paste_history_private_get (_g_paste_history_get_instance_private (self), index));
+    g_debug ("history: saved");
 }
 
-/**
- * g_paste_history_select:
- * @self: a #GPasteHistory instance
- * @uuid: the uuid of the #GPasteItem to select
- *
- * Select a #GPasteItem from the #GPasteHistory
- *
- * Returns: whether the item could be selected
- */
-G_PASTE_VISIBLE gboolean
-g_paste_history_select (GPasteHistory *self,
-                        const gchar   *uuid)
+static gboolean
+g_paste_history_save_timeout (gpointer user_data)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), FALSE);
-    g_debug ("history: select '%s'", uuid);
+    GPasteHistory *self = user_data;
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
 
-    GPasteItem *item = g_paste_history_private_get_by_uuid (_g_paste_history_get_instance_private (self), uuid);
+    g_mutex_lock (&priv->save_mutex);
+    gboolean busy = priv->saving;
+    priv->saving = TRUE;
+    g_mutex_unlock (&priv->save_mutex);
 
-    if (!item)
-        return FALSE;
+    /* Only one write at a time, the next one will include everything anyway */
+    if (busy)
+        return G_SOURCE_CONTINUE;
 
-    _g_paste_history_add (self, item, FALSE);
-    g_paste_history_selected (self, item);
-    return TRUE;
+    priv->save_source = 0;
+
+    GPasteHistorySnapshot *snapshot = g_new (GPasteHistorySnapshot, 1);
+
+    snapshot->backend = g_object_ref (priv->backend);
+    snapshot->name = g_strdup (priv->name);
+    snapshot->history = g_list_copy_deep ((GList *) g_paste_history_get_history (self), (GCopyFunc) g_object_ref, NULL);
+
+    g_autoptr (GTask) task = g_task_new (self, NULL, g_paste_history_save_done, NULL);
+
+    g_task_set_task_data (task, snapshot, g_paste_history_snapshot_free);
+    g_task_run_in_thread (task, g_paste_history_save_thread);
+
+    return G_SOURCE_REMOVE;
 }
 
 static void
-_g_paste_history_replace (GPasteHistory *self,
-                          guint64        index,
-                          GPasteItem    *new,
-                          GList         *todel)
+g_paste_history_schedule_save (GPasteHistory *self)
 {
     GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
-    GPasteItem *old = todel->data;
-    gboolean was_biggest = g_paste_str_equal (priv->biggest_uuid, g_paste_item_get_uuid (old));
-
-    priv->size -= g_paste_item_get_size (old);
-    priv->size += g_paste_item_get_size (new);
-
-    g_object_unref (old);
-    todel->data = new;
+    guint64 delay = g_paste_settings_get_save_delay (priv->settings);
 
-    if (was_biggest)
-        g_paste_history_private_elect_new_biggest (priv);
+    if (!delay)
+    {
+        g_paste_history_save (self, NULL);
+        return;
+    }
 
-    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_POSITION, index);
+    /* Coalesce all the changes happening within the delay */
+    if (!priv->save_source)
+    {
+        priv->save_source = g_timeout_add (delay, g_paste_history_save_timeout, self);
+        g_source_set_name_by_id (priv->save_source, "[GPaste] history save");
+    }
 }
 
-/**
- * g_paste_history_replace:
- * @self: a #GPasteHistory instance
- * @uuid: the uuid of the #GPasteTextItem to replace
- * @contents: the new contents
- *
- * Replace the contents of text item at index @index
- */
-G_PASTE_VISIBLE void
-g_paste_history_replace (GPasteHistory *self,
-                         const gchar   *uuid,
-                         const gchar   *contents)
-{
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (!contents || g_utf8_validate (contents, -1, NULL));
+/*************************/
+/* End background saving */
+/*************************/
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    guint64 index;
-    GList *todel = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
+/* Announce everything recorded since last time as one batch */
+static void
+g_paste_history_commit_changes (GPasteHistory *self)
+{
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    GPasteHistoryChange *change = g_queue_peek_head (priv->pending_changes);
 
-    if (!todel)
+    if (!change || priv->frozen)
         return;
 
-    GPasteItem *item = todel->data;
+    ++priv->seq;
 
-    g_return_if_fail (_G_PASTE_IS_TEXT_ITEM (item) && g_paste_str_equal (g_paste_item_get_kind (item), "Text"));
+    if (change->kind == G_PASTE_CHANGE_KIND_RESET)
+    {
+        g_paste_history_changes_clear (priv->changes);
+        priv->changes_floor = priv->seq - 1;
+    }
 
-    GPasteItem *new = g_paste_text_item_new (contents);
+    while ((change = g_queue_pop_head (priv->pending_changes)))
+    {
+        change->seq = priv->seq;
+        g_queue_push_tail (priv->changes, change);
+    }
 
-    _g_paste_history_replace (self, index, new, todel);
+    while (g_queue_get_length (priv->changes) > G_PASTE_HISTORY_MAX_CHANGES)
+    {
+        change = g_queue_pop_head (priv->changes);
+        priv->changes_floor = change->seq;
+        g_paste_history_change_free (change);
+    }
 
-    if (!index)
-        g_paste_history_selected (self, new);
+    g_debug ("history: changed (%" G_GUINT64_FORMAT ")", priv->seq);
+
+    g_signal_emit (self,
+                   signals[CHANGED],
+                   0, /* detail */
+                   priv->seq,
+                   NULL);
 }
 
-static GPasteItem *
-_g_paste_history_private_get_password (const GPasteHistoryPrivate *priv,
-                                       const gchar                *name,
-                                       guint64                    *index)
+static void
+g_paste_history_update (GPasteHistory     *self,
+                        GPasteUpdateAction action,
+                        GPasteUpdateTarget target,
+                        guint64            position)
 {
-    guint64 idx = 0;
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
 
-    for (GList *h = priv->history; h; h = g_list_next (h), ++idx)
+    if (priv->frozen)
     {
-        GPasteItem *i = h->data;
-        if (_G_PASTE_IS_PASSWORD_ITEM (i) &&
-            g_paste_str_equal (g_paste_password_item_get_name ((GPastePasswordItem *) i), name))
+        /* Several updates can only be described as a whole new history */
+        if (priv->update_pending)
         {
-            if (index)
-                *index = idx;
-            return i;
+            action = G_PASTE_UPDATE_ACTION_REPLACE;
+            target = G_PASTE_UPDATE_TARGET_ALL;
+            position = 0;
         }
+
+        priv->update_pending = TRUE;
+        priv->pending_action = action;
+        priv->pending_target = target;
+        priv->pending_position = position;
+        return;
     }
 
-    if (index)
-        *index = -1;
-    return NULL;
+    g_paste_history_schedule_save (self);
+    g_paste_history_commit_changes (self);
+
+    g_debug ("history: update");
+
+    g_signal_emit (self,
+                   signals[UPDATE],
+                   0, /* detail */
+                   action,
+                   target,
+                   position,
+                   NULL);
+}
+
+static void
+g_paste_history_activate_first (GPasteHistory *self,
+                                gboolean       select)
+{
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    GPasteItem *first = g_paste_history_private_get_first (priv);
+
+    if (!first)
+        return;
+
+    g_paste_history_private_size_heap_remove (priv, g_sequence_get_begin_iter (priv->history));
+
+    priv->size -= g_paste_item_get_size (first);
+    g_paste_item_set_state (first, G_PASTE_ITEM_STATE_ACTIVE);
+    priv->size += g_paste_item_get_size (first);
+
+    if (select)
+        g_paste_history_selected (self, first);
+}
+
+static GSequenceIter *
+g_paste_history_private_get_item_by_uuid (const GPasteHistoryPrivate *priv,
+                                          const gchar                *uuid,
+                                          guint64                    *index)
+{
+    if (!uuid)
+        return NULL;
+
+    GSequenceIter *history = g_hash_table_lookup (priv->uuid_index, uuid);
+
+    if (history && index)
+        *index = g_sequence_iter_get_position (history);
+
+    return history;
+}
+
+static GPasteItem *
+g_paste_history_private_get_by_uuid (const GPasteHistoryPrivate *priv,
+                                     const gchar                *uuid)
+{
+    GSequenceIter *item = g_paste_history_private_get_item_by_uuid (priv, uuid, NULL);
+
+    return (item) ? g_sequence_get (item) : NULL;
+}
+
+static void
+g_paste_history_private_check_memory_usage (GPasteHistoryPrivate *priv)
+{
+    guint64 max_memory = g_paste_settings_get_max_memory_usage (priv->settings) * 1024 * 1024;
+
+    GSequenceIter *biggest;
+
+    while (priv->size > max_memory && (biggest = g_paste_history_private_size_heap_get_biggest (priv)))
+        g_paste_history_private_remove (priv, biggest, TRUE);
+}
+
+static void
+g_paste_history_private_check_size (GPasteHistoryPrivate *priv)
+{
+    guint64 max_history_size = g_paste_settings_get_max_history_size (priv->settings);
+
+    if (priv->length > max_history_size)
+    {
+        GSequenceIter *history = g_sequence_get_iter_at_pos (priv->history, max_history_size);
+
+        while (!g_sequence_iter_is_end (history))
+        {
+            GSequenceIter *next = g_sequence_iter_next (history);
+            GPasteItem *item = g_sequence_get (history);
+
+            g_paste_history_private_remove (priv, history, FALSE);
+            g_object_unref (item);
+            history = next;
+        }
+    }
+}
+
+static gboolean
+g_paste_history_private_is_growing_line (GPasteHistoryPrivate *priv,
+                                         GPasteItem           *old,
+                                         GPasteItem           *new)
+{
+    if (_G_PASTE_IS_IMAGE_ITEM (old) && _G_PASTE_IS_IMAGE_ITEM (new))
+        return g_paste_image_item_is_growing (_G_PASTE_IMAGE_ITEM (new), _G_PASTE_IMAGE_ITEM (old));
+
+    if (!(g_paste_settings_get_growing_lines (priv->settings) &&
+        _G_PASTE_IS_TEXT_ITEM (old) && _G_PASTE_IS_TEXT_ITEM (new) &&
+        !_G_PASTE_IS_PASSWORD_ITEM (old) && !_G_PASTE_IS_PASSWORD_ITEM (new)))
+            return FALSE;
+
+    const gchar *n = g_paste_item_get_value (new);
+    const gchar *o = g_paste_item_get_value (old);
+
+    return (g_str_has_prefix (n, o) || g_str_has_suffix (n, o));
+}
+
+static void
+_g_paste_history_add (GPasteHistory *self,
+                      GPasteItem    *item,
+                      gboolean       new_selection)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (_G_PASTE_IS_ITEM (item));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    guint64 max_memory = g_paste_settings_get_max_memory_usage (priv->settings) * 1024 * 1024;
+
+    if (g_paste_item_get_size (item) > max_memory)
+        return;
+
+    GSequenceIter *history = g_sequence_get_begin_iter (priv->history);
+    GPasteUpdateTarget target = G_PASTE_UPDATE_TARGET_ALL;
+
+    g_debug ("history: add");
+
+    if (!g_sequence_iter_is_end (history))
+    {
+        GPasteItem *old_first = g_sequence_get (history);
+
+        if (g_paste_item_equals (old_first, item))
+            return;
+
+        if (new_selection && g_paste_history_private_is_growing_line (priv, old_first, item))
+        {
+            target = G_PASTE_UPDATE_TARGET_POSITION;
+            g_paste_history_private_remove (priv, history, FALSE);
+        }
+        else
+        {
+            /* size may change when state is idle */
+            priv->size -= g_paste_item_get_size (old_first);
+            g_paste_item_set_state (old_first, G_PASTE_ITEM_STATE_IDLE);
+
+            priv->size += g_paste_item_get_size (old_first);
+            g_paste_history_private_size_heap_insert (priv, history);
+
+            /* Selecting an item already in history: passwords aren't in the hash index, look it up by identity first */
+            GSequenceIter *match = g_hash_table_lookup (priv->uuid_index, g_paste_item_get_uuid (item));
+
+            if (!match || g_sequence_get (match) != item)
+                match = g_paste_history_private_lookup_equal (priv, item);
+
+            /* Only the first (active) image can be growing, so we only need to scan for text */
+            if (!match && new_selection && g_paste_settings_get_growing_lines (priv->settings) &&
+                _G_PASTE_IS_TEXT_ITEM (item) && !_G_PASTE_IS_PASSWORD_ITEM (item))
+            {
+                for (history = g_sequence_iter_next (history); !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+                {
+                    if (g_paste_history_private_is_growing_line (priv, g_sequence_get (history), item))
+                    {
+                        match = history;
+                        break;
+                    }
+                }
+            }
+
+            if (match)
+                g_paste_history_private_remove (priv, match, FALSE);
+        }
+    }
+
+    g_paste_history_private_prepend (priv, item);
+
+    g_paste_history_activate_first (self, FALSE);
+    priv->size += g_paste_item_get_size (item);
+
+    g_paste_history_private_check_size (priv);
+    g_paste_history_private_check_memory_usage (priv);
+    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, target, 0);
+}
+
+/**
+ * g_paste_history_add:
+ * @self: a #GPasteHistory instance
+ * @item: (transfer full): the #GPasteItem to add
+ *
+ * Add a #GPasteItem to the #GPasteHistory
+ */
+G_PASTE_VISIBLE void
+g_paste_history_add (GPasteHistory *self,
+                     GPasteItem    *item)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (_G_PASTE_IS_ITEM (item));
+
+    _g_paste_history_add (self, item, TRUE);
+}
+
+static void
+g_paste_history_remove_common (GPasteHistory        *self,
+                               GPasteHistoryPrivate *priv,
+                               GSequenceIter        *item,
+                               guint64               index)
+{
+    if (!item)
+        return;
+
+    g_paste_history_private_remove (priv, item, TRUE);
+
+    if (!index)
+        g_paste_history_activate_first (self, TRUE);
+
+    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REMOVE, G_PASTE_UPDATE_TARGET_POSITION, index);
+}
+
+/**
+ * g_paste_history_remove:
+ * @self: a #GPasteHistory instance
+ * @index: the index of the #GPasteItem to delete
+ *
+ * Delete a #GPasteItem from the #GPasteHistory
+ */
+G_PASTE_VISIBLE void
+g_paste_history_remove (GPasteHistory *self,
+                        guint64        index)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    g_debug ("history: remove '%" G_GUINT64_FORMAT "'", index);
+
+    if (index >= priv->length)
+        return;
+
+    GSequenceIter *item = g_sequence_get_iter_at_pos (priv->history, index);
+
+    g_paste_history_remove_common (self, priv, item, index);
+}
+
+/**
+ * g_paste_history_remove_by_uuid:
+ * @self: a #GPasteHistory instance
+ * @uuid: the uuid of the #GPasteItem to delete
+ *
+ * Delete a #GPasteItem from the #GPasteHistory
+ *
+ * Returns: whether we removed anything
+ */
+G_PASTE_VISIBLE gboolean
+g_paste_history_remove_by_uuid (GPasteHistory *self,
+                                const gchar   *uuid)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), FALSE);
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    g_debug ("history: remove '%s", uuid);
+
+    guint64 index;
+    GSequenceIter *item = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
+
+    if (!item)
+        return FALSE;
+
+    g_paste_history_remove_common (self, priv, item, index);
+    return TRUE;
+}
+/**
+ * g_paste_history_refresh_item_size:
+ * @self: a #GPasteHistory instance
+ * @item: the #GPasteItem to refresh
+ * @old_size: the former size of the item
+ *
+ * Refresh the cached size of the #GPasteItem
+ */
+G_PASTE_VISIBLE void
+g_paste_history_refresh_item_size (GPasteHistory    *self,
+                                   const GPasteItem *item,
+                                   guint64           old_size)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (_G_PASTE_IS_ITEM (item));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    GSequenceIter *elem = g_paste_history_private_get_item_by_uuid (priv, g_paste_item_get_uuid (item), NULL);
+
+    if (!elem || g_sequence_get (elem) != item)
+        return;
+
+    guint64 size = g_paste_item_get_size (item);
+
+    g_return_if_fail (old_size <= size);
+
+    priv->size += (size - old_size);
+    g_paste_history_private_size_heap_update (priv, elem);
+
+    g_paste_history_private_check_memory_usage (priv);
+    g_paste_history_commit_changes (self);
+}
+
+static GPasteItem *
+g_paste_history_private_get (const GPasteHistoryPrivate *priv,
+                             guint64                     index)
+{
+    if (index >= priv->length)
+        return NULL;
+
+    return G_PASTE_ITEM (g_sequence_get (g_sequence_get_iter_at_pos (priv->history, index)));
+}
+
+/**
+ * g_paste_history_get:
+ * @self: a #GPasteHistory instance
+ * @index: the index of the #GPasteItem
+ *
+ * Get a #GPasteItem from the #GPasteHistory
+ *
+ * Returns: a read-only #GPasteItem
+ */
+G_PASTE_VISIBLE const GPasteItem *
+g_paste_history_get (GPasteHistory *self,
+                     guint64        index)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+
+    return g_paste_history_private_get (_g_paste_history_get_instance_private (self), index);
+}
+
+/**
+ * g_paste_history_get_by_uuid:
+ * @self: a #GPasteHistory instance
+ * @uuid: the uuid of the #GPasteItem
+ *
+ * Get a #GPasteItem from the #GPasteHistory
+ *
+ * Returns: a read-only #GPasteItem
+ */
+G_PASTE_VISIBLE const GPasteItem *
+g_paste_history_get_by_uuid (GPasteHistory *self,
+                             const gchar   *uuid)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+
+    return g_paste_history_private_get_by_uuid (_g_paste_history_get_instance_private (self), uuid);
+}
+
+/**
+ * g_paste_history_dup:
+ * @self: a #GPasteHistory instance
+ * @index: the index of the #GPasteItem
+ *
+ * Get a #GPasteItem from the #GPasteHistory
+ * free it with g_object_unref
+ *
+ * Returns: (transfer full): a #GPasteItem
+ */
+G_PASTE_VISIBLE GPasteItem *
+g_paste_history_dup (GPasteHistory *self,
+                     guint64        index)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+
+    return g_object_ref (g_paste_history_private_get (_g_paste_history_get_instance_private (self), index));
+}
+
+/**
+ * g_paste_history_select:
+ * @self: a #GPasteHistory instance
+ * @uuid: the uuid of the #GPasteItem to select
+ *
+ * Select a #GPasteItem from the #GPasteHistory
+ *
+ * Returns: whether the item could be selected
+ */
+G_PASTE_VISIBLE gboolean
+g_paste_history_select (GPasteHistory *self,
+                        const gchar   *uuid)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), FALSE);
+    g_debug ("history: select '%s'", uuid);
+
+    GPasteItem *item = g_paste_history_private_get_by_uuid (_g_paste_history_get_instance_private (self), uuid);
+
+    if (!item)
+        return FALSE;
+
+    _g_paste_history_add (self, item, FALSE);
+    g_paste_history_selected (self, item);
+    return TRUE;
+}
+
+static void
+_g_paste_history_replace (GPasteHistory *self,
+                          guint64        index,
+                          GPasteItem    *new,
+                          GSequenceIter *todel)
+{
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    GPasteItem *old = g_sequence_get (todel);
+
+    priv->size -= g_paste_item_get_size (old);
+    priv->size += g_paste_item_get_size (new);
+
+    g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_REMOVE, index, g_paste_item_get_uuid (old));
+    g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_INSERT, index, g_paste_item_get_uuid (new));
+
+    g_paste_history_private_unindex_item (priv, todel);
+    g_object_unref (old);
+    g_sequence_set (todel, new);
+    g_paste_history_private_index_item (priv, todel);
+    g_paste_history_private_invalidate_list (priv);
+    g_paste_history_private_size_heap_update (priv, todel);
+
+    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_POSITION, index);
+}
+
+/**
+ * g_paste_history_replace:
+ * @self: a #GPasteHistory instance
+ * @uuid: the uuid of the #GPasteTextItem to replace
+ * @contents: the new contents
+ *
+ * Replace the contents of text item at index @index
+ */
+G_PASTE_VISIBLE void
+g_paste_history_replace (GPasteHistory *self,
+                         const gchar   *uuid,
+                         const gchar   *contents)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (!contents || g_utf8_validate (contents, -1, NULL));
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    guint64 index;
+    GSequenceIter *todel = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
+
+    if (!todel)
+        return;
+
+    GPasteItem *item = g_sequence_get (todel);
+
+    g_return_if_fail (_G_PASTE_IS_TEXT_ITEM (item) && g_paste_str_equal (g_paste_item_get_kind (item), "Text"));
+
+    GPasteItem *new = g_paste_text_item_new (contents);
+
+    _g_paste_history_replace (self, index, new, todel);
+
+    if (!index)
+        g_paste_history_selected (self, new);
+}
+
+static GPasteItem *
+_g_paste_history_private_get_password (const GPasteHistoryPrivate *priv,
+                                       const gchar                *name,
+                                       guint64                    *index)
+{
+    guint64 idx = 0;
+
+    for (GSequenceIter *h = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (h); h = g_sequence_iter_next (h), ++idx)
+    {
+        GPasteItem *i = g_sequence_get (h);
+        if (_G_PASTE_IS_PASSWORD_ITEM (i) &&
+            g_paste_str_equal (g_paste_password_item_get_name ((GPastePasswordItem *) i), name))
+        {
+            if (index)
+                *index = idx;
+            return i;
+        }
+    }
+
+    if (index)
+        *index = -1;
+    return NULL;
+}
+
+/**
+ * g_paste_history_set_password:
+ * @self: a #GPasteHistory instance
+ * @uuid: the uuid of the #GPasteTextItem to change as password
+ * @name: (nullable): the name to give to the password
+ *
+ * Mark a text item as password
+ */
+G_PASTE_VISIBLE void
+g_paste_history_set_password (GPasteHistory *self,
+                              const gchar   *uuid,
+                              const gchar   *name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    guint64 index;
+    GSequenceIter *todel = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
+
+    g_return_if_fail (todel);
+
+    GPasteItem *item = g_sequence_get (todel);
+
+    g_return_if_fail (_G_PASTE_IS_TEXT_ITEM (item) && g_paste_str_equal (g_paste_item_get_kind (item), "Text"));
+    g_return_if_fail (!_g_paste_history_private_get_password (priv, name, NULL));
+
+    GPasteItem *password = g_paste_password_item_new (name, g_paste_item_get_real_value (item));
+
+    _g_paste_history_replace (self, index, password, todel);
+}
+
+/**
+ * g_paste_history_get_password:
+ * @self: a #GPasteHistory instance
+ * @name: the name of the #GPastePasswordItem
+ *
+ * Get the first password matching name
+ *
+ * Returns: (nullable): a #GPastePasswordItem or %NULL
+ */
+G_PASTE_VISIBLE const GPastePasswordItem *
+g_paste_history_get_password (GPasteHistory *self,
+                              const gchar   *name)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (!name || g_utf8_validate (name, -1, NULL), NULL);
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    GPasteItem *item = _g_paste_history_private_get_password (priv, name, NULL);
+
+    return (item) ? G_PASTE_PASSWORD_ITEM (item) : NULL;
+}
+
+/**
+ * g_paste_history_delete_password:
+ * @self: a #GPasteHistory instance
+ * @name: the name of the #GPastePasswordItem
+ *
+ * Delete the password matching name
+ */
+G_PASTE_VISIBLE void
+g_paste_history_delete_password (GPasteHistory *self,
+                                 const gchar   *name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    guint64 index;
+
+    if (_g_paste_history_private_get_password (priv, name, &index))
+        g_paste_history_remove (self, index);
+}
+
+/**
+ * g_paste_history_rename_password:
+ * @self: a #GPasteHistory instance
+ * @old_name: the old name of the #GPastePasswordItem
+ * @new_name: (nullable): the new name of the #GPastePasswordItem
+ *
+ * Rename the password item
+ */
+G_PASTE_VISIBLE void
+g_paste_history_rename_password (GPasteHistory *self,
+                                 const gchar   *old_name,
+                                 const gchar   *new_name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (!old_name || g_utf8_validate (old_name, -1, NULL));
+    g_return_if_fail (!new_name || g_utf8_validate (new_name, -1, NULL));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    guint64 index = 0;
+    GPasteItem *item = _g_paste_history_private_get_password (priv, old_name, &index);
+    if (item)
+    {
+        g_paste_password_item_set_name (G_PASTE_PASSWORD_ITEM (item), new_name);
+        g_paste_history_private_search_index_item (priv, g_paste_history_private_get_item_by_uuid (priv, g_paste_item_get_uuid (item), NULL));
+        g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_REPLACE, index, g_paste_item_get_uuid (item));
+        g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_POSITION, index);
+    }
+}
+
+/**
+ * g_paste_history_empty:
+ * @self: a #GPasteHistory instance
+ *
+ * Empty the #GPasteHistory
+ */
+G_PASTE_VISIBLE void
+g_paste_history_empty (GPasteHistory *self)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    g_paste_history_private_clear (priv);
+    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REMOVE, G_PASTE_UPDATE_TARGET_ALL, 0);
+}
+
+/**
+ * g_paste_history_freeze_updates:
+ * @self: a #GPasteHistory instance
+ *
+ * Hold back saving and announcing the changes to the #GPasteHistory
+ * until the matching g_paste_history_thaw_updates, so that a batch of
+ * changes is saved once and announced as a single update
+ */
+G_PASTE_VISIBLE void
+g_paste_history_freeze_updates (GPasteHistory *self)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    ++priv->frozen;
+}
+
+/**
+ * g_paste_history_thaw_updates:
+ * @self: a #GPasteHistory instance
+ *
+ * Undo a g_paste_history_freeze_updates, saving and announcing
+ * what changed meanwhile once the last one is undone
+ */
+G_PASTE_VISIBLE void
+g_paste_history_thaw_updates (GPasteHistory *self)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    g_return_if_fail (priv->frozen);
+
+    if (--priv->frozen)
+        return;
+
+    if (priv->update_pending)
+    {
+        priv->update_pending = FALSE;
+        g_paste_history_update (self, priv->pending_action, priv->pending_target, priv->pending_position);
+    }
+    else
+    {
+        g_paste_history_commit_changes (self);
+    }
+}
+
+/**
+ * g_paste_history_save:
+ * @self: a #GPasteHistory instance
+ * @name: (nullable): the name to save the history to (defaults to the configured one)
+ *
+ * Save the #GPasteHistory to the history file, synchronously
+ */
+G_PASTE_VISIBLE void
+g_paste_history_save (GPasteHistory *self,
+                      const gchar   *name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    /* Don't let an older snapshot land after us */
+    g_paste_history_private_wait_for_save (priv);
+
+    if (!name || g_paste_str_equal (name, priv->name))
+        g_paste_history_private_cancel_save (priv);
+
+    g_paste_storage_backend_write_history (priv->backend, (name) ? name : priv->name, g_paste_history_get_history (self));
+}
+
+/**
+ * g_paste_history_flush:
+ * @self: a #GPasteHistory instance
+ *
+ * Write any pending change to the history file and wait
+ * for the background save to be over
+ */
+G_PASTE_VISIBLE void
+g_paste_history_flush (GPasteHistory *self)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    if (priv->save_source)
+        g_paste_history_save (self, NULL);
+    else
+        g_paste_history_private_wait_for_save (priv);
+}
+
+/**
+ * g_paste_history_load:
+ * @self: a #GPasteHistory instance
+ * @name: (nullable): the name of the history to load, defaults to the configured one
+ *
+ * Load the #GPasteHistory from the history file
+ */
+G_PASTE_VISIBLE void
+g_paste_history_load (GPasteHistory *self,
+                      const gchar   *name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    if (priv->name && g_paste_str_equal(name, priv->name))
+        return;
+
+    /* Pending changes belong to the history we're leaving */
+    g_paste_history_flush (self);
+    /* Once saved, make the history we're leaving searchable without loading it */
+    if (priv->name)
+        g_paste_storage_backend_index_history (priv->backend, priv->name, g_paste_history_get_history (self));
+    g_paste_history_private_clear (priv);
+
+    g_free (priv->name);
+    priv->name = g_strdup ((name) ? name : g_paste_settings_get_history_name (priv->settings));
+
+    GList *history = NULL;
+
+    g_paste_storage_backend_read_history (priv->backend, priv->name, &history, &priv->size);
+
+    for (GList *h = history; h; h = g_list_next (h), ++priv->length)
+        g_sequence_append (priv->history, h->data);
+    g_list_free (history);
+    g_paste_history_private_rebuild_index (priv);
+
+    if (priv->length)
+        g_paste_history_activate_first (self, TRUE);
+}
+
+/**
+ * g_paste_history_switch:
+ * @self: a #GPasteHistory instance
+ * @name: the name of the new history
+ *
+ * Switch to a new history
+ */
+G_PASTE_VISIBLE void
+g_paste_history_switch (GPasteHistory *self,
+                        const gchar   *name)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (name);
+    g_return_if_fail (g_utf8_validate (name, -1, NULL));
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+
+    g_paste_settings_set_history_name (priv->settings, name);
+}
+
+/**
+ * g_paste_history_delete:
+ * @self: a #GPasteHistory instance
+ * @name: (nullable): the history to delete (defaults to the configured one)
+ * @error: a #GError
+ *
+ * Delete the current #GPasteHistory
+ */
+G_PASTE_VISIBLE void
+g_paste_history_delete (GPasteHistory *self,
+                        const gchar   *name,
+                        GError       **error)
+{
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+
+    if (g_paste_str_equal (name, priv->name))
+    {
+        g_paste_history_empty (self);
+        /* Don't let the pending save recreate the file */
+        g_paste_history_flush (self);
+    }
+
+    g_paste_storage_backend_delete_history (priv->backend, (name) ? name : priv->name, error);
+}
+
+static void
+g_paste_history_history_name_changed (GPasteHistory *self)
+{
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+
+    g_debug ("history: name changed to '%s'", priv->name);
+
+    g_paste_history_load (self, NULL);
+    g_paste_history_emit_switch (self, priv->name);
+    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_ALL, 0);
+}
+
+static void
+g_paste_history_settings_changed (GPasteSettings *settings,
+                                  const gchar    *key,
+                                  gpointer        user_data)
+{
+    GPasteHistory *self = user_data;
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    /* FIXME: track text item size settings */
+    if (g_paste_str_equal(key, G_PASTE_MAX_HISTORY_SIZE_SETTING))
+    {
+        g_paste_history_private_check_size (priv);
+        g_paste_history_commit_changes (self);
+    }
+    else if (g_paste_str_equal (key, G_PASTE_MAX_MEMORY_USAGE_SETTING))
+    {
+        g_paste_history_private_check_memory_usage (priv);
+        g_paste_history_commit_changes (self);
+    }
+    else if (g_paste_str_equal (key, G_PASTE_HISTORY_NAME_SETTING))
+        g_paste_history_history_name_changed (self);
+    else if (g_paste_str_equal (key, G_PASTE_ELEMENT_SIZE_SETTING))
+    {
+        guint64 element_size = g_paste_settings_get_element_size (settings);
+
+        for (GSequenceIter *history = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+            g_paste_item_set_preview_size (g_sequence_get (history), element_size);
+
+        /* Every preview announced so far is stale */
+        g_paste_history_private_record_change (priv, G_PASTE_CHANGE_KIND_RESET, 0, NULL);
+        g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_ALL, 0);
+    }
+}
+
+static void
+g_paste_history_dispose (GObject *object)
+{
+    GPasteHistory *self = G_PASTE_HISTORY (object);
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    GPasteSettings *settings = priv->settings;
+
+    if (priv->backend)
+    {
+        g_paste_history_flush (self);
+        g_clear_object (&priv->backend);
+    }
+
+    if (settings)
+    {
+        g_signal_handler_disconnect (settings, priv->c_signals[C_CHANGED]);
+        g_clear_object (&priv->settings);
+    }
+
+    G_OBJECT_CLASS (g_paste_history_parent_class)->dispose (object);
+}
+
+static void
+g_paste_history_finalize (GObject *object)
+{
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (G_PASTE_HISTORY (object));
+
+    g_free (priv->name);
+    g_paste_history_private_clear (priv);
+    g_hash_table_unref (priv->uuid_index);
+    g_hash_table_unref (priv->hash_index);
+    g_object_unref (priv->search_index);
+    g_queue_free_full (priv->regex_cache, g_paste_history_cached_regex_free);
+    g_hash_table_unref (priv->size_heap_index);
+    g_array_unref (priv->size_heap);
+    g_queue_free_full (priv->pending_changes, g_paste_history_change_free);
+    g_queue_free_full (priv->changes, g_paste_history_change_free);
+    g_sequence_free (priv->history);
+    g_mutex_clear (&priv->save_mutex);
+    g_cond_clear (&priv->save_cond);
+
+    G_OBJECT_CLASS (g_paste_history_parent_class)->finalize (object);
+}
+
+static void
+g_paste_history_class_init (GPasteHistoryClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->dispose = g_paste_history_dispose;
+    object_class->finalize = g_paste_history_finalize;
+
+    /**
+     * GPasteHistory::selected:
+     * @history: the object on which the signal was emitted
+     * @item: the new selected item
+     *
+     * The "selected" signal is emitted when the user has just
+     * selected a new item form the history.
+     */
+    signals[SELECTED] = g_signal_new ("selected",
+                                      G_PASTE_TYPE_HISTORY,
+                                      G_SIGNAL_RUN_LAST,
+                                      0, /* class offset */
+                                      NULL, /* accumulator */
+                                      NULL, /* accumulator data */
+                                      g_cclosure_marshal_VOID__OBJECT,
+                                      G_TYPE_NONE,
+                                      1, /* number of params */
+                                      G_PASTE_TYPE_ITEM);
+
+    /**
+     * GPasteHistory::switch:
+     * @history: the object on which the signal was emitted
+     * @name: the new history name
+     *
+     * The "switch" signal is emitted when the user has just
+     * switched to a new history
+     */
+    signals[SWITCH] = g_signal_new ("switch",
+                                    G_PASTE_TYPE_HISTORY,
+                                    G_SIGNAL_RUN_LAST,
+                                    0, /* class offset */
+                                    NULL, /* accumulator */
+                                    NULL, /* accumulator data */
+                                    g_cclosure_marshal_VOID__STRING,
+                                    G_TYPE_NONE,
+                                    1, /* number of params */
+                                    G_TYPE_STRING);
+
+    /**
+     * GPasteHistory::update:
+     * @history: the object on which the signal was emitted
+     * @action: the kind of update
+     * @target: the items which need updating
+     * @index: the index of the item, when the target is POSITION
+     *
+     * The "update" signal is emitted whenever anything changed
+     * in the history (something was added, removed, selected, replaced...).
+     */
+    signals[UPDATE] = g_signal_new ("update",
+                                    G_PASTE_TYPE_HISTORY,
+                                    G_SIGNAL_RUN_LAST,
+                                    0, /* class offset */
+                                    NULL, /* accumulator */
+                                    NULL, /* accumulator data */
+                                    g_cclosure_marshal_generic,
+                                    G_TYPE_NONE,
+                                    3, /* number of params */
+                                    G_PASTE_TYPE_UPDATE_ACTION,
+                                    G_PASTE_TYPE_UPDATE_TARGET,
+                                    G_TYPE_UINT64);
+
+    /**
+     * GPasteHistory::changed:
+     * @history: the object on which the signal was emitted
+     * @seq: the sequence number of the history after the changes
+     *
+     * The "changed" signal is emitted whenever the history changed,
+     * use g_paste_history_get_changes_since() with @seq - 1 to know how.
+     */
+    signals[CHANGED] = g_signal_new ("changed",
+                                     G_PASTE_TYPE_HISTORY,
+                                     G_SIGNAL_RUN_LAST,
+                                     0, /* class offset */
+                                     NULL, /* accumulator */
+                                     NULL, /* accumulator data */
+                                     g_cclosure_marshal_generic,
+                                     G_TYPE_NONE,
+                                     1, /* number of params */
+                                     G_TYPE_UINT64);
+}
+
+static void
+g_paste_history_init (GPasteHistory *self)
+{
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+
+    priv->history = g_sequence_new (NULL);
+    priv->uuid_index = g_hash_table_new (g_str_hash, g_str_equal);
+    priv->hash_index = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+    priv->size_heap = g_array_new (FALSE, /* zero-terminated */
+                                   FALSE, /* clear */
+                                   sizeof (GPasteHistorySizeNode));
+    priv->size_heap_index = g_hash_table_new (NULL, NULL);
+    priv->search_index = g_paste_search_index_new ();
+    priv->regex_cache = g_queue_new ();
+    priv->pending_changes = g_queue_new ();
+    priv->changes = g_queue_new ();
+    /* Keep increasing across restarts so that clients notice they missed everything */
+    priv->seq = priv->changes_floor = g_get_real_time ();
+
+    g_mutex_init (&priv->save_mutex);
+    g_cond_init (&priv->save_cond);
+}
+
+/**
+ * g_paste_history_get_history:
+ * @self: a #GPasteHistory instance
+ *
+ * Get the inner history of a #GPasteHistory
+ * The returned list is only valid until the next change to the history
+ *
+ * Returns: (element-type GPasteItem) (transfer none): The inner history
+ */
+G_PASTE_VISIBLE const GList *
+g_paste_history_get_history (const GPasteHistory *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+
+    /* The list view is a cache, building it doesn't change the history */
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private ((GPasteHistory *) self);
+
+    if (!priv->history_list_valid)
+    {
+        GSequenceIter *begin = g_sequence_get_begin_iter (priv->history);
+        GSequenceIter *history = g_sequence_get_end_iter (priv->history);
+
+        while (history != begin)
+        {
+            history = g_sequence_iter_prev (history);
+            priv->history_list = g_list_prepend (priv->history_list, g_sequence_get (history));
+        }
+        priv->history_list_valid = TRUE;
+    }
+
+    return priv->history_list;
+}
+
+/**
+ * g_paste_history_get_length:
+ * @self: a #GPasteHistory instance
+ *
+ * Get the length of a #GPasteHistory
+ *
+ * Returns: The length of the inner history
+ */
+G_PASTE_VISIBLE guint64
+g_paste_history_get_length (const GPasteHistory *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+
+    return priv->length;
+}
+
+/**
+ * g_paste_history_get_seq:
+ * @self: a #GPasteHistory instance
+ *
+ * Get the sequence number of a #GPasteHistory, which grows
+ * each time the history changes
+ *
+ * Returns: The sequence number of the history
+ */
+G_PASTE_VISIBLE guint64
+g_paste_history_get_seq (const GPasteHistory *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
+
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+
+    return priv->seq;
 }
 
 /**
- * g_paste_history_set_password:
+ * g_paste_history_get_changes_since:
  * @self: a #GPasteHistory instance
- * @uuid: the uuid of the #GPasteTextItem to change as password
- * @name: (nullable): the name to give to the password
+ * @seq: the last sequence number we know about
  *
- * Mark a text item as password
+ * Get the changes which happened to a #GPasteHistory after @seq.
+ * The changes are only valid until the next change to the history
+ *
+ * Returns: (element-type GPasteHistoryChange) (transfer container) (nullable): The changes,
+ *          oldest first, or %NULL if we don't remember them all and the whole history
+ *          has to be fetched again
  */
-G_PASTE_VISIBLE void
-g_paste_history_set_password (GPasteHistory *self,
-                              const gchar   *uuid,
-                              const gchar   *name)
+G_PASTE_VISIBLE GPtrArray *
+g_paste_history_get_changes_since (const GPasteHistory *self,
+                                   guint64              seq)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
 
     const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    guint64 index;
-    GList *todel = g_paste_history_private_get_item_by_uuid (priv, uuid, &index);
 
-    g_return_if_fail (todel);
+    if (seq < priv->changes_floor || seq > priv->seq)
+        return NULL;
 
-    GPasteItem *item = todel->data;
+    GPtrArray *changes = g_ptr_array_new ();
+    GList *first = priv->changes->tail;
 
-    g_return_if_fail (_G_PASTE_IS_TEXT_ITEM (item) && g_paste_str_equal (g_paste_item_get_kind (item), "Text"));
-    g_return_if_fail (!_g_paste_history_private_get_password (priv, name, NULL));
+    if (!first || ((GPasteHistoryChange *) first->data)->seq <= seq)
+        return changes;
 
-    GPasteItem *password = g_paste_password_item_new (name, g_paste_item_get_real_value (item));
+    while (first->prev && ((GPasteHistoryChange *) first->prev->data)->seq > seq)
+        first = first->prev;
 
-    _g_paste_history_replace (self, index, password, todel);
+    for (GList *c = first; c; c = g_list_next (c))
+        g_ptr_array_add (changes, c->data);
+
+    return changes;
 }
 
 /**
- * g_paste_history_get_password:
+ * g_paste_history_get_saved_length:
  * @self: a #GPasteHistory instance
- * @name: the name of the #GPastePasswordItem
+ * @name: the name of the history
  *
- * Get the first password matching name
+ * Get the length of the history @name, without loading it
+ * unless it has never been saved by us
  *
- * Returns: (nullable): a #GPastePasswordItem or %NULL
+ * Returns: The length of the history
  */
-G_PASTE_VISIBLE const GPastePasswordItem *
-g_paste_history_get_password (GPasteHistory *self,
-                              const gchar   *name)
+G_PASTE_VISIBLE guint64
+g_paste_history_get_saved_length (const GPasteHistory *self,
+                                  const gchar         *name)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
-    g_return_val_if_fail (!name || g_utf8_validate (name, -1, NULL), NULL);
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
+    g_return_val_if_fail (name, 0);
 
     const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    GPasteItem *item = _g_paste_history_private_get_password (priv, name, NULL);
 
-    return (item) ? G_PASTE_PASSWORD_ITEM (item) : NULL;
+    if (g_paste_str_equal (name, priv->name))
+        return priv->length;
+
+    const gchar *extension = _G_PASTE_STORAGE_BACKEND_GET_CLASS (priv->backend)->get_extension (priv->backend);
+    g_autofree gchar *history_file_path = g_paste_util_get_history_file_path (name, extension);
+    guint64 length;
+
+    if (g_paste_history_catalog_lookup (name, history_file_path, &length, NULL))
+        return length;
+
+    /* No such history */
+    if (!g_file_test (history_file_path, G_FILE_TEST_EXISTS))
+        return 0;
+
+    /* Count it once, the catalog will remember */
+    GList *history = NULL;
+    gsize size;
+
+    g_debug ("history: count %s", name);
+
+    g_paste_storage_backend_read_history (priv->backend, name, &history, &size);
+
+    length = g_list_length (history);
+    g_paste_history_catalog_update (name, history_file_path, history);
+    g_list_free_full (history, g_object_unref);
+
+    return length;
 }
 
 /**
- * g_paste_history_delete_password:
+ * g_paste_history_get_current:
  * @self: a #GPasteHistory instance
- * @name: the name of the #GPastePasswordItem
  *
- * Delete the password matching name
+ * Get the name of the current history
+ *
+ * Returns: The name of the current history
  */
-G_PASTE_VISIBLE void
-g_paste_history_delete_password (GPasteHistory *self,
-                                 const gchar   *name)
+G_PASTE_VISIBLE const gchar *
+g_paste_history_get_current (const GPasteHistory *self)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
 
     const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    guint64 index;
 
-    if (_g_paste_history_private_get_password (priv, name, &index))
-        g_paste_history_remove (self, index);
+    return priv->name;
 }
 
-/**
- * g_paste_history_rename_password:
- * @self: a #GPasteHistory instance
- * @old_name: the old name of the #GPastePasswordItem
- * @new_name: (nullable): the new name of the #GPastePasswordItem
- *
- * Rename the password item
- */
-G_PASTE_VISIBLE void
-g_paste_history_rename_password (GPasteHistory *self,
-                                 const gchar   *old_name,
-                                 const gchar   *new_name)
+/* @name is the name of the password, %NULL for other items */
+static gboolean
+g_paste_history_matches (const gchar  *uuid,
+                         const gchar  *name,
+                         const gchar  *value,
+                         const gchar  *pattern,
+                         const GRegex *regex)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (!old_name || g_utf8_validate (old_name, -1, NULL));
-    g_return_if_fail (!new_name || g_utf8_validate (new_name, -1, NULL));
+    if (g_paste_str_equal (pattern, uuid))
+        return TRUE;
+    if (name && g_paste_str_equal (pattern, name))
+        return TRUE;
+    return g_regex_match (regex, value, G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY, NULL);
+}
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    guint64 index = 0;
-    GPasteItem *item = _g_paste_history_private_get_password (priv, old_name, &index);
-    if (item)
+static const gchar *
+g_paste_history_item_get_password_name (const GPasteItem *item)
+{
+    return (_G_PASTE_IS_PASSWORD_ITEM (item)) ? g_paste_password_item_get_name (_G_PASTE_PASSWORD_ITEM (item)) : NULL;
+}
+
+static gboolean
+g_paste_history_item_matches (const GPasteItem *item,
+                              const gchar      *pattern,
+                              const GRegex     *regex)
+{
+    return g_paste_history_matches (g_paste_item_get_uuid (item),
+                                    g_paste_history_item_get_password_name (item),
+                                    g_paste_item_get_value (item),
+                                    pattern,
+                                    regex);
+}
+
+static gint
+g_paste_history_compare_iters (gconstpointer a,
+                               gconstpointer b)
+{
+    return g_sequence_iter_compare (*((GSequenceIter **) a), *((GSequenceIter **) b));
+}
+
+/* Candidates for a plain text pattern, in history order, or NULL if we need to scan everything */
+static GPtrArray *
+g_paste_history_private_get_search_candidates (const GPasteHistoryPrivate *priv,
+                                               const gchar                *pattern,
+                                               gboolean                    literal)
+{
+    if (!literal && strpbrk (pattern, "\\^$.|?*+()[]{}"))
+        return NULL;
+
+    GPtrArray *candidates = g_paste_search_index_lookup (priv->search_index, pattern);
+
+    if (!candidates)
+        return NULL;
+
+    /* The pattern may be the uuid of an item not containing it */
+    GSequenceIter *by_uuid = g_hash_table_lookup (priv->uuid_index, pattern);
+
+    if (by_uuid && !g_ptr_array_find (candidates, by_uuid, NULL))
+        g_ptr_array_add (candidates, by_uuid);
+
+    g_ptr_array_sort (candidates, g_paste_history_compare_iters);
+
+    return candidates;
+}
+
+/* Candidates is NULL to scan the whole history, or in history order */
+static GStrv
+g_paste_history_private_search (const GPasteHistoryPrivate *priv,
+                                const gchar                *pattern,
+                                const GPtrArray            *candidates)
+{
+    g_autoptr (GError) error = NULL;
+    /* Only worth optimizing when we scan the whole history */
+    g_autoptr (GRegex) regex = g_regex_new (pattern,
+                                            G_REGEX_CASELESS|G_REGEX_MULTILINE|G_REGEX_DOTALL|((candidates) ? 0 : G_REGEX_OPTIMIZE),
+                                            G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY,
+                                            &error);
+
+    if (error)
     {
-        g_paste_password_item_set_name (G_PASTE_PASSWORD_ITEM (item), new_name);
-        g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_POSITION, index);
+        g_warning ("error while creating regex: %s", error->message);
+        return NULL;
+    }
+    if (!regex)
+        return NULL;
+
+    g_autoptr (GArray) results = g_array_new (TRUE, /* zero-terminated */
+                                              TRUE, /* clear */
+                                              sizeof (gchar *));
+
+    if (candidates)
+    {
+        for (guint i = 0; i < candidates->len; ++i)
+        {
+            const GPasteItem *item = g_sequence_get (g_ptr_array_index (candidates, i));
+
+            if (g_paste_history_item_matches (item, pattern, regex))
+            {
+                gchar *id = g_strdup (g_paste_item_get_uuid (item));
+                g_array_append_val (results, id);
+            }
+        }
+    }
+    else
+    {
+        for (GSequenceIter *history = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+        {
+            const GPasteItem *item = g_sequence_get (history);
+
+            if (g_paste_history_item_matches (item, pattern, regex))
+            {
+                gchar *id = g_strdup (g_paste_item_get_uuid (item));
+                g_array_append_val (results, id);
+            }
+        }
     }
+
+    return g_array_steal (results, NULL);
 }
 
 /**
- * g_paste_history_empty:
+ * g_paste_history_search:
  * @self: a #GPasteHistory instance
+ * @pattern: the pattern to match
  *
- * Empty the #GPasteHistory
+ * Get the elements matching @pattern in the history
+ *
+ * Returns: (transfer full): The uuids of the matching elements
  */
-G_PASTE_VISIBLE void
-g_paste_history_empty (GPasteHistory *self)
+G_PASTE_VISIBLE GStrv
+g_paste_history_search (const GPasteHistory *self,
+                        const gchar         *pattern)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
 
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    g_debug ("history: search '%s'", pattern);
 
-    g_list_free_full (priv->history, g_object_unref);
-    priv->history = NULL;
-    priv->size = 0;
+    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    g_autoptr (GPtrArray) candidates = g_paste_history_private_get_search_candidates (priv, pattern, FALSE);
 
-    g_paste_history_private_elect_new_biggest (priv);
-    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REMOVE, G_PASTE_UPDATE_TARGET_ALL, 0);
+    return g_paste_history_private_search (priv, pattern, candidates);
 }
 
-/**
- * g_paste_history_save:
- * @self: a #GPasteHistory instance
- * @name: (nullable): the name to save the history to (defaults to the configured one)
- *
- * Save the #GPasteHistory to the history file
- */
-G_PASTE_VISIBLE void
-g_paste_history_save (GPasteHistory *self,
-                      const gchar   *name)
+/* Caseless subsequence match, needle being lowercased */
+static gboolean
+g_paste_history_fuzzy_matches (const gchar    *text,
+                               const gunichar *needle,
+                               glong           needle_len)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    glong found = 0;
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    for (const gchar *c = text; *c && found < needle_len; c = g_utf8_next_char (c))
+    {
+        if (g_unichar_tolower (g_utf8_get_char (c)) == needle[found])
+            ++found;
+    }
 
-    g_paste_storage_backend_write_history (priv->backend, (name) ? name : priv->name, priv->history);
+    return found == needle_len;
 }
 
 /**
- * g_paste_history_load:
+ * g_paste_history_search_with_options:
  * @self: a #GPasteHistory instance
- * @name: (nullable): the name of the history to load, defaults to the configured one
+ * @pattern: the pattern to match
+ * @mode: how to match @pattern
+ * @offset: the number of matching elements to skip
+ * @limit: the maximum number of elements to return, 0 for no limit
  *
- * Load the #GPasteHistory from the history file
+ * Get the elements matching @pattern in the history, @pattern being
+ * either a plain text, a regex or a sequence of characters that must
+ * appear in that order in the element, depending on @mode.
+ * The history is not scanned any further once @limit elements are found.
+ *
+ * Returns: (transfer full): The uuids of the matching elements, in history order
  */
-G_PASTE_VISIBLE void
-g_paste_history_load (GPasteHistory *self,
-                      const gchar   *name)
+G_PASTE_VISIBLE GStrv
+g_paste_history_search_with_options (const GPasteHistory *self,
+                                     const gchar         *pattern,
+                                     GPasteSearchMode     mode,
+                                     guint64              offset,
+                                     guint64              limit)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (!name || g_utf8_validate (name, -1, NULL));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    g_return_val_if_fail (mode != G_PASTE_SEARCH_MODE_INVALID, NULL);
 
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    g_debug ("history: search '%s' (mode %d, offset %" G_GUINT64_FORMAT ", limit %" G_GUINT64_FORMAT ")", pattern, mode, offset, limit);
 
-    if (priv->name && g_paste_str_equal(name, priv->name))
-        return;
+    /* Only the regex cache gets updated here */
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private ((GPasteHistory *) self);
+    g_autoptr (GArray) results = g_array_new (TRUE, /* zero-terminated */
+                                              TRUE, /* clear */
+                                              sizeof (gchar *));
 
-    g_list_free_full (priv->history,
-                      g_object_unref);
-    priv->history = NULL;
-    priv->size = 0;
+    if (!*pattern)
+        return g_array_steal (results, NULL);
 
-    g_free (priv->name);
-    priv->name = g_strdup ((name) ? name : g_paste_settings_get_history_name (priv->settings));
+    g_autoptr (GPtrArray) candidates = NULL;
+    g_autoptr (GRegex) regex = NULL;
+    g_autofree gunichar *needle = NULL;
+    glong needle_len = 0;
+
+    if (mode == G_PASTE_SEARCH_MODE_FUZZY)
+    {
+        needle = g_utf8_to_ucs4_fast (pattern, -1, &needle_len);
+        for (glong i = 0; i < needle_len; ++i)
+            needle[i] = g_unichar_tolower (needle[i]);
+    }
+    else
+    {
+        g_autoptr (GError) error = NULL;
+        g_autofree gchar *escaped = (mode == G_PASTE_SEARCH_MODE_LITERAL) ? g_regex_escape_string (pattern, -1) : NULL;
+
+        regex = g_paste_history_private_get_regex (priv, (escaped) ? escaped : pattern, &error);
+
+        if (error)
+        {
+            g_warning ("error while creating regex: %s", error->message);
+            return NULL;
+        }
+        if (!regex)
+            return NULL;
+
+        candidates = g_paste_history_private_get_search_candidates (priv, pattern, mode == G_PASTE_SEARCH_MODE_LITERAL);
+    }
 
-    g_paste_storage_backend_read_history (priv->backend, priv->name, &priv->history, &priv->size);
+    GSequenceIter *history = (candidates) ? NULL : g_sequence_get_begin_iter (priv->history);
+    guint64 skipped = 0;
 
-    if (priv->history)
+    for (guint i = 0; !limit || results->len < limit; ++i)
     {
-        g_paste_history_activate_first (self, TRUE);
-        g_paste_history_private_elect_new_biggest (priv);
+        GSequenceIter *elem;
+
+        if (candidates)
+        {
+            if (i >= candidates->len)
+                break;
+            elem = g_ptr_array_index (candidates, i);
+        }
+        else
+        {
+            if (g_sequence_iter_is_end (history))
+                break;
+            elem = history;
+            history = g_sequence_iter_next (history);
+        }
+
+        const GPasteItem *item = g_sequence_get (elem);
+        gboolean matches = (regex) ?
+            g_paste_history_item_matches (item, pattern, regex) :
+            (g_paste_str_equal (pattern, g_paste_item_get_uuid (item)) ||
+             (_G_PASTE_IS_PASSWORD_ITEM (item) && g_paste_str_equal (pattern, g_paste_password_item_get_name (_G_PASTE_PASSWORD_ITEM (item)))) ||
+             g_paste_history_fuzzy_matches (g_paste_item_get_value (item), needle, needle_len));
+
+        if (!matches)
+            continue;
+
+        if (skipped < offset)
+        {
+            ++skipped;
+            continue;
+        }
+
+        gchar *id = g_strdup (g_paste_item_get_uuid (item));
+        g_array_append_val (results, id);
     }
+
+    return g_array_steal (results, NULL);
 }
 
 /**
- * g_paste_history_switch:
+ * g_paste_history_search_within:
  * @self: a #GPasteHistory instance
- * @name: the name of the new history
+ * @pattern: the pattern to match
+ * @uuids: (array zero-terminated=1): the uuids of the elements to search in
  *
- * Switch to a new history
+ * Get the elements matching @pattern among @uuids, typically the
+ * results of a previous search for a less specific pattern.
+ * Unknown uuids are ignored.
+ * The elements @pattern designates exactly (by uuid or password name)
+ * match too, even when not in @uuids, as the previous search may have
+ * missed them.
+ *
+ * Returns: (transfer full): The uuids of the matching elements, in history order
  */
-G_PASTE_VISIBLE void
-g_paste_history_switch (GPasteHistory *self,
-                        const gchar   *name)
+G_PASTE_VISIBLE GStrv
+g_paste_history_search_within (const GPasteHistory *self,
+                               const gchar         *pattern,
+                               const gchar * const *uuids)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
-    g_return_if_fail (name);
-    g_return_if_fail (g_utf8_validate (name, -1, NULL));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    g_return_val_if_fail (uuids, NULL);
+
+    g_debug ("history: search '%s' within %u elements", pattern, g_strv_length ((GStrv) uuids));
 
     const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    g_autoptr (GPtrArray) candidates = g_ptr_array_new ();
+    g_autoptr (GHashTable) seen = g_hash_table_new (NULL, NULL);
 
-    g_paste_settings_set_history_name (priv->settings, name);
+    for (const gchar * const *uuid = uuids; *uuid; ++uuid)
+    {
+        GSequenceIter *elem = g_hash_table_lookup (priv->uuid_index, *uuid);
+
+        if (elem && g_hash_table_add (seen, elem))
+            g_ptr_array_add (candidates, elem);
+    }
+
+    /* A less specific pattern only matched these by value */
+    GSequenceIter *by_uuid = g_hash_table_lookup (priv->uuid_index, pattern);
+
+    if (by_uuid && g_hash_table_add (seen, by_uuid))
+        g_ptr_array_add (candidates, by_uuid);
+
+    for (GSequenceIter *h = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (h); h = g_sequence_iter_next (h))
+    {
+        const gchar *name = g_paste_history_item_get_password_name (g_sequence_get (h));
+
+        if (name && g_paste_str_equal (name, pattern) && g_hash_table_add (seen, h))
+            g_ptr_array_add (candidates, h);
+    }
+
+    g_ptr_array_sort (candidates, g_paste_history_compare_iters);
+
+    return g_paste_history_private_search (priv, pattern, candidates);
 }
 
 /**
- * g_paste_history_delete:
+ * g_paste_history_search_saved:
  * @self: a #GPasteHistory instance
- * @name: (nullable): the history to delete (defaults to the configured one)
+ * @name: the name of the history to search
+ * @pattern: the pattern to match
  * @error: a #GError
  *
- * Delete the current #GPasteHistory
+ * Get the elements of the history @name matching @pattern.
+ * Other histories than the current one aren't loaded, their
+ * saved search index is used instead.
+ *
+ * Returns: (transfer full) (nullable): The uuids of the matching elements, in history order
  */
-G_PASTE_VISIBLE void
-g_paste_history_delete (GPasteHistory *self,
-                        const gchar   *name,
-                        GError       **error)
+G_PASTE_VISIBLE GStrv
+g_paste_history_search_saved (const GPasteHistory *self,
+                              const gchar         *name,
+                              const gchar         *pattern,
+                              GError             **error)
 {
-    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (name, NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
 
     const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
 
-    g_autoptr (GFile) history_file = g_paste_util_get_history_file ((name) ? name : priv->name, "xml");
-
+    /* What we have in memory may not have been saved yet */
     if (g_paste_str_equal (name, priv->name))
-        g_paste_history_empty (self);
+        return g_paste_history_search (self, pattern);
 
-    if (g_file_query_exists (history_file,
-                             NULL)) /* cancellable */
-    {
-        g_file_delete (history_file,
-                       NULL, /* cancellable */
-                       error);
-    }
+    g_debug ("history: search '%s' in saved history %s", pattern, name);
+
+    return g_paste_storage_backend_search_history (priv->backend, name, pattern, error);
 }
 
-static void
-g_paste_history_history_name_changed (GPasteHistory *self)
-{
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+/****************************/
+/* Begin parallel searching */
+/****************************/
 
-    g_debug ("history: name changed to '%s'", priv->name);
+/* Don't bother waking up a thread for less than that many bytes */
+#define G_PASTE_HISTORY_SEARCH_MIN_CHUNK_SIZE (64 * 1024)
 
-    g_paste_history_load (self, NULL);
-    g_paste_history_emit_switch (self, priv->name);
-    g_paste_history_update (self, G_PASTE_UPDATE_ACTION_REPLACE, G_PASTE_UPDATE_TARGET_ALL, 0);
-}
+/*
+ * What a search looks at in an item. Values never change (replacing an item
+ * swaps in a new one) so we only keep a ref on it, but passwords can be
+ * renamed while the threads run.
+ */
+typedef struct
+{
+    GPasteItem *item;
+    gchar      *uuid;
+    /* The name of the password, NULL for other items */
+    gchar      *name;
+} GPasteHistorySearchEntry;
 
-static void
-g_paste_history_settings_changed (GPasteSettings *settings G_GNUC_UNUSED,
-                                  const gchar    *key,
-                                  gpointer        user_data)
+typedef struct
 {
-    GPasteHistory *self = user_data;
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    gchar                    *pattern;
+    GRegex                   *regex;
+    /* The items to scan, in history order */
+    GPasteHistorySearchEntry *entries;
+    guint                     n_entries;
+    /* Whether each item matches, each chunk filling its own range */
+    gboolean                 *matches;
+    /* The number of chunks still running */
+    gint                      pending;
+} GPasteHistorySearch;
 
-    /* FIXME: track text item size settings */
-    if (g_paste_str_equal(key, G_PASTE_MAX_HISTORY_SIZE_SETTING))
-        g_paste_history_private_check_size (priv);
-    else if (g_paste_str_equal (key, G_PASTE_MAX_MEMORY_USAGE_SETTING))
-        g_paste_history_private_check_memory_usage (priv);
-    else if (g_paste_str_equal (key, G_PASTE_HISTORY_NAME_SETTING))
-        g_paste_history_history_name_changed (self);
-}
+typedef struct
+{
+    GTask *task;
+    guint  begin;
+    guint  end;
+} GPasteHistorySearchChunk;
 
 static void
-g_paste_history_dispose (GObject *object)
+g_paste_history_search_free (gpointer data)
 {
-    GPasteHistory *self = G_PASTE_HISTORY (object);
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
-    GPasteSettings *settings = priv->settings;
-
-    g_clear_object (&priv->backend);
+    GPasteHistorySearch *search = data;
 
-    if (settings)
+    for (guint i = 0; i < search->n_entries; ++i)
     {
-        g_signal_handler_disconnect (settings, priv->c_signals[C_CHANGED]);
-        g_clear_object (&priv->settings);
+        GPasteHistorySearchEntry *entry = &search->entries[i];
+
+        g_object_unref (entry->item);
+        g_free (entry->uuid);
+        g_free (entry->name);
     }
 
-    G_OBJECT_CLASS (g_paste_history_parent_class)->dispose (object);
+    g_free (search->pattern);
+    g_regex_unref (search->regex);
+    g_free (search->entries);
+    g_free (search->matches);
+    g_free (search);
 }
 
-static void
-g_paste_history_finalize (GObject *object)
+static GStrv
+g_paste_history_search_merge (const GPasteHistorySearch *search)
 {
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (G_PASTE_HISTORY (object));
+    g_autoptr (GArray) results = g_array_new (TRUE, /* zero-terminated */
+                                              TRUE, /* clear */
+                                              sizeof (gchar *));
 
-    g_free (priv->name);
-    g_list_free_full (priv->history, g_object_unref);
+    for (guint i = 0; i < search->n_entries; ++i)
+    {
+        if (search->matches[i])
+        {
+            gchar *id = g_strdup (search->entries[i].uuid);
+            g_array_append_val (results, id);
+        }
+    }
 
-    G_OBJECT_CLASS (g_paste_history_parent_class)->finalize (object);
+    return g_array_steal (results, NULL);
 }
 
 static void
-g_paste_history_class_init (GPasteHistoryClass *klass)
+g_paste_history_search_chunk_run (gpointer data,
+                                  gpointer user_data G_GNUC_UNUSED)
 {
-    GObjectClass *object_class = G_OBJECT_CLASS (klass);
-
-    object_class->dispose = g_paste_history_dispose;
-    object_class->finalize = g_paste_history_finalize;
-
-    /**
-     * GPasteHistory::selected:
-     * @history: the object on which the signal was emitted
-     * @item: the new selected item
-     *
-     * The "selected" signal is emitted when the user has just
-     * selected a new item form the history.
-     */
-    signals[SELECTED] = g_signal_new ("selected",
-                                      G_PASTE_TYPE_HISTORY,
-                                      G_SIGNAL_RUN_LAST,
-                                      0, /* class offset */
-                                      NULL, /* accumulator */
-                                      NULL, /* accumulator data */
-                                      g_cclosure_marshal_VOID__OBJECT,
-                                      G_TYPE_NONE,
-                                      1, /* number of params */
-                                      G_PASTE_TYPE_ITEM);
+    g_autofree GPasteHistorySearchChunk *chunk = data;
+    g_autoptr (GTask) task = chunk->task;
+    GPasteHistorySearch *search = g_task_get_task_data (task);
 
-    /**
-     * GPasteHistory::switch:
-     * @history: the object on which the signal was emitted
-     * @name: the new history name
-     *
-     * The "switch" signal is emitted when the user has just
-     * switched to a new history
-     */
-    signals[SWITCH] = g_signal_new ("switch",
-                                    G_PASTE_TYPE_HISTORY,
-                                    G_SIGNAL_RUN_LAST,
-                                    0, /* class offset */
-                                    NULL, /* accumulator */
-                                    NULL, /* accumulator data */
-                                    g_cclosure_marshal_VOID__STRING,
-                                    G_TYPE_NONE,
-                                    1, /* number of params */
-                                    G_TYPE_STRING);
+    if (!g_cancellable_is_cancelled (g_task_get_cancellable (task)))
+    {
+        for (guint i = chunk->begin; i < chunk->end; ++i)
+        {
+            const GPasteHistorySearchEntry *entry = &search->entries[i];
 
-    /**
-     * GPasteHistory::update:
-     * @history: the object on which the signal was emitted
-     * @action: the kind of update
-     * @target: the items which need updating
-     * @index: the index of the item, when the target is POSITION
-     *
-     * The "update" signal is emitted whenever anything changed
-     * in the history (something was added, removed, selected, replaced...).
-     */
-    signals[UPDATE] = g_signal_new ("update",
-                                    G_PASTE_TYPE_HISTORY,
-                                    G_SIGNAL_RUN_LAST,
-                                    0, /* class offset */
-                                    NULL, /* accumulator */
-                                    NULL, /* accumulator data */
-                                    g_cclosure_marshal_generic,
-                                    G_TYPE_NONE,
-                                    3, /* number of params */
-                                    G_PASTE_TYPE_UPDATE_ACTION,
-                                    G_PASTE_TYPE_UPDATE_TARGET,
-                                    G_TYPE_UINT64);
-}
+            search->matches[i] = g_paste_history_matches (entry->uuid, entry->name, g_paste_item_get_value (entry->item), search->pattern, search->regex);
+        }
+    }
 
-static void
-g_paste_history_init (GPasteHistory *self)
-{
-    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    /* The last chunk to finish merges the results */
+    if (!g_atomic_int_dec_and_test (&search->pending))
+        return;
 
-    g_paste_history_private_elect_new_biggest (priv);
+    if (!g_task_return_error_if_cancelled (task))
+        g_task_return_pointer (task, g_paste_history_search_merge (search), (GDestroyNotify) g_strfreev);
 }
 
-/**
- * g_paste_history_get_history:
- * @self: a #GPasteHistory instance
- *
- * Get the inner history of a #GPasteHistory
- *
- * Returns: (element-type GPasteItem) (transfer none): The inner history
- */
-G_PASTE_VISIBLE const GList *
-g_paste_history_get_history (const GPasteHistory *self)
+static GThreadPool *
+g_paste_history_get_search_pool (void)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    static gsize initialized = 0;
+    static GThreadPool *pool = NULL;
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    if (g_once_init_enter (&initialized))
+    {
+        pool = g_thread_pool_new (g_paste_history_search_chunk_run,
+                                  NULL, /* user_data */
+                                  g_get_num_processors (),
+                                  FALSE, /* exclusive */
+                                  NULL); /* error */
+        g_once_init_leave (&initialized, 1);
+    }
 
-    return priv->history;
+    return pool;
 }
 
 /**
- * g_paste_history_get_length:
+ * g_paste_history_search_async:
  * @self: a #GPasteHistory instance
+ * @pattern: the pattern to match
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): the #GAsyncReadyCallback to call when the search is done
+ * @user_data: (closure): the data to pass to @callback
  *
- * Get the length of a #GPasteHistory
- *
- * Returns: The length of the inner history
+ * Get the elements matching @pattern in the history, like g_paste_history_search
+ * but scanning a snapshot of the history on several threads, without blocking
+ * the main loop
  */
-G_PASTE_VISIBLE guint64
-g_paste_history_get_length (const GPasteHistory *self)
+G_PASTE_VISIBLE void
+g_paste_history_search_async (GPasteHistory      *self,
+                              const gchar        *pattern,
+                              GCancellable       *cancellable,
+                              GAsyncReadyCallback callback,
+                              gpointer            user_data)
 {
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
+    g_return_if_fail (_G_PASTE_IS_HISTORY (self));
+    g_return_if_fail (pattern && g_utf8_validate (pattern, -1, NULL));
+    g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    g_debug ("history: parallel search '%s'", pattern);
 
-    return g_list_length (priv->history);
-}
+    GPasteHistoryPrivate *priv = g_paste_history_get_instance_private (self);
+    g_autoptr (GTask) task = g_task_new (self, cancellable, callback, user_data);
+    g_autoptr (GError) error = NULL;
+    GRegex *regex = g_paste_history_private_get_regex (priv, pattern, &error);
 
-/**
- * g_paste_history_get_current:
- * @self: a #GPasteHistory instance
- *
- * Get the name of the current history
- *
- * Returns: The name of the current history
- */
-G_PASTE_VISIBLE const gchar *
-g_paste_history_get_current (const GPasteHistory *self)
-{
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), 0);
+    g_task_set_source_tag (task, g_paste_history_search_async);
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
+    if (!regex)
+    {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
 
-    return priv->name;
-}
+    GPasteHistorySearch *search = g_new0 (GPasteHistorySearch, 1);
+    g_autoptr (GPtrArray) candidates = g_paste_history_private_get_search_candidates (priv, pattern, FALSE);
+    g_autoptr (GPtrArray) items = g_ptr_array_new ();
+    guint64 total_size = 0;
 
-/**
- * g_paste_history_search:
- * @self: a #GPasteHistory instance
- * @pattern: the pattern to match
- *
- * Get the elements matching @pattern in the history
- *
- * Returns: (transfer full): The uuids of the matching elements
- */
-G_PASTE_VISIBLE GStrv
-g_paste_history_search (const GPasteHistory *self,
-                        const gchar         *pattern)
-{
-    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
-    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    if (candidates)
+    {
+        for (guint i = 0; i < candidates->len; ++i)
+            g_ptr_array_add (items, g_sequence_get (g_ptr_array_index (candidates, i)));
+    }
+    else
+    {
+        for (GSequenceIter *history = g_sequence_get_begin_iter (priv->history); !g_sequence_iter_is_end (history); history = g_sequence_iter_next (history))
+            g_ptr_array_add (items, g_sequence_get (history));
+    }
 
-    g_debug ("history: search '%s'", pattern);
+    search->pattern = g_strdup (pattern);
+    search->regex = regex;
+    search->n_entries = items->len;
+    search->entries = g_new (GPasteHistorySearchEntry, items->len);
 
-    const GPasteHistoryPrivate *priv = _g_paste_history_get_instance_private (self);
-    g_autoptr (GError) error = NULL;
-    g_autoptr (GRegex) regex = g_regex_new (pattern,
-                                            G_REGEX_CASELESS|G_REGEX_MULTILINE|G_REGEX_DOTALL|G_REGEX_OPTIMIZE,
-                                            G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY,
-                                            &error);
+    /* The items can be removed or renamed meanwhile, keep them alive and copy what can change */
+    for (guint i = 0; i < items->len; ++i)
+    {
+        GPasteItem *item = g_ptr_array_index (items, i);
+        GPasteHistorySearchEntry *entry = &search->entries[i];
+
+        entry->item = g_object_ref (item);
+        entry->uuid = g_strdup (g_paste_item_get_uuid (item));
+        entry->name = g_strdup (g_paste_history_item_get_password_name (item));
+        /* Close enough to the length of the value, without going through it */
+        total_size += g_paste_item_get_size (item);
+    }
 
-    if (error)
+    search->matches = g_new0 (gboolean, search->n_entries);
+    g_task_set_task_data (task, search, g_paste_history_search_free);
+
+    if (!search->n_entries)
     {
-        g_warning ("error while creating regex: %s", error->message);
-        return NULL;
+        g_task_return_pointer (task, g_paste_history_search_merge (search), (GDestroyNotify) g_strfreev);
+        return;
     }
-    if (!regex)
-        return NULL;
 
-    g_autoptr (GArray) results = g_array_new (TRUE, /* zero-terminated */
-                                              TRUE, /* clear */
-                                              sizeof (gchar *));
-    guint64 index = 0;
+    /* Split the history in chunks of about the same size, one per processor */
+    guint64 chunk_size = MAX (total_size / g_get_num_processors (), G_PASTE_HISTORY_SEARCH_MIN_CHUNK_SIZE);
+    g_autoptr (GArray) bounds = g_array_new (FALSE, FALSE, sizeof (guint));
+    guint64 current_size = 0;
 
-    for (GList *history = priv->history; history; history = g_list_next (history), ++index)
+    for (guint i = 0; i < search->n_entries; ++i)
     {
-        const GPasteItem *item = (GPasteItem *) history->data;
-        const gchar *uuid = g_paste_item_get_uuid (item);
-        gboolean match = FALSE;
-
-        if (g_paste_str_equal (pattern, uuid))
-            match = TRUE;
-        else if (_G_PASTE_IS_PASSWORD_ITEM (item) && g_paste_str_equal(pattern, g_paste_password_item_get_name (_G_PASTE_PASSWORD_ITEM (item))))
-            match = TRUE;
-        else if (g_regex_match (regex, g_paste_item_get_value (item), G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY, NULL))
-            match = TRUE;
-
-        if (match)
+        current_size += g_paste_item_get_size (search->entries[i].item);
+        if (current_size >= chunk_size || i == search->n_entries - 1)
         {
-            gchar *id = g_strdup (uuid);
-            g_array_append_val (results, id);
+            guint end = i + 1;
+
+            g_array_append_val (bounds, end);
+            current_size = 0;
         }
     }
 
-    return g_array_steal (results, NULL);
+    /* Every chunk must be accounted for before the first one may finish */
+    search->pending = bounds->len;
+
+    for (guint c = 0, begin = 0; c < bounds->len; ++c)
+    {
+        GPasteHistorySearchChunk *chunk = g_new (GPasteHistorySearchChunk, 1);
+
+        chunk->task = g_object_ref (task);
+        chunk->begin = begin;
+        chunk->end = begin = g_array_index (bounds, guint, c);
+
+        g_thread_pool_push (g_paste_history_get_search_pool (), chunk, NULL);
+    }
+}
+
+/**
+ * g_paste_history_search_finish:
+ * @self: a #GPasteHistory instance
+ * @result: the #GAsyncResult passed to the #GAsyncReadyCallback
+ * @error: a #GError
+ *
+ * Get the result of g_paste_history_search_async
+ *
+ * Returns: (transfer full): The uuids of the matching elements, in history order
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_history_search_finish (GPasteHistory *self,
+                               GAsyncResult  *result,
+                               GError       **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (self), NULL);
+    g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
 }
 
+/**************************/
+/* End parallel searching */
+/**************************/
+
 /**
  * g_paste_history_new:
  * @settings: (transfer none): a #GPasteSettings instance
@@ -1152,6 +2576,11 @@ g_paste_history_list (GError **error)
 {
     g_return_val_if_fail (!error || !(*error), NULL);
 
+    GStrv cataloged = g_paste_history_catalog_list ();
+
+    if (cataloged)
+        return cataloged;
+
     g_autoptr (GArray) history_names = g_array_new (TRUE, /* zero-terminated */
                                                     TRUE, /* clear */
                                                     sizeof (gchar *));
@@ -1164,6 +2593,8 @@ g_paste_history_list (GError **error)
     if (error && *error)
         return NULL;
 
+    /* Names are owned by history_names */
+    g_autoptr (GHashTable) seen = g_hash_table_new (g_str_hash, g_str_equal);
     GFileInfo *history;
 
     while ((history = g_file_enumerator_next_file (histories,
@@ -1180,14 +2611,25 @@ g_paste_history_list (GError **error)
 
         const gchar *raw_name = g_file_info_get_display_name (h);
 
-        if (g_str_has_suffix (raw_name, ".xml"))
+        /* XML histories, or binary ones, see GPasteBinaryBackend */
+        if (g_str_has_suffix (raw_name, ".xml") || g_str_has_suffix (raw_name, ".bin"))
         {
-            gchar *name = g_strdup (raw_name);
+            gchar *name = g_strndup (raw_name, strlen (raw_name) - 4);
+
+            if (g_hash_table_contains (seen, name))
+            {
+                g_free (name);
+                continue;
+            }
 
-            name[strlen (name) - 4] = '\0';
+            g_hash_table_add (seen, name);
             g_array_append_val (history_names, name);
         }
     }
 
-    return g_strdupv ((GStrv) (gpointer) history_names->data);
+    GStrv names = g_strdupv ((GStrv) (gpointer) history_names->data);
+
+    g_paste_history_catalog_sync ((const gchar * const *) names);
+
+    return names;
 }
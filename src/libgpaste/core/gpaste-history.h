@@ -11,7 +11,9 @@
 #ifndef __G_PASTE_HISTORY_H__
 #define __G_PASTE_HISTORY_H__
 
+#include <gpaste-change-enums.h>
 #include <gpaste-password-item.h>
+#include <gpaste-search-enums.h>
 #include <gpaste-settings.h>
 
 G_BEGIN_DECLS
@@ -20,6 +22,26 @@ G_BEGIN_DECLS
 
 G_PASTE_FINAL_TYPE (History, history, HISTORY, GObject)
 
+/**
+ * GPasteHistoryChange:
+ * @seq: the sequence number of the batch of changes this one belongs to
+ * @kind: what happened
+ * @position: where the item now is (where it was for REMOVE, unused for RESET)
+ * @old_position: where the item was, for MOVE
+ * @uuid: (nullable): the uuid of the item, %NULL for RESET
+ *
+ * A single change to a #GPasteHistory, changes from a batch
+ * have to be applied in order
+ */
+typedef struct
+{
+    guint64          seq;
+    GPasteChangeKind kind;
+    guint64          position;
+    guint64          old_position;
+    gchar           *uuid;
+} GPasteHistoryChange;
+
 void              g_paste_history_add                (GPasteHistory *self,
                                                       GPasteItem    *item);
 void              g_paste_history_remove             (GPasteHistory *self,
@@ -53,6 +75,7 @@ void                      g_paste_history_rename_password (GPasteHistory *self,
 void         g_paste_history_empty       (GPasteHistory *self);
 void         g_paste_history_save        (GPasteHistory *self,
                                           const gchar   *name);
+void         g_paste_history_flush       (GPasteHistory *self);
 void         g_paste_history_load        (GPasteHistory *self,
                                           const gchar   *name);
 void         g_paste_history_switch      (GPasteHistory *self,
@@ -63,9 +86,39 @@ void         g_paste_history_delete      (GPasteHistory *self,
 const GList *g_paste_history_get_history (const GPasteHistory *self);
 guint64      g_paste_history_get_length  (const GPasteHistory *self);
 const gchar *g_paste_history_get_current (const GPasteHistory *self);
+guint64      g_paste_history_get_seq     (const GPasteHistory *self);
+
+void g_paste_history_freeze_updates (GPasteHistory *self);
+void g_paste_history_thaw_updates   (GPasteHistory *self);
+
+GPtrArray *g_paste_history_get_changes_since (const GPasteHistory *self,
+                                              guint64              seq);
+
+guint64 g_paste_history_get_saved_length (const GPasteHistory *self,
+                                          const gchar         *name);
 
-GStrv g_paste_history_search (const GPasteHistory *self,
-                              const gchar         *pattern);
+GStrv g_paste_history_search              (const GPasteHistory *self,
+                                           const gchar         *pattern);
+void  g_paste_history_search_async        (GPasteHistory       *self,
+                                           const gchar         *pattern,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data);
+GStrv g_paste_history_search_finish       (GPasteHistory       *self,
+                                           GAsyncResult        *result,
+                                           GError             **error);
+GStrv g_paste_history_search_with_options (const GPasteHistory *self,
+                                           const gchar         *pattern,
+                                           GPasteSearchMode     mode,
+                                           guint64              offset,
+                                           guint64              limit);
+GStrv g_paste_history_search_within       (const GPasteHistory *self,
+                                           const gchar         *pattern,
+                                           const gchar * const *uuids);
+GStrv g_paste_history_search_saved        (const GPasteHistory *self,
+                                           const gchar         *name,
+                                           const gchar         *pattern,
+                                           GError             **error);
 
 GPasteHistory *g_paste_history_new (GPasteSettings *settings);
 
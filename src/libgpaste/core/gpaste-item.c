@@ -14,7 +14,10 @@ typedef struct
     gchar  *value;
     GSList *special_values;
     gchar  *display_string;
+    gchar  *preview;
+    guint64 preview_size;
     guint64 size;
+    guint64 hash;
 } GPasteItemPrivate;
 
 G_PASTE_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (Item, item, G_TYPE_OBJECT)
@@ -136,6 +139,25 @@ g_paste_item_get_display_string (const GPasteItem *self)
     return (display_string) ? display_string : priv->value;
 }
 
+/**
+ * g_paste_item_get_preview:
+ * @self: a #GPasteItem instance
+ *
+ * Get the bounded, single line, version of the display string
+ * we send to whoever only wants to list the items
+ *
+ * Returns: read-only preview
+ */
+G_PASTE_VISIBLE const gchar *
+g_paste_item_get_preview (const GPasteItem *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_ITEM (self), NULL);
+
+    const GPasteItemPrivate *priv = _g_paste_item_get_instance_private (self);
+
+    return (priv->preview) ? priv->preview : g_paste_item_get_display_string (self);
+}
+
 /**
  * g_paste_item_equals:
  * @self: a #GPasteItem instance
@@ -158,6 +180,25 @@ g_paste_item_equals (const GPasteItem *self,
     return _G_PASTE_ITEM_GET_CLASS (self)->equals (self, other) && _G_PASTE_ITEM_GET_CLASS (other)->equals (other, self);
 }
 
+/**
+ * g_paste_item_get_hash:
+ * @self: a #GPasteItem instance
+ *
+ * Get the hash of the value of the #GPasteItem, computed once at creation.
+ * Items with different hashes are never equal.
+ *
+ * Returns: The 64-bit hash of its value
+ */
+G_PASTE_VISIBLE guint64
+g_paste_item_get_hash (const GPasteItem *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_ITEM (self), 0);
+
+    const GPasteItemPrivate *priv = _g_paste_item_get_instance_private (self);
+
+    return priv->hash;
+}
+
 /**
  * g_paste_item_get_kind:
  * @self: a #GPasteItem instance
@@ -253,6 +294,69 @@ g_paste_item_remove_size (GPasteItem *self,
     priv->size -= size;
 }
 
+/*
+ * The preview is the display string cut after preview_size characters,
+ * with its newlines flattened. We only keep it when it differs from the
+ * display string, and don't count it in the size of the item as it is
+ * only a bounded cache of it.
+ */
+static void
+g_paste_item_private_update_preview (GPasteItemPrivate *priv)
+{
+    g_clear_pointer (&priv->preview, g_free);
+
+    if (!priv->preview_size)
+        return;
+
+    const gchar *display = (priv->display_string) ? priv->display_string : priv->value;
+    const gchar *end = display;
+    gboolean multiline = FALSE;
+
+    for (guint64 i = 0; *end && i < priv->preview_size; ++i, end = g_utf8_next_char (end))
+    {
+        if (*end == '\n' || *end == '\r')
+            multiline = TRUE;
+    }
+
+    if (!*end && !multiline)
+        return;
+
+    GString *preview = g_string_new_len (display, end - display);
+
+    for (gchar *c = preview->str; *c; ++c)
+    {
+        if (*c == '\n' || *c == '\r')
+            *c = ' ';
+    }
+
+    if (*end)
+        g_string_append (preview, "…");
+
+    priv->preview = g_string_free (preview, FALSE);
+}
+
+/**
+ * g_paste_item_set_preview_size:
+ * @self: a #GPasteItem instance
+ * @preview_size: the number of characters to keep in the preview, 0 for all of them
+ *
+ * Set how many characters of the display string the preview should keep
+ */
+G_PASTE_VISIBLE void
+g_paste_item_set_preview_size (GPasteItem *self,
+                               guint64     preview_size)
+{
+    g_return_if_fail (_G_PASTE_IS_ITEM (self));
+
+    GPasteItemPrivate *priv = g_paste_item_get_instance_private (self);
+
+    if (priv->preview_size == preview_size)
+        return;
+
+    priv->preview_size = preview_size;
+    g_paste_item_private_update_preview (priv);
+}
+
 /**
  * g_paste_item_set_display_string:
  * @self: a #GPasteItem instance
@@ -281,6 +385,8 @@ g_paste_item_set_display_string (GPasteItem  *self,
     }
     else
         priv->display_string = NULL;
+
+    g_paste_item_private_update_preview (priv);
 }
 
 /**
@@ -352,6 +458,7 @@ g_paste_item_finalize (GObject *object)
     g_free (priv->uuid);
     g_free (priv->value);
     g_free (priv->display_string);
+    g_free (priv->preview);
 
     for (GSList *sv = priv->special_values; sv; sv = sv->next)
     {
@@ -365,6 +472,21 @@ g_paste_item_finalize (GObject *object)
     G_OBJECT_CLASS (g_paste_item_parent_class)->finalize (object);
 }
 
+/* 64-bit FNV-1a */
+static guint64
+g_paste_item_compute_hash (const gchar *value)
+{
+    guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+
+    for (const guchar *p = (const guchar *) value; *p; ++p)
+    {
+        hash ^= *p;
+        hash *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+
+    return hash;
+}
+
 static gboolean
 g_paste_item_default_equals (const GPasteItem *self,
                              const GPasteItem *other)
@@ -423,6 +545,9 @@ g_paste_item_new (GType        type,
     priv->uuid = g_uuid_string_random ();
     priv->value = g_strdup (value);
     priv->display_string = NULL;
+    priv->preview = NULL;
+    priv->preview_size = 0;
+    priv->hash = g_paste_item_compute_hash (priv->value);
 
     priv->size = strlen (priv->value) + 1;
 
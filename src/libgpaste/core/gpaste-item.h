@@ -51,10 +51,12 @@ const GSList *g_paste_item_get_special_values (const GPasteItem *self);
 const gchar  *g_paste_item_get_special_value  (const GPasteItem *self,
                                                GPasteSpecialAtom atom);
 const gchar  *g_paste_item_get_display_string (const GPasteItem *self);
+const gchar  *g_paste_item_get_preview        (const GPasteItem *self);
 gboolean      g_paste_item_equals             (const GPasteItem *self,
                                                const GPasteItem *other);
 const gchar  *g_paste_item_get_kind           (const GPasteItem *self);
 guint64       g_paste_item_get_size           (const GPasteItem *self);
+guint64       g_paste_item_get_hash           (const GPasteItem *self);
 
 void g_paste_item_set_state (GPasteItem     *self,
                              GPasteItemState state);
@@ -63,6 +65,8 @@ void g_paste_item_set_uuid  (GPasteItem     *self,
 
 void g_paste_item_set_display_string (GPasteItem               *self,
                                       const gchar              *display_string);
+void g_paste_item_set_preview_size   (GPasteItem               *self,
+                                      guint64                   preview_size);
 void g_paste_item_add_special_value  (GPasteItem               *self,
                                       const GPasteSpecialValue *special_value);
 
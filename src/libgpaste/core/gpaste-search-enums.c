@@ -0,0 +1,26 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-macros.h>
+#include <gpaste-search-enums.h>
+
+G_PASTE_VISIBLE GType
+g_paste_search_mode_get_type (void)
+{
+    static GType etype = 0;
+    if (!etype)
+    {
+        static const GEnumValue values[] = {
+            { G_PASTE_SEARCH_MODE_LITERAL, "G_PASTE_SEARCH_MODE_LITERAL", "LITERAL" },
+            { G_PASTE_SEARCH_MODE_REGEX,   "G_PASTE_SEARCH_MODE_REGEX",   "REGEX"   },
+            { G_PASTE_SEARCH_MODE_FUZZY,   "G_PASTE_SEARCH_MODE_FUZZY",   "FUZZY"   },
+            { G_PASTE_SEARCH_MODE_INVALID, NULL,                          NULL      }
+        };
+        etype = g_enum_register_static (g_intern_static_string ("GPasteSearchMode"), values);
+        g_type_class_ref (etype);
+    }
+    return etype;
+}
@@ -0,0 +1,30 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_SEARCH_ENUMS_H__
+#define __G_PASTE_SEARCH_ENUMS_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+    G_PASTE_SEARCH_MODE_LITERAL = 1,
+    G_PASTE_SEARCH_MODE_REGEX,
+    G_PASTE_SEARCH_MODE_FUZZY,
+    G_PASTE_SEARCH_MODE_INVALID = 0
+} GPasteSearchMode;
+
+#define G_PASTE_TYPE_SEARCH_MODE (g_paste_search_mode_get_type ())
+GType g_paste_search_mode_get_type (void);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_SEARCH_ENUMS_H__*/
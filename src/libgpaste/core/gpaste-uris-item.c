@@ -4,6 +4,7 @@
  * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
  */
 
+#include <gpaste-replacer.h>
 #include <gpaste-uris-item.h>
 #include <gpaste-util.h>
 
@@ -79,6 +80,23 @@ g_paste_uris_item_init (GPasteUrisItem *self G_GNUC_UNUSED)
 {
 }
 
+static const GPasteReplacer *
+g_paste_uris_item_get_display_replacer (void)
+{
+    static gsize initialized = 0;
+    static GPasteReplacer *replacer = NULL;
+
+    if (g_once_init_enter (&initialized))
+    {
+        replacer = g_paste_replacer_new ();
+        g_paste_replacer_add (replacer, g_get_home_dir (), "~");
+        g_paste_replacer_add (replacer, "\n", " ");
+        g_once_init_leave (&initialized, 1);
+    }
+
+    return replacer;
+}
+
 /**
  * g_paste_uris_item_new:
  * @uris: a string containing the paths separated by "\n" (as returned by gtk_clipboard_wait_for_uris)
@@ -97,8 +115,7 @@ g_paste_uris_item_new (const gchar *uris)
     GPasteItem *self = g_paste_item_new (G_PASTE_TYPE_URIS_ITEM, uris);
     GPasteUrisItemPrivate *priv = g_paste_uris_item_get_instance_private (G_PASTE_URIS_ITEM (self));
 
-    g_autofree gchar *display_string_with_newlines = g_paste_util_replace (uris, g_get_home_dir (), "~");
-    g_autofree gchar *display_string = g_paste_util_replace (display_string_with_newlines, "\n", " ");
+    g_autofree gchar *display_string = g_paste_replacer_replace (g_paste_uris_item_get_display_replacer (), uris);
 
     // This is the prefix displayed in history to identify selected files
     g_autofree gchar *full_display_string = g_strconcat (_("[Files] "), display_string, NULL);
@@ -18,6 +18,9 @@
 #include <gpaste-update-enums.h>
 #include <gpaste-upload-keybinding.h>
 
+#include <gio/gunixfdlist.h>
+#include <glib/gstdio.h>
+
 #include <string.h>
 
 #define G_PASTE_SEND_DBUS_SIGNAL_FULLER(interface, sig, data, error) \
@@ -63,6 +66,7 @@
 enum
 {
     C_UPDATE,
+    C_CHANGED,
     C_SWITCH,
     C_TRACK,
     C_ACTIVE_CHANGED,
@@ -167,6 +171,34 @@ g_paste_daemon_get_dbus_uint64_parameter (GVariant *parameters)
     return g_variant_get_uint64 (variant);
 }
 
+/* The contents of the memfd sent along with the call, @handle being its index */
+static GBytes *
+g_paste_daemon_get_dbus_fd_parameter (GDBusMethodInvocation *invocation,
+                                      GVariant              *handle,
+                                      gsize                  max_length,
+                                      GError               **error)
+{
+    GUnixFDList *fd_list = g_dbus_message_get_unix_fd_list (g_dbus_method_invocation_get_message (invocation));
+    gint32 index = g_variant_get_handle (handle);
+
+    if (!fd_list || index < 0 || index >= g_unix_fd_list_get_length (fd_list))
+    {
+        g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS, "no file descriptor received");
+        return NULL;
+    }
+
+    gint fd = g_unix_fd_list_get (fd_list, index, error);
+
+    if (fd < 0)
+        return NULL;
+
+    GBytes *contents = g_paste_util_memfd_read (fd, max_length, error);
+
+    g_close (fd, NULL);
+
+    return contents;
+}
+
 /****************/
 /* DBus Signals */
 /****************/
@@ -187,6 +219,24 @@ g_paste_daemon_update (GPasteDaemon      *self,
     G_PASTE_SEND_DBUS_SIGNAL_FULL (UPDATE, g_variant_new_tuple (data, 3), NULL);
 }
 
+/**
+ * g_paste_daemon_get_history:
+ * @self: (transfer none): the #GPasteDaemon
+ *
+ * Get the history managed by the daemon, to use it from within the same process
+ *
+ * Returns: (transfer none): the #GPasteHistory
+ */
+G_PASTE_VISIBLE GPasteHistory *
+g_paste_daemon_get_history (GPasteDaemon *self)
+{
+    g_return_val_if_fail (_G_PASTE_IS_DAEMON (self), NULL);
+
+    const GPasteDaemonPrivate *priv = _g_paste_daemon_get_instance_private (self);
+
+    return priv->history;
+}
+
 /**
  * g_paste_daemon_show_history:
  * @self: (transfer none): the #GPasteDaemon
@@ -229,6 +279,35 @@ g_paste_daemon_private_do_add_item (const GPasteDaemonPrivate *priv,
         g_paste_history_remove (priv->history, 0);
 }
 
+/* Returns NULL if the settings tell us not to keep @text */
+static GPasteItem *
+g_paste_daemon_private_new_text_item (const GPasteDaemonPrivate *priv,
+                                      const gchar               *text,
+                                      guint64                    length)
+{
+    GPasteSettings *settings = priv->settings;
+
+    if (length < g_paste_settings_get_min_text_item_size (settings) ||
+        length > g_paste_settings_get_max_text_item_size (settings))
+        return NULL;
+
+    /* Find what g_strstrip would keep, without copying the whole text to know it */
+    const gchar *start = text, *end = text + length;
+
+    while (start < end && g_ascii_isspace (*start))
+        ++start;
+    while (end > start && g_ascii_isspace (end[-1]))
+        --end;
+
+    if (start == end)
+        return NULL;
+
+    /* @text may not be nul-terminated, see AddFd */
+    g_autofree gchar *value = (g_paste_settings_get_trim_items (settings)) ? g_strndup (start, end - start) : g_strndup (text, length);
+
+    return g_paste_text_item_new (value);
+}
+
 static void
 g_paste_daemon_private_do_add (const GPasteDaemonPrivate *priv,
                                const gchar               *text,
@@ -237,16 +316,10 @@ g_paste_daemon_private_do_add (const GPasteDaemonPrivate *priv,
 {
     G_PASTE_DBUS_ASSERT (text && length, "no content to add");
 
-    GPasteSettings *settings = priv->settings;
-    g_autofree gchar *stripped = g_strstrip (g_strdup (text));
+    GPasteItem *item = g_paste_daemon_private_new_text_item (priv, text, length);
 
-    if (length >= g_paste_settings_get_min_text_item_size (settings) &&
-        length <= g_paste_settings_get_max_text_item_size (settings) &&
-        strlen (stripped) != 0)
-    {
-        g_paste_daemon_private_do_add_item (priv,
-                                            g_paste_text_item_new (g_paste_settings_get_trim_items (settings) ? stripped : text));
-    }
+    if (item)
+        g_paste_daemon_private_do_add_item (priv, item);
 }
 
 static void
@@ -254,12 +327,45 @@ g_paste_daemon_private_add (const GPasteDaemonPrivate *priv,
                             GVariant                  *parameters,
                             GPasteDBusError          **err)
 {
-    guint64 length;
-    g_autofree gchar *text = g_paste_daemon_get_dbus_string_parameter (parameters, &length);
+    g_autoptr (GVariant) variant = g_variant_get_child_value (parameters, 0);
+    gsize length;
+    const gchar *text = g_variant_get_string (variant, &length);
 
     g_paste_daemon_private_do_add (priv, text, length, err);
 }
 
+static void
+g_paste_daemon_private_add_fd (const GPasteDaemonPrivate *priv,
+                               GVariant                  *parameters,
+                               GDBusMethodInvocation     *invocation,
+                               GError                   **error,
+                               GPasteDBusError          **err)
+{
+    g_autoptr (GVariant) handle = g_variant_get_child_value (parameters, 0);
+    g_autoptr (GError) read_error = NULL;
+    g_autoptr (GBytes) contents = g_paste_daemon_get_dbus_fd_parameter (invocation,
+                                                                        handle,
+                                                                        g_paste_settings_get_max_text_item_size (priv->settings),
+                                                                        &read_error);
+
+    if (!contents)
+    {
+        /* Just like Add, ignore what is too large to be kept without complaining */
+        if (!g_error_matches (read_error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE))
+            g_propagate_error (error, g_steal_pointer (&read_error));
+        return;
+    }
+
+    gsize length;
+    const gchar *data = g_bytes_get_data (contents, &length);
+
+    G_PASTE_DBUS_ASSERT (length, "no content to add");
+    G_PASTE_DBUS_ASSERT (g_utf8_validate (data, length, NULL), "cannot add non utf8 data as text");
+
+    /* Straight from the mapped memfd, which do_add copies only once */
+    g_paste_daemon_private_do_add (priv, data, length, err);
+}
+
 static void
 g_paste_daemon_private_add_file (const GPasteDaemonPrivate *priv,
                                  GVariant                  *parameters,
@@ -290,6 +396,46 @@ g_paste_daemon_private_add_file (const GPasteDaemonPrivate *priv,
     }
 }
 
+static void
+g_paste_daemon_private_add_many (const GPasteDaemonPrivate *priv,
+                                 GVariant                  *parameters,
+                                 GPasteDBusError          **err)
+{
+    g_autoptr (GVariant) variant = g_variant_get_child_value (parameters, 0);
+    guint64 length;
+    g_autofree const gchar **texts = g_variant_get_strv (variant, &length);
+
+    G_PASTE_DBUS_ASSERT (length, "no content to add");
+
+    GPasteHistory *history = priv->history;
+    gboolean added = FALSE;
+
+    /* Save and announce the whole batch at once */
+    g_paste_history_freeze_updates (history);
+
+    for (guint64 i = 0; i < length; ++i)
+    {
+        GPasteItem *item = g_paste_daemon_private_new_text_item (priv, texts[i], strlen (texts[i]));
+
+        if (item)
+        {
+            g_paste_history_add (history, item);
+            added = TRUE;
+        }
+    }
+
+    /* Only the newest one makes it to the clipboards, as if they had been added one by one */
+    if (added && g_paste_history_get_length (history))
+    {
+        g_autoptr (GPasteItem) first = g_paste_history_dup (history, 0);
+
+        if (!g_paste_clipboards_manager_select (priv->clipboards_manager, first))
+            g_paste_history_remove (history, 0);
+    }
+
+    g_paste_history_thaw_updates (history);
+}
+
 static void
 g_paste_daemon_private_add_password (const GPasteDaemonPrivate *priv,
                                      GVariant                  *parameters,
@@ -351,6 +497,9 @@ g_paste_daemon_private_backup_history (const GPasteDaemonPrivate *priv,
     g_autoptr (GPasteHistory) _history = g_paste_history_new (settings);
     const gchar *old_name = g_paste_history_get_current (priv->history);
 
+    /* The backup is read from disk, make sure it's up to date */
+    g_paste_history_flush (priv->history);
+
     /* We emit all those signals to be sure that all the guis have their histories list updated */
     g_paste_history_load (_history, history);
     g_paste_daemon_private_switch_history_signal (priv, history);
@@ -369,6 +518,29 @@ g_paste_daemon_private_delete (const GPasteDaemonPrivate *priv,
     G_PASTE_DBUS_ASSERT (g_paste_history_remove_by_uuid (priv->history, uuid), "Provided uuid doesn't match any item.");
 }
 
+static void
+g_paste_daemon_private_delete_many (const GPasteDaemonPrivate *priv,
+                                    GVariant                  *parameters,
+                                    GPasteDBusError          **err)
+{
+    g_autoptr (GVariant) variant = g_variant_get_child_value (parameters, 0);
+    guint64 length;
+    g_autofree const gchar **uuids = g_variant_get_strv (variant, &length);
+
+    G_PASTE_DBUS_ASSERT (length, "nothing to delete");
+
+    GPasteHistory *history = priv->history;
+
+    /* Either everything goes or nothing does */
+    for (guint64 i = 0; i < length; ++i)
+        G_PASTE_DBUS_ASSERT (g_paste_history_get_by_uuid (history, uuids[i]), "Provided uuid doesn't match any item.");
+
+    g_paste_history_freeze_updates (history);
+    for (guint64 i = 0; i < length; ++i)
+        g_paste_history_remove_by_uuid (history, uuids[i]);
+    g_paste_history_thaw_updates (history);
+}
+
 static void
 g_paste_daemon_private_delete_history (const GPasteDaemonPrivate *priv,
                                        GVariant                  *parameters,
@@ -429,7 +601,7 @@ g_paste_daemon_private_get_element (const GPasteDaemonPrivate *priv,
 
     G_PASTE_DBUS_ASSERT_FULL (item, "Provided uuid doesn't match any item.", NULL);
 
-    GVariant *variant = g_variant_new_string (g_paste_item_get_display_string (item));
+    GVariant *variant = g_variant_new_string (g_paste_item_get_preview (item));
     return g_variant_new_tuple (&variant, 1);
 }
 
@@ -449,7 +621,7 @@ g_paste_daemon_private_get_element_at_index (const GPasteDaemonPrivate *priv,
 
     GVariant *data[] = {
         g_variant_new_string (g_paste_item_get_uuid (item)),
-        g_variant_new_string (g_paste_item_get_display_string (item))
+        g_variant_new_string (g_paste_item_get_preview (item))
     };
 
     return g_variant_new_tuple (data, 2);
@@ -492,7 +664,38 @@ g_paste_daemon_private_get_elements (const GPasteDaemonPrivate *priv,
     {
         const GPasteItem *item = g_paste_history_get_by_uuid (history, uuids[i]);
         G_PASTE_DBUS_ASSERT_FULL (item, "received no value for this index", NULL);
-        g_variant_builder_add (&builder, "(ss)", g_paste_item_get_uuid (item), g_paste_item_get_display_string (item));
+        g_variant_builder_add (&builder, "(ss)", g_paste_item_get_uuid (item), g_paste_item_get_preview (item));
+    }
+
+    GVariant *ans = g_variant_builder_end (&builder);
+
+    return g_variant_new_tuple (&ans, 1);
+}
+
+/* Parameters are (offset, count), a whole page of a list view in one call */
+static GVariant *
+g_paste_daemon_private_get_elements_range (const GPasteDaemonPrivate *priv,
+                                           GVariant                  *parameters)
+{
+    GPasteHistory *history = priv->history;
+    GVariantIter parameters_iter;
+    GVariantBuilder builder;
+
+    g_variant_iter_init (&parameters_iter, parameters);
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sss)"));
+
+    g_autoptr (GVariant) v_offset = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) v_count = g_variant_iter_next_value (&parameters_iter);
+    guint64 offset = g_variant_get_uint64 (v_offset);
+    guint64 length = g_paste_history_get_length (history);
+    /* Don't complain about pages going past the end, the history may have shrunk */
+    guint64 end = (offset < length) ? offset + MIN (g_variant_get_uint64 (v_count), length - offset) : offset;
+
+    for (guint64 i = offset; i < end; ++i)
+    {
+        const GPasteItem *item = g_paste_history_get (history, i);
+
+        g_variant_builder_add (&builder, "(sss)", g_paste_item_get_uuid (item), g_paste_item_get_kind (item), g_paste_item_get_preview (item));
     }
 
     GVariant *ans = g_variant_builder_end (&builder);
@@ -500,6 +703,61 @@ g_paste_daemon_private_get_elements (const GPasteDaemonPrivate *priv,
     return g_variant_new_tuple (&ans, 1);
 }
 
+/* For RESET, the position is the new length of the history */
+static GVariant *
+g_paste_daemon_private_get_changes (const GPasteDaemonPrivate *priv,
+                                    guint64                    seq)
+{
+    GPasteHistory *history = priv->history;
+    g_autoptr (GPtrArray) changes = g_paste_history_get_changes_since (history, seq);
+    GEnumClass *kinds = g_type_class_peek (G_PASTE_TYPE_CHANGE_KIND);
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sttsss)"));
+
+    if (!changes)
+    {
+        /* Some of them are forgotten already, start over */
+        g_variant_builder_add (&builder, "(sttsss)",
+                               g_enum_get_value (kinds, G_PASTE_CHANGE_KIND_RESET)->value_nick,
+                               g_paste_history_get_length (history),
+                               (guint64) 0,
+                               "", "", "");
+        return g_variant_builder_end (&builder);
+    }
+
+    for (guint i = 0; i < changes->len; ++i)
+    {
+        const GPasteHistoryChange *change = g_ptr_array_index (changes, i);
+        gboolean reset = (change->kind == G_PASTE_CHANGE_KIND_RESET);
+        /* The item may be gone since */
+        const GPasteItem *item = (change->uuid && change->kind != G_PASTE_CHANGE_KIND_REMOVE) ? g_paste_history_get_by_uuid (history, change->uuid) : NULL;
+
+        g_variant_builder_add (&builder, "(sttsss)",
+                               g_enum_get_value (kinds, change->kind)->value_nick,
+                               (reset) ? g_paste_history_get_length (history) : change->position,
+                               change->old_position,
+                               (change->uuid) ? change->uuid : "",
+                               (item) ? g_paste_item_get_kind (item) : "",
+                               (item) ? g_paste_item_get_preview (item) : "");
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+g_paste_daemon_private_get_changes_since (const GPasteDaemonPrivate *priv,
+                                          GVariant                  *parameters)
+{
+    guint64 seq = g_paste_daemon_get_dbus_uint64_parameter (parameters);
+    GVariant *ans[] = {
+        g_variant_new_uint64 (g_paste_history_get_seq (priv->history)),
+        g_paste_daemon_private_get_changes (priv, seq)
+    };
+
+    return g_variant_new_tuple (ans, 2);
+}
+
 static GVariant *
 g_paste_daemon_private_get_history (const GPasteDaemonPrivate *priv)
 {
@@ -512,7 +770,7 @@ g_paste_daemon_private_get_history (const GPasteDaemonPrivate *priv)
     for (guint64 i = 0; i < length; ++i, history = g_list_next (history))
     {
         const GPasteItem *item = history->data;
-        g_variant_builder_add (&builder, "(ss)", g_paste_item_get_uuid (item), g_paste_item_get_display_string (item));
+        g_variant_builder_add (&builder, "(ss)", g_paste_item_get_uuid (item), g_paste_item_get_preview (item));
     }
 
     GVariant *variant = g_variant_builder_end (&builder);
@@ -532,21 +790,8 @@ g_paste_daemon_private_get_history_size (const GPasteDaemonPrivate *priv,
                                          GVariant                  *parameters)
 {
     g_autofree gchar *name = g_paste_daemon_get_dbus_string_parameter (parameters, NULL);
-    guint64 size;
-
-    if (g_paste_str_equal (name, g_paste_history_get_current (priv->history)))
-    {
-        size = g_paste_history_get_length (priv->history);
-    }
-    else
-    {
-        g_autoptr (GPasteHistory) history = g_paste_history_new (priv->settings);
-
-        g_paste_history_load (history, name);
-        size = g_paste_history_get_length (history);
-    }
-
-
+    /* Other histories are answered by the catalog, without loading them */
+    guint64 size = g_paste_history_get_saved_length (priv->history, name);
     GVariant *variant = g_variant_new_uint64 (size);
     return g_variant_new_tuple (&variant, 1);
 }
@@ -566,7 +811,7 @@ g_paste_daemon_private_get_raw_element (const GPasteDaemonPrivate *priv,
 }
 
 static GVariant *
-g_paste_daemon_private_get_raw_history (const GPasteDaemonPrivate *priv)
+g_paste_daemon_private_build_raw_history (const GPasteDaemonPrivate *priv)
 {
     const GList *history = g_paste_history_get_history (priv->history);
     guint64 length = g_list_length ((GList *) history);
@@ -580,11 +825,65 @@ g_paste_daemon_private_get_raw_history (const GPasteDaemonPrivate *priv)
         g_variant_builder_add (&builder, "(ss)", g_paste_item_get_uuid (item), g_paste_item_get_value (item));
     }
 
-    GVariant *variant = g_variant_builder_end (&builder);
+    return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+g_paste_daemon_private_get_raw_history (const GPasteDaemonPrivate *priv)
+{
+    GVariant *variant = g_paste_daemon_private_build_raw_history (priv);
+
+    return g_variant_new_tuple (&variant, 1);
+}
+
+/* Answer with the handle of a memfd holding @data, instead of @data itself */
+static GVariant *
+g_paste_daemon_get_dbus_fd_answer (const gchar  *name,
+                                   gconstpointer data,
+                                   gsize         length,
+                                   GUnixFDList **fd_list,
+                                   GError      **error)
+{
+    gint fd = g_paste_util_memfd_new (name, data, length, error);
+
+    if (fd < 0)
+        return NULL;
+
+    *fd_list = g_unix_fd_list_new_from_array (&fd, 1);
+
+    GVariant *variant = g_variant_new_handle (0);
 
     return g_variant_new_tuple (&variant, 1);
 }
 
+static GVariant *
+g_paste_daemon_private_get_raw_element_fd (const GPasteDaemonPrivate *priv,
+                                           GVariant                  *parameters,
+                                           GUnixFDList              **fd_list,
+                                           GError                   **error,
+                                           GPasteDBusError          **err)
+{
+    g_autofree gchar *uuid = g_paste_daemon_get_dbus_string_parameter (parameters, NULL);
+    const GPasteItem *item = g_paste_history_get_by_uuid (priv->history, uuid);
+
+    G_PASTE_DBUS_ASSERT_FULL (item, "Provided uuid doesn't match any item.", NULL);
+
+    const gchar *value = g_paste_item_get_value (item);
+
+    return g_paste_daemon_get_dbus_fd_answer ("gpaste-raw-element", value, strlen (value), fd_list, error);
+}
+
+/* The memfd holds the serialized "a(ss)" GVariant */
+static GVariant *
+g_paste_daemon_private_get_raw_history_fd (const GPasteDaemonPrivate *priv,
+                                           GUnixFDList              **fd_list,
+                                           GError                   **error)
+{
+    g_autoptr (GVariant) history = g_variant_ref_sink (g_paste_daemon_private_build_raw_history (priv));
+
+    return g_paste_daemon_get_dbus_fd_answer ("gpaste-raw-history", g_variant_get_data (history), g_variant_get_size (history), fd_list, error);
+}
+
 static GVariant *
 g_paste_daemon_list_histories (GError **error)
 {
@@ -663,12 +962,22 @@ g_paste_daemon_on_extension_state_changed (GPasteDaemon *self,
         g_paste_daemon_track (self, parameters);
 }
 
-static void
+/**
+ * g_paste_daemon_reexecute:
+ * @self: (transfer none): the #GPasteDaemon
+ *
+ * Store the clipboards, flush the history and
+ * emit the signal to reexecute the daemon
+ */
+G_PASTE_VISIBLE void
 g_paste_daemon_reexecute (GPasteDaemon *self)
 {
+    g_return_if_fail (_G_PASTE_IS_DAEMON (self));
+
     const GPasteDaemonPrivate *priv = _g_paste_daemon_get_instance_private (self);
 
     g_paste_clipboards_manager_store (priv->clipboards_manager);
+    g_paste_history_flush (priv->history);
 
     g_signal_emit (self,
                    signals[REEXECUTE_SELF],
@@ -691,13 +1000,167 @@ g_paste_daemon_private_rename_password (const GPasteDaemonPrivate *priv,
     g_paste_history_rename_password (priv->history, old_name, new_name);
 }
 
-static GVariant *
+static void
+on_search_ready (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+    GDBusMethodInvocation *invocation = user_data;
+    g_autoptr (GError) error = NULL;
+    g_auto (GStrv) results = g_paste_history_search_finish (G_PASTE_HISTORY (source_object), res, &error);
+
+    if (!results)
+    {
+        g_dbus_method_invocation_return_dbus_error (invocation, G_PASTE_BUS_NAME ".Error", "Error while performing search");
+        return;
+    }
+
+    GVariant *variant = g_variant_new_strv ((const gchar * const *) results, -1);
+    g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&variant, 1));
+}
+
+/* Answered asynchronously, the scan runs on other threads */
+static void
 g_paste_daemon_private_search (const GPasteDaemonPrivate *priv,
                                GVariant                  *parameters,
-                               GPasteDBusError          **err)
+                               GDBusMethodInvocation     *invocation)
+{
+    g_autofree gchar *search = g_paste_daemon_get_dbus_string_parameter (parameters, NULL);
+
+    g_paste_history_search_async (priv->history,
+                                  search,
+                                  NULL, /* cancellable */
+                                  on_search_ready,
+                                  invocation);
+}
+
+/* Parameters are (query, mode, offset, limit) */
+static GStrv
+_g_paste_daemon_private_search_with_options (const GPasteDaemonPrivate *priv,
+                                             GVariant                  *parameters,
+                                             GPasteDBusError          **err)
+{
+    GVariantIter parameters_iter;
+
+    g_variant_iter_init (&parameters_iter, parameters);
+
+    g_autoptr (GVariant) v_search = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) v_mode = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) v_offset = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) v_limit = g_variant_iter_next_value (&parameters_iter);
+    GEnumValue *mode = g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_SEARCH_MODE), g_variant_get_string (v_mode, NULL));
+
+    G_PASTE_DBUS_ASSERT_FULL (mode, "invalid search mode", NULL);
+
+    GStrv results = g_paste_history_search_with_options (priv->history,
+                                                         g_variant_get_string (v_search, NULL),
+                                                         mode->value,
+                                                         g_variant_get_uint64 (v_offset),
+                                                         g_variant_get_uint64 (v_limit));
+
+    G_PASTE_DBUS_ASSERT_FULL (results, "Error while performing search", NULL);
+
+    return results;
+}
+
+static GVariant *
+g_paste_daemon_private_search_with_options (const GPasteDaemonPrivate *priv,
+                                            GVariant                  *parameters,
+                                            GPasteDBusError          **err)
+{
+    g_auto (GStrv) results = _g_paste_daemon_private_search_with_options (priv, parameters, err);
+
+    if (!results)
+        return NULL;
+
+    GVariant *variant = g_variant_new_strv ((const gchar * const *) results, -1);
+    return g_variant_new_tuple (&variant, 1);
+}
+
+static GVariant *
+g_paste_daemon_private_search_previews (const GPasteDaemonPrivate *priv,
+                                        GVariant                  *parameters,
+                                        GPasteDBusError          **err)
+{
+    g_auto (GStrv) results = _g_paste_daemon_private_search_with_options (priv, parameters, err);
+
+    if (!results)
+        return NULL;
+
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sss)"));
+
+    for (GStrv uuid = results; *uuid; ++uuid)
+    {
+        const GPasteItem *item = g_paste_history_get_by_uuid (priv->history, *uuid);
+
+        g_variant_builder_add (&builder, "(sss)", *uuid, g_paste_item_get_kind (item), g_paste_item_get_preview (item));
+    }
+
+    GVariant *variant = g_variant_builder_end (&builder);
+    return g_variant_new_tuple (&variant, 1);
+}
+
+/* Other histories are searched through their saved index, without being loaded */
+static GVariant *
+g_paste_daemon_private_search_all_histories (const GPasteDaemonPrivate *priv,
+                                             GVariant                  *parameters,
+                                             GError                   **error)
 {
     g_autofree gchar *search = g_paste_daemon_get_dbus_string_parameter (parameters, NULL);
-    g_auto (GStrv) results = g_paste_history_search (priv->history, search);
+    g_auto (GStrv) history_names = g_paste_history_list (error);
+
+    if (!history_names)
+        return NULL;
+
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(ss)"));
+
+    for (GStrv name = history_names; *name; ++name)
+    {
+        g_autoptr (GError) search_error = NULL;
+        g_auto (GStrv) results = g_paste_history_search_saved (priv->history, *name, search, &search_error);
+
+        if (search_error)
+        {
+            /* The pattern is wrong, no need to try the other histories */
+            if (search_error->domain == G_REGEX_ERROR)
+            {
+                g_variant_builder_clear (&builder);
+                g_propagate_error (error, g_steal_pointer (&search_error));
+                return NULL;
+            }
+
+            g_warning ("Couldn't search history %s: %s", *name, search_error->message);
+            continue;
+        }
+        if (!results)
+            continue;
+
+        for (GStrv uuid = results; *uuid; ++uuid)
+            g_variant_builder_add (&builder, "(ss)", *name, *uuid);
+    }
+
+    GVariant *variant = g_variant_builder_end (&builder);
+
+    return g_variant_new_tuple (&variant, 1);
+}
+
+static GVariant *
+g_paste_daemon_private_search_within (const GPasteDaemonPrivate *priv,
+                                      GVariant                  *parameters,
+                                      GPasteDBusError          **err)
+{
+    GVariantIter parameters_iter;
+
+    g_variant_iter_init (&parameters_iter, parameters);
+
+    g_autoptr (GVariant) v_search = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) v_uuids = g_variant_iter_next_value (&parameters_iter);
+    g_autofree const gchar **uuids = g_variant_get_strv (v_uuids, NULL);
+    g_auto (GStrv) results = g_paste_history_search_within (priv->history, g_variant_get_string (v_search, NULL), uuids);
 
     G_PASTE_DBUS_ASSERT_FULL (results, "Error while performing search", NULL);
 
@@ -743,6 +1206,38 @@ g_paste_daemon_private_replace (const GPasteDaemonPrivate *priv,
     g_paste_history_replace (priv->history, uuid, contents);
 }
 
+static void
+g_paste_daemon_private_replace_fd (const GPasteDaemonPrivate *priv,
+                                   GVariant                  *parameters,
+                                   GDBusMethodInvocation     *invocation,
+                                   GError                   **error,
+                                   GPasteDBusError          **err)
+{
+    GPasteHistory *history = priv->history;
+    g_autoptr (GVariant) variant1 = g_variant_get_child_value (parameters, 0);
+    g_autoptr (GVariant) variant2 = g_variant_get_child_value (parameters, 1);
+    const gchar *uuid = g_variant_get_string (variant1, NULL);
+
+    const GPasteItem *item = g_paste_history_get_by_uuid (history, uuid);
+
+    G_PASTE_DBUS_ASSERT (item, "Provided uuid doesn't match any item.");
+    G_PASTE_DBUS_ASSERT (_G_PASTE_IS_TEXT_ITEM (item) && g_paste_str_equal (g_paste_item_get_kind (item), "Text"), "attempted to replace an item other than GPasteTextItem");
+
+    g_autoptr (GBytes) contents = g_paste_daemon_get_dbus_fd_parameter (invocation, variant2, G_MAXSIZE, error);
+
+    if (!contents)
+        return;
+
+    gsize length;
+    const gchar *data = g_bytes_get_data (contents, &length);
+
+    G_PASTE_DBUS_ASSERT (!length || g_utf8_validate (data, length, NULL), "cannot replace with non utf8 data");
+
+    g_autofree gchar *text = g_strndup (data, length);
+
+    g_paste_history_replace (history, uuid, text);
+}
+
 static void
 g_paste_daemon_private_set_password (const GPasteDaemonPrivate *priv,
                                      GVariant                  *parameters,
@@ -880,6 +1375,7 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
     GPasteDaemon *self = user_data;
     const GPasteDaemonPrivate *priv = _g_paste_daemon_get_instance_private (self);
     GVariant *answer = NULL;
+    g_autoptr (GUnixFDList) fd_list = NULL;
     GError *error = NULL;
     g_autofree GPasteDBusError *err = NULL;
 
@@ -887,8 +1383,12 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         g_paste_util_activate_ui ("about", NULL);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_ADD))
         g_paste_daemon_private_add (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_ADD_FD))
+        g_paste_daemon_private_add_fd (priv, parameters, invocation, &error, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_ADD_FILE))
         g_paste_daemon_private_add_file (priv, parameters, &error, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_ADD_MANY))
+        g_paste_daemon_private_add_many (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_ADD_PASSWORD))
         g_paste_daemon_private_add_password (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_BACKUP_HISTORY))
@@ -897,10 +1397,14 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         g_paste_daemon_private_delete (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_DELETE_HISTORY))
         g_paste_daemon_private_delete_history (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_DELETE_MANY))
+        g_paste_daemon_private_delete_many (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_DELETE_PASSWORD))
         g_paste_daemon_private_delete_password (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_EMPTY_HISTORY))
         g_paste_daemon_private_empty_history (priv, parameters);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_CHANGES_SINCE))
+        answer = g_paste_daemon_private_get_changes_since (priv, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_ELEMENT))
         answer = g_paste_daemon_private_get_element (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_ELEMENT_AT_INDEX))
@@ -909,6 +1413,8 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         answer = g_paste_daemon_private_get_element_kind (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_ELEMENTS))
         answer = g_paste_daemon_private_get_elements (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_ELEMENTS_RANGE))
+        answer = g_paste_daemon_private_get_elements_range (priv, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_HISTORY))
         answer = g_paste_daemon_private_get_history (priv);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_HISTORY_NAME))
@@ -917,8 +1423,12 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         answer = g_paste_daemon_private_get_history_size (priv, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_RAW_ELEMENT))
         answer = g_paste_daemon_private_get_raw_element (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_RAW_ELEMENT_FD))
+        answer = g_paste_daemon_private_get_raw_element_fd (priv, parameters, &fd_list, &error, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_RAW_HISTORY))
         answer = g_paste_daemon_private_get_raw_history (priv);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_GET_RAW_HISTORY_FD))
+        answer = g_paste_daemon_private_get_raw_history_fd (priv, &fd_list, &error);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_LIST_HISTORIES))
         answer = g_paste_daemon_list_histories (&error);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_MERGE))
@@ -931,8 +1441,21 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         g_paste_daemon_private_rename_password (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_REPLACE))
         g_paste_daemon_private_replace (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_REPLACE_FD))
+        g_paste_daemon_private_replace_fd (priv, parameters, invocation, &error, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SEARCH))
-        answer = g_paste_daemon_private_search (priv, parameters, &err);
+    {
+        g_paste_daemon_private_search (priv, parameters, invocation);
+        return;
+    }
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SEARCH_ALL_HISTORIES))
+        answer = g_paste_daemon_private_search_all_histories (priv, parameters, &error);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SEARCH_WITHIN))
+        answer = g_paste_daemon_private_search_within (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SEARCH_PREVIEWS))
+        answer = g_paste_daemon_private_search_previews (priv, parameters, &err);
+    else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SEARCH_WITH_OPTIONS))
+        answer = g_paste_daemon_private_search_with_options (priv, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SELECT))
         g_paste_daemon_select (self, parameters, &err);
     else if (g_paste_str_equal (method_name, G_PASTE_DAEMON_SET_PASSWORD))
@@ -950,6 +1473,8 @@ g_paste_daemon_dbus_method_call (GDBusConnection       *connection     G_GNUC_UN
         g_dbus_method_invocation_take_error (invocation, error);
     else if (err)
         g_dbus_method_invocation_return_dbus_error (invocation, err->name, err->msg);
+    else if (fd_list)
+        g_dbus_method_invocation_return_value_with_unix_fd_list (invocation, answer, fd_list);
     else
         g_dbus_method_invocation_return_value (invocation, answer);
 }
@@ -982,6 +1507,7 @@ g_paste_daemon_unregister_object (gpointer user_data)
 
     g_signal_handler_disconnect (priv->settings, c_signals[C_TRACK]);
     g_signal_handler_disconnect (priv->history,  c_signals[C_UPDATE]);
+    g_signal_handler_disconnect (priv->history,  c_signals[C_CHANGED]);
     g_signal_handler_disconnect (priv->history,  c_signals[C_SWITCH]);
 
     if (priv->screensaver)
@@ -1000,6 +1526,20 @@ g_paste_daemon_on_history_update (GPasteDaemon      *self,
     g_paste_daemon_update (self, action, target, position);
 }
 
+static void
+g_paste_daemon_on_history_changed (GPasteDaemon *self,
+                                   guint64       seq,
+                                   gpointer      user_data G_GNUC_UNUSED)
+{
+    const GPasteDaemonPrivate *priv = _g_paste_daemon_get_instance_private (self);
+
+    GVariant *data[] = {
+        g_variant_new_uint64 (seq),
+        g_paste_daemon_private_get_changes (priv, seq - 1)
+    };
+    G_PASTE_SEND_DBUS_SIGNAL_FULL (CHANGED, g_variant_new_tuple (data, 2), NULL);
+}
+
 static void
 g_paste_daemon_on_history_switch (GPasteDaemonPrivate *priv,
                                   const gchar         *name,
@@ -1055,6 +1595,7 @@ g_paste_daemon_dispose (GObject *object)
     {
         g_dbus_connection_unregister_object (priv->connection, priv->id_on_bus);
         g_clear_object (&priv->connection);
+        g_paste_history_flush (priv->history);
         g_clear_object (&priv->history);
         g_clear_object (&priv->settings);
         g_clear_object (&priv->clipboards_manager);
@@ -1097,6 +1638,10 @@ g_paste_daemon_register_on_connection (GPasteBusObject *self,
                                                     "update",
                                                     G_CALLBACK (g_paste_daemon_on_history_update),
                                                     self);
+    c_signals[C_CHANGED] = g_signal_connect_swapped (priv->history,
+                                                     "changed",
+                                                     G_CALLBACK (g_paste_daemon_on_history_changed),
+                                                     self);
     c_signals[C_SWITCH] = g_signal_connect_swapped (priv->history,
                                                     "switch",
                                                     G_CALLBACK (g_paste_daemon_on_history_switch),
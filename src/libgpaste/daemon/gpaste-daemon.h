@@ -12,6 +12,7 @@
 #define __G_PASTE_DAEMON_H__
 
 #include <gpaste-bus-object.h>
+#include <gpaste-history.h>
 
 G_BEGIN_DECLS
 
@@ -19,6 +20,8 @@ G_BEGIN_DECLS
 
 G_PASTE_FINAL_TYPE (Daemon, daemon, DAEMON, GPasteBusObject)
 
+GPasteHistory *g_paste_daemon_get_history (GPasteDaemon *self);
+void g_paste_daemon_reexecute    (GPasteDaemon *self);
 void g_paste_daemon_show_history (GPasteDaemon *self,
                                   GError      **error);
 gboolean g_paste_daemon_upload   (GPasteDaemon *self,
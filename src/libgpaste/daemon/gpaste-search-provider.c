@@ -5,6 +5,7 @@
  */
 
 #include <gpaste-gdbus-defines.h>
+#include <gpaste-replacer.h>
 #include <gpaste-search-provider.h>
 #include <gpaste-util.h>
 
@@ -21,7 +22,20 @@ typedef struct
     guint64              id_on_bus;
     gboolean             registered;
 
+    /* When living in the daemon, we use its history directly */
+    GPasteHistory       *history;
+    /* Otherwise, we go through the bus */
     GPasteClient        *client;
+    guint64              update_signal;
+    GPasteReplacer      *oneline;
+
+    /* The last search and its results, to narrow them down on subsearches */
+    gchar               *last_search;
+    GStrv                last_results;
+    /* uuid -> preview, for the results we got from the daemon, to answer GetResultMetas */
+    GHashTable          *previews;
+    /* Bumped on each update, to detect results that got stale while searching */
+    guint64              generation;
 
     GDBusNodeInfo       *g_paste_search_provider_dbus_info;
     GDBusInterfaceVTable g_paste_search_provider_dbus_vtable;
@@ -53,69 +67,199 @@ _g_paste_dbus_get_as_result (GVariant *parameters)
 /* DBus Mathods */
 /****************/
 
+typedef struct
+{
+    GPasteSearchProvider  *self;
+    GDBusMethodInvocation *invocation;
+    gchar                 *search;
+    gboolean               within;
+    guint64                generation;
+} SearchData;
+
+static void
+g_paste_search_provider_private_forget_last_search (GPasteSearchProviderPrivate *priv)
+{
+    g_clear_pointer (&priv->last_search, g_free);
+    g_clear_pointer (&priv->last_results, g_strfreev);
+}
+
+/* Takes ownership of results */
+static void
+g_paste_search_provider_private_return_results (GPasteSearchProviderPrivate *priv,
+                                                GDBusMethodInvocation       *invocation,
+                                                const gchar                 *search,
+                                                GStrv                        results)
+{
+    g_paste_search_provider_private_forget_last_search (priv);
+    if (results)
+    {
+        priv->last_search = g_strdup (search);
+        priv->last_results = results;
+    }
+
+    GVariant *ans = g_variant_new_strv ((const gchar * const *) results, (results) ? -1 : 0);
+    g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&ans, 1));
+}
+
 static void
 on_search_ready (GObject      *source_object G_GNUC_UNUSED,
                  GAsyncResult *res,
                  gpointer      user_data)
 {
-    g_autofree gpointer *data = (gpointer *) user_data;
-    GPasteClient *client = data[0];
-    GDBusMethodInvocation *invocation = data[1];
-    g_auto (GStrv) results = g_paste_client_search_finish (client, res, NULL /* Error */);
+    g_autofree SearchData *data = user_data;
+    g_autoptr (GPasteSearchProvider) self = data->self;
+    GPasteSearchProviderPrivate *priv = g_paste_search_provider_get_instance_private (self);
+    g_autofree gchar *search = data->search;
+    GStrv results = NULL;
 
-    GVariant *ans = g_variant_new_strv ((const char * const *) results, -1);
-    g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&ans, 1));
+    if (priv->history)
+    {
+        results = g_paste_history_search_finish (priv->history, res, NULL /* Error */);
+    }
+    else if (priv->client && data->within)
+    {
+        /* We already have the previews of a superset of these */
+        results = g_paste_client_search_within_finish (priv->client, res, NULL /* Error */);
+    }
+    else if (priv->client)
+    {
+        g_autoptr (GError) error = NULL;
+        GList *previews = g_paste_client_search_previews_finish (priv->client, res, &error);
+
+        g_hash_table_remove_all (priv->previews);
+
+        if (!error)
+        {
+            g_autoptr (GArray) uuids = g_array_new (TRUE, /* zero-terminated */
+                                                    TRUE, /* clear */
+                                                    sizeof (gchar *));
+
+            for (const GList *p = previews; p; p = g_list_next (p))
+            {
+                gchar *uuid = g_strdup (g_paste_client_item_get_uuid (p->data));
+
+                g_array_append_val (uuids, uuid);
+                g_hash_table_replace (priv->previews, g_strdup (uuid), g_strdup (g_paste_client_item_get_value (p->data)));
+            }
+
+            results = g_array_steal (uuids, NULL);
+        }
+
+        g_list_free_full (previews, g_object_unref);
+    }
+
+    g_paste_search_provider_private_return_results (priv, data->invocation, search, results);
+
+    if (data->generation != priv->generation)
+        g_paste_search_provider_private_forget_last_search (priv);
+}
+
+/* Whether search is a literal, which would be a regex otherwise */
+static gboolean
+is_literal (const gchar *search)
+{
+    return !strpbrk (search, "\\^$.|?*+()[]{}");
 }
 
+/* A literal containing another one can only match a subset of its results, besides what it designates exactly, which search_within handles */
 static gboolean
-_do_search (const GPasteSearchProviderPrivate *priv,
-            gchar                             *search,
-            GDBusMethodInvocation             *invocation)
+g_paste_search_provider_private_can_narrow (const GPasteSearchProviderPrivate *priv,
+                                            const gchar                       *search,
+                                            const gchar * const               *old_results)
 {
-    if (strlen (search) < 3 || !priv->client)
+    return priv->last_search && is_literal (priv->last_search) && is_literal (search) &&
+           strstr (search, priv->last_search) &&
+           g_strv_equal ((const gchar * const *) priv->last_results, old_results);
+}
+
+static gboolean
+_do_search (GPasteSearchProvider  *self,
+            gchar                 *search,
+            const gchar * const   *old_results,
+            GDBusMethodInvocation *invocation)
+{
+    GPasteSearchProviderPrivate *priv = g_paste_search_provider_get_instance_private (self);
+
+    if (strlen (search) < 3 || !(priv->history || priv->client))
     {
         GVariant *ans = g_variant_new_strv (NULL, 0);
         g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&ans, 1));
     }
-    else
+    else if (priv->history && old_results && g_paste_search_provider_private_can_narrow (priv, search, old_results))
     {
-        gpointer *data = g_new (gpointer, 2);
+        g_paste_search_provider_private_return_results (priv, invocation, search, g_paste_history_search_within (priv->history, search, old_results));
+    }
+    else if (priv->history)
+    {
+        /* Don't block the daemon while scanning the whole history */
+        SearchData *data = g_new (SearchData, 1);
 
-        data[0] = priv->client;
-        data[1] = invocation;
+        data->self = g_object_ref (self);
+        data->invocation = invocation;
+        data->search = g_strdup (search);
+        data->generation = priv->generation;
+        data->within = FALSE;
 
-        g_paste_client_search (priv->client,
-                               search,
-                               on_search_ready,
-                               data);
+        g_paste_history_search_async (priv->history, search, NULL /* cancellable */, on_search_ready, data);
+    }
+    else
+    {
+        SearchData *data = g_new (SearchData, 1);
+
+        data->self = g_object_ref (self);
+        data->invocation = invocation;
+        data->search = g_strdup (search);
+        data->generation = priv->generation;
+        data->within = (old_results && g_paste_search_provider_private_can_narrow (priv, search, old_results));
+
+        if (data->within)
+        {
+            g_paste_client_search_within (priv->client,
+                                          search,
+                                          (const gchar **) old_results,
+                                          g_strv_length ((GStrv) old_results),
+                                          on_search_ready,
+                                          data);
+        }
+        else
+        {
+            g_paste_client_search_previews (priv->client,
+                                            search,
+                                            G_PASTE_SEARCH_MODE_REGEX,
+                                            0, /* offset */
+                                            0, /* limit */
+                                            on_search_ready,
+                                            data);
+        }
     }
 
     return TRUE;
 }
 
 static gboolean
-g_paste_search_provider_private_get_initial_result_set (const GPasteSearchProviderPrivate *priv,
-                                                        GDBusMethodInvocation             *invocation,
-                                                        GVariant                          *parameters)
+g_paste_search_provider_get_initial_result_set (GPasteSearchProvider  *self,
+                                                GDBusMethodInvocation *invocation,
+                                                GVariant              *parameters)
 {
     g_autofree gchar *search = _g_paste_dbus_get_as_result (parameters);
-    return _do_search (priv, search, invocation);
+    return _do_search (self, search, NULL, invocation);
 }
 
 static gboolean
-g_paste_search_provider_private_get_subsearch_result_set (const GPasteSearchProviderPrivate *priv,
-                                                          GDBusMethodInvocation             *invocation,
-                                                          GVariant                          *parameters)
+g_paste_search_provider_get_subsearch_result_set (GPasteSearchProvider  *self,
+                                                  GDBusMethodInvocation *invocation,
+                                                  GVariant              *parameters)
 {
     GVariantIter parameters_iter;
 
     g_variant_iter_init (&parameters_iter, parameters);
 
-    G_GNUC_UNUSED g_autoptr (GVariant) old_results = g_variant_iter_next_value (&parameters_iter);
+    g_autoptr (GVariant) old_results = g_variant_iter_next_value (&parameters_iter);
     g_autoptr (GVariant) variant = g_variant_iter_next_value (&parameters_iter);
     g_autofree gchar *search = g_paste_dbus_get_as_result (variant);
+    g_autofree const gchar **old_uuids = g_variant_get_strv (old_results, NULL);
 
-    return _do_search (priv, search, invocation);
+    return _do_search (self, search, old_uuids, invocation);
 }
 
 static void
@@ -127,9 +271,29 @@ append_dict_entry (GVariantBuilder *dict,
                                                                  g_variant_new_variant (g_variant_new_string (value))));
 }
 
+/* No clipboardText: values can be huge and activating a result selects it by uuid anyway */
+static void
+append_result_meta (GVariantBuilder      *builder,
+                    const GPasteReplacer *oneline,
+                    const gchar          *uuid,
+                    const gchar          *preview)
+{
+    g_auto (GVariantBuilder) dict;
+    g_autofree gchar *result = g_paste_replacer_replace (oneline, preview);
+
+    g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
+
+    append_dict_entry (&dict, "id", uuid);
+    append_dict_entry (&dict, "name", result);
+    append_dict_entry (&dict, "gicon", G_PASTE_ICON_NAME);
+
+    g_variant_builder_add_value (builder, g_variant_builder_end (&dict));
+}
+
 typedef struct
 {
     GPasteClient          *client;
+    GPasteReplacer        *oneline;
     GDBusMethodInvocation *invocation;
     const gchar          **uuids;
 } GetResultMetasData;
@@ -150,26 +314,13 @@ on_elements_ready (GObject      *source_object G_GNUC_UNUSED,
     guint64 n = 0;
 
     for (const GList *i = results; i; i = i->next, ++n)
-    {
-        const GPasteClientItem *item = i->data;
-        const gchar *value = g_paste_client_item_get_value (item);
-        g_auto (GVariantBuilder) dict;
-        g_autofree gchar *result = g_paste_util_replace (value, "\n", " ");
-
-        g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
-
-        append_dict_entry (&dict, "id", uuids[n]);
-        append_dict_entry (&dict, "name", result);
-        append_dict_entry (&dict, "gicon", G_PASTE_ICON_NAME);
-        append_dict_entry (&dict, "clipboardText", value);
-
-        g_variant_builder_add_value (&builder, g_variant_builder_end (&dict));
-    }
+        append_result_meta (&builder, data->oneline, uuids[n], g_paste_client_item_get_value (i->data)); /* GetElements gives us previews */
 
     GVariant *ans = g_variant_builder_end (&builder);
     g_dbus_method_invocation_return_value (data->invocation, g_variant_new_tuple (&ans, 1));
 
     g_list_free_full (results, g_object_unref);
+    g_object_unref (data->oneline);
 }
 
 static gboolean
@@ -188,9 +339,50 @@ g_paste_search_provider_private_get_result_metas (const GPasteSearchProviderPriv
     if (!len)
         return FALSE;
 
+    if (priv->history)
+    {
+        g_auto (GVariantBuilder) builder;
+
+        g_variant_builder_init (&builder, (GVariantType *) "aa{sv}");
+
+        for (guint64 i = 0; i < len; ++i)
+        {
+            const GPasteItem *item = g_paste_history_get_by_uuid (priv->history, uuids[i]);
+
+            if (item)
+                append_result_meta (&builder, priv->oneline, uuids[i], g_paste_item_get_preview (item));
+        }
+
+        GVariant *ans = g_variant_builder_end (&builder);
+        g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&ans, 1));
+
+        return TRUE;
+    }
+
+    gboolean have_previews = TRUE;
+
+    for (guint64 i = 0; have_previews && i < len; ++i)
+        have_previews = g_hash_table_contains (priv->previews, uuids[i]);
+
+    if (have_previews)
+    {
+        g_auto (GVariantBuilder) builder;
+
+        g_variant_builder_init (&builder, (GVariantType *) "aa{sv}");
+
+        for (guint64 i = 0; i < len; ++i)
+            append_result_meta (&builder, priv->oneline, uuids[i], g_hash_table_lookup (priv->previews, uuids[i]));
+
+        GVariant *ans = g_variant_builder_end (&builder);
+        g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&ans, 1));
+
+        return TRUE;
+    }
+
     GetResultMetasData *data = g_new (GetResultMetasData, 1);
 
     data->client = priv->client;
+    data->oneline = g_object_ref (priv->oneline);
     data->invocation = invocation;
     data->uuids = uuids;
     uuids = NULL; // don't autofree
@@ -212,7 +404,10 @@ g_paste_search_provider_private_activate_result (const GPasteSearchProviderPriva
     G_GNUC_UNUSED g_autoptr (GVariant) terms = g_variant_iter_next_value (&parameters_iter);
     G_GNUC_UNUSED g_autoptr (GVariant) timestamp = g_variant_iter_next_value (&parameters_iter);
 
-    g_paste_client_select (priv->client, g_variant_get_string (indexv, NULL), NULL, NULL);
+    if (priv->history)
+        g_paste_history_select (priv->history, g_variant_get_string (indexv, NULL));
+    else if (priv->client)
+        g_paste_client_select (priv->client, g_variant_get_string (indexv, NULL), NULL, NULL);
 
     return FALSE;
 }
@@ -249,9 +444,9 @@ g_paste_search_provider_dbus_method_call (GDBusConnection       *connection
     gboolean async = FALSE;
 
     if (g_paste_str_equal (method_name, G_PASTE_SEARCH_PROVIDER_GET_INITIAL_RESULT_SET))
-        async = g_paste_search_provider_private_get_initial_result_set (priv, invocation, parameters);
+        async = g_paste_search_provider_get_initial_result_set (self, invocation, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_SEARCH_PROVIDER_GET_SUBSEARCH_RESULT_SET))
-        async = g_paste_search_provider_private_get_subsearch_result_set (priv, invocation, parameters);
+        async = g_paste_search_provider_get_subsearch_result_set (self, invocation, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_SEARCH_PROVIDER_GET_RESULT_METAS))
         async = g_paste_search_provider_private_get_result_metas (priv, invocation, parameters);
     else if (g_paste_str_equal (method_name, G_PASTE_SEARCH_PROVIDER_ACTIVATE_RESULT))
@@ -282,9 +477,24 @@ g_paste_search_provider_dispose (GObject *object)
         g_dbus_connection_unregister_object (priv->connection, priv->id_on_bus);
         g_clear_object (&priv->connection);
         g_dbus_node_info_unref (priv->g_paste_search_provider_dbus_info);
+    }
+
+    if (priv->history)
+    {
+        g_signal_handler_disconnect (priv->history, priv->update_signal);
+        g_clear_object (&priv->history);
+    }
+
+    if (priv->client)
+    {
+        g_signal_handler_disconnect (priv->client, priv->update_signal);
         g_clear_object (&priv->client);
     }
 
+    g_clear_object (&priv->oneline);
+    g_paste_search_provider_private_forget_last_search (priv);
+    g_clear_pointer (&priv->previews, g_hash_table_unref);
+
     G_OBJECT_CLASS (g_paste_search_provider_parent_class)->dispose (object);
 }
 
@@ -316,6 +526,21 @@ g_paste_search_provider_class_init (GPasteSearchProviderClass *klass)
     G_PASTE_BUS_OBJECT_CLASS (klass)->register_on_connection = g_paste_search_provider_register_on_connection;
 }
 
+static void
+on_update (gpointer           emitter G_GNUC_UNUSED,
+           GPasteUpdateAction action G_GNUC_UNUSED,
+           GPasteUpdateTarget target G_GNUC_UNUSED,
+           guint64            position G_GNUC_UNUSED,
+           gpointer           user_data)
+{
+    GPasteSearchProviderPrivate *priv = user_data;
+
+    /* New or changed items could match, don't narrow down stale results */
+    g_paste_search_provider_private_forget_last_search (priv);
+    g_hash_table_remove_all (priv->previews);
+    ++priv->generation;
+}
+
 static void
 on_client_ready (GObject      *source_object G_GNUC_UNUSED,
                  GAsyncResult *res,
@@ -325,6 +550,14 @@ on_client_ready (GObject      *source_object G_GNUC_UNUSED,
 
     priv->client = g_paste_client_new_finish (res,
                                               NULL); /* Error */
+
+    if (priv->client)
+    {
+        priv->update_signal = g_signal_connect (priv->client,
+                                                "update",
+                                                G_CALLBACK (on_update),
+                                                priv);
+    }
 }
 
 static void
@@ -334,20 +567,22 @@ g_paste_search_provider_init (GPasteSearchProvider *self)
     GDBusInterfaceVTable *vtable = &priv->g_paste_search_provider_dbus_vtable;
 
     priv->id_on_bus = 0;
+    priv->oneline = g_paste_replacer_new ();
+    g_paste_replacer_add (priv->oneline, "\n", " ");
+    priv->previews = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
     priv->g_paste_search_provider_dbus_info = g_dbus_node_info_new_for_xml (G_PASTE_SEARCH_PROVIDER_INTERFACE,
                                                                             NULL); /* Error */
 
     vtable->method_call = g_paste_search_provider_dbus_method_call;
     vtable->get_property = NULL;
     vtable->set_property = NULL;
-
-    g_paste_client_new (on_client_ready, priv);
 }
 
 /**
  * g_paste_search_provider_new:
  *
  * Create a new instance of #GPasteSearchProvider
+ * talking to the #GPasteDaemon through the bus
  *
  * Returns: a newly allocated #GPasteSearchProvider
  *          free it with g_object_unref
@@ -355,5 +590,37 @@ g_paste_search_provider_init (GPasteSearchProvider *self)
 G_PASTE_VISIBLE GPasteBusObject *
 g_paste_search_provider_new (void)
 {
-    return G_PASTE_BUS_OBJECT (g_object_new (G_PASTE_TYPE_SEARCH_PROVIDER, NULL));
+    GPasteBusObject *self = G_PASTE_BUS_OBJECT (g_object_new (G_PASTE_TYPE_SEARCH_PROVIDER, NULL));
+    GPasteSearchProviderPrivate *priv = g_paste_search_provider_get_instance_private (G_PASTE_SEARCH_PROVIDER (self));
+
+    g_paste_client_new (on_client_ready, priv);
+
+    return self;
+}
+
+/**
+ * g_paste_search_provider_new_for_history:
+ * @history: (transfer none): the #GPasteHistory of the #GPasteDaemon we live in
+ *
+ * Create a new instance of #GPasteSearchProvider using
+ * @history directly, without any round trip through the bus
+ *
+ * Returns: a newly allocated #GPasteSearchProvider
+ *          free it with g_object_unref
+ */
+G_PASTE_VISIBLE GPasteBusObject *
+g_paste_search_provider_new_for_history (GPasteHistory *history)
+{
+    g_return_val_if_fail (_G_PASTE_IS_HISTORY (history), NULL);
+
+    GPasteBusObject *self = G_PASTE_BUS_OBJECT (g_object_new (G_PASTE_TYPE_SEARCH_PROVIDER, NULL));
+    GPasteSearchProviderPrivate *priv = g_paste_search_provider_get_instance_private (G_PASTE_SEARCH_PROVIDER (self));
+
+    priv->history = g_object_ref (history);
+    priv->update_signal = g_signal_connect (history,
+                                            "update",
+                                            G_CALLBACK (on_update),
+                                            priv);
+
+    return self;
 }
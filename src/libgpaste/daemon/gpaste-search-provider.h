@@ -12,6 +12,7 @@
 #define __G_PASTE_SEARCH_PROVIDER_H__
 
 #include <gpaste-bus-object.h>
+#include <gpaste-history.h>
 
 G_BEGIN_DECLS
 
@@ -19,7 +20,8 @@ G_BEGIN_DECLS
 
 G_PASTE_FINAL_TYPE (SearchProvider, search_provider, SEARCH_PROVIDER, GPasteBusObject)
 
-GPasteBusObject *g_paste_search_provider_new (void);
+GPasteBusObject *g_paste_search_provider_new             (void);
+GPasteBusObject *g_paste_search_provider_new_for_history (GPasteHistory *history);
 
 G_END_DECLS
 
@@ -22,29 +22,41 @@ G_BEGIN_DECLS
 
 #define G_PASTE_DAEMON_ABOUT                      "About"
 #define G_PASTE_DAEMON_ADD                        "Add"
+#define G_PASTE_DAEMON_ADD_FD                     "AddFd"
 #define G_PASTE_DAEMON_ADD_FILE                   "AddFile"
+#define G_PASTE_DAEMON_ADD_MANY                   "AddMany"
 #define G_PASTE_DAEMON_ADD_PASSWORD               "AddPassword"
 #define G_PASTE_DAEMON_BACKUP_HISTORY             "BackupHistory"
 #define G_PASTE_DAEMON_DELETE                     "Delete"
 #define G_PASTE_DAEMON_DELETE_HISTORY             "DeleteHistory"
+#define G_PASTE_DAEMON_DELETE_MANY                "DeleteMany"
 #define G_PASTE_DAEMON_DELETE_PASSWORD            "DeletePassword"
 #define G_PASTE_DAEMON_EMPTY_HISTORY              "EmptyHistory"
+#define G_PASTE_DAEMON_GET_CHANGES_SINCE          "GetChangesSince"
 #define G_PASTE_DAEMON_GET_ELEMENT                "GetElement"
 #define G_PASTE_DAEMON_GET_ELEMENT_AT_INDEX       "GetElementAtIndex"
 #define G_PASTE_DAEMON_GET_ELEMENT_KIND           "GetElementKind"
 #define G_PASTE_DAEMON_GET_ELEMENTS               "GetElements"
+#define G_PASTE_DAEMON_GET_ELEMENTS_RANGE         "GetElementsRange"
 #define G_PASTE_DAEMON_GET_HISTORY                "GetHistory"
 #define G_PASTE_DAEMON_GET_HISTORY_NAME           "GetHistoryName"
 #define G_PASTE_DAEMON_GET_HISTORY_SIZE           "GetHistorySize"
 #define G_PASTE_DAEMON_GET_RAW_ELEMENT            "GetRawElement"
+#define G_PASTE_DAEMON_GET_RAW_ELEMENT_FD         "GetRawElementFd"
 #define G_PASTE_DAEMON_GET_RAW_HISTORY            "GetRawHistory"
+#define G_PASTE_DAEMON_GET_RAW_HISTORY_FD         "GetRawHistoryFd"
 #define G_PASTE_DAEMON_LIST_HISTORIES             "ListHistories"
 #define G_PASTE_DAEMON_MERGE                      "Merge"
 #define G_PASTE_DAEMON_ON_EXTENSION_STATE_CHANGED "OnExtensionStateChanged"
 #define G_PASTE_DAEMON_REEXECUTE                  "Reexecute"
 #define G_PASTE_DAEMON_RENAME_PASSWORD            "RenamePassword"
 #define G_PASTE_DAEMON_REPLACE                    "Replace"
+#define G_PASTE_DAEMON_REPLACE_FD                 "ReplaceFd"
 #define G_PASTE_DAEMON_SEARCH                     "Search"
+#define G_PASTE_DAEMON_SEARCH_ALL_HISTORIES       "SearchAllHistories"
+#define G_PASTE_DAEMON_SEARCH_PREVIEWS            "SearchPreviews"
+#define G_PASTE_DAEMON_SEARCH_WITH_OPTIONS        "SearchWithOptions"
+#define G_PASTE_DAEMON_SEARCH_WITHIN              "SearchWithin"
 #define G_PASTE_DAEMON_SELECT                     "Select"
 #define G_PASTE_DAEMON_SET_PASSWORD               "SetPassword"
 #define G_PASTE_DAEMON_SHOW_HISTORY               "ShowHistory"
@@ -52,6 +64,7 @@ G_BEGIN_DECLS
 #define G_PASTE_DAEMON_TRACK                      "Track"
 #define G_PASTE_DAEMON_UPLOAD                     "Upload"
 
+#define G_PASTE_DAEMON_SIG_CHANGED        "Changed"
 #define G_PASTE_DAEMON_SIG_DELETE_HISTORY "DeleteHistory"
 #define G_PASTE_DAEMON_SIG_EMPTY_HISTORY  "EmptyHistory"
 #define G_PASTE_DAEMON_SIG_SHOW_HISTORY   "ShowHistory"
@@ -68,9 +81,15 @@ G_BEGIN_DECLS
         "  <method name='" G_PASTE_DAEMON_ADD "'>"                        \
         "   <arg type='s' direction='in' name='text' />"                  \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_ADD_FD "'>"                     \
+        "   <arg type='h' direction='in' name='fd' />"                    \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_ADD_FILE "'>"                   \
         "   <arg type='s' direction='in' name='file' />"                  \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_ADD_MANY "'>"                   \
+        "   <arg type='as' direction='in' name='texts' />"                \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_ADD_PASSWORD "'>"               \
         "   <arg type='s' direction='in' name='name'     />"              \
         "   <arg type='s' direction='in' name='password' />"              \
@@ -85,12 +104,20 @@ G_BEGIN_DECLS
         "  <method name='" G_PASTE_DAEMON_DELETE_HISTORY "'>"             \
         "   <arg type='s' direction='in' name='name' />"                  \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_DELETE_MANY "'>"                \
+        "   <arg type='as' direction='in' name='uuids' />"                \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_DELETE_PASSWORD "'>"            \
         "   <arg type='s' direction='in' name='name' />"                  \
         "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_EMPTY_HISTORY "'>"              \
         "   <arg type='s' direction='in' name='name' />"                  \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_GET_CHANGES_SINCE "'>"          \
+        "   <arg type='t'         direction='in'  name='seq'     />"      \
+        "   <arg type='t'         direction='out' name='seq'     />"      \
+        "   <arg type='a(sttsss)' direction='out' name='changes' />"      \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_GET_ELEMENT "'>"                \
         "   <arg type='s' direction='in' name='uuid'   />"                \
         "   <arg type='s' direction='out' name='value' />"                \
@@ -108,6 +135,11 @@ G_BEGIN_DECLS
         "   <arg type='as' direction='in'  name='uuids' />"               \
         "   <arg type='a(ss)' direction='out' name='elements' />"         \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_GET_ELEMENTS_RANGE "'>"         \
+        "   <arg type='t'      direction='in'  name='offset'   />"        \
+        "   <arg type='t'      direction='in'  name='count'    />"        \
+        "   <arg type='a(sss)' direction='out' name='elements' />"        \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_GET_HISTORY "'>"                \
         "   <arg type='a(ss)' direction='out' name='history' />"          \
         "  </method>"                                                     \
@@ -122,9 +154,16 @@ G_BEGIN_DECLS
         "   <arg type='s' direction='in' name='uuid'   />"                \
         "   <arg type='s' direction='out' name='value' />"                \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_GET_RAW_ELEMENT_FD "'>"         \
+        "   <arg type='s' direction='in'  name='uuid' />"                 \
+        "   <arg type='h' direction='out' name='fd'   />"                 \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_GET_RAW_HISTORY "'>"            \
         "   <arg type='a(ss)' direction='out' name='history' />"          \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_GET_RAW_HISTORY_FD "'>"         \
+        "   <arg type='h' direction='out' name='fd' />"                   \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_LIST_HISTORIES "'>"             \
         "   <arg type='as' direction='out' name='histories' />"           \
         "  </method>"                                                     \
@@ -145,10 +184,37 @@ G_BEGIN_DECLS
         "   <arg type='s' direction='in' name='uuid' />"                  \
         "   <arg type='s' direction='in' name='contents' />"              \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_REPLACE_FD "'>"                 \
+        "   <arg type='s' direction='in' name='uuid' />"                  \
+        "   <arg type='h' direction='in' name='fd'   />"                  \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_SEARCH "'>"                     \
         "   <arg type='s'  direction='in'  name='query'   />"             \
         "   <arg type='as' direction='out' name='results' />"             \
         "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_SEARCH_ALL_HISTORIES "'>"       \
+        "   <arg type='s'     direction='in'  name='query'   />"          \
+        "   <arg type='a(ss)' direction='out' name='results' />"          \
+        "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_SEARCH_PREVIEWS "'>"            \
+        "   <arg type='s'      direction='in'  name='query'   />"         \
+        "   <arg type='s'      direction='in'  name='mode'    />"         \
+        "   <arg type='t'      direction='in'  name='offset'  />"         \
+        "   <arg type='t'      direction='in'  name='limit'   />"         \
+        "   <arg type='a(sss)' direction='out' name='results' />"         \
+        "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_SEARCH_WITH_OPTIONS "'>"        \
+        "   <arg type='s'  direction='in'  name='query'   />"             \
+        "   <arg type='s'  direction='in'  name='mode'    />"             \
+        "   <arg type='t'  direction='in'  name='offset'  />"             \
+        "   <arg type='t'  direction='in'  name='limit'   />"             \
+        "   <arg type='as' direction='out' name='results' />"             \
+        "  </method>"                                                     \
+        "  <method name='" G_PASTE_DAEMON_SEARCH_WITHIN "'>"              \
+        "   <arg type='s'  direction='in'  name='query'   />"             \
+        "   <arg type='as' direction='in'  name='uuids'   />"             \
+        "   <arg type='as' direction='out' name='results' />"             \
+        "  </method>"                                                     \
         "  <method name='" G_PASTE_DAEMON_SELECT "'>"                     \
         "   <arg type='s' direction='in' name='uuid' />"                  \
         "  </method>"                                                     \
@@ -166,6 +232,10 @@ G_BEGIN_DECLS
         "  <method name='" G_PASTE_DAEMON_UPLOAD "'>"                     \
         "   <arg type='s' direction='in' name='uuid' />"                  \
         "  </method>"                                                     \
+        "  <signal name='" G_PASTE_DAEMON_SIG_CHANGED "'>"                \
+        "   <arg type='t'         direction='out' name='seq'     />"      \
+        "   <arg type='a(sttsss)' direction='out' name='changes' />"      \
+        "  </signal>"                                                     \
         "  <signal name='" G_PASTE_DAEMON_SIG_DELETE_HISTORY "'>"         \
         "   <arg type='s' direction='out' name='history' />"              \
         "  </signal>"                                                     \
@@ -113,6 +113,9 @@ G_BEGIN_DECLS
 #define DBUS_CALL_THREE_PARAMS_ASYNC_BASE(TYPE_CHECKER, params, method) \
     DBUS_CALL_ASYNC_FULL (TYPE_CHECKER, {}, method, params, 3)
 
+#define DBUS_CALL_FOUR_PARAMS_ASYNC_BASE(TYPE_CHECKER, params, method) \
+    DBUS_CALL_ASYNC_FULL (TYPE_CHECKER, {}, method, params, 4)
+
 /**************************************/
 /* Methods / Async / General - Finish */
 /**************************************/
@@ -165,6 +168,15 @@ G_BEGIN_DECLS
 #define DBUS_ASYNC_FINISH_RET_ITEMS_BASE(TYPE_CHECKER) \
     DBUS_ASYNC_FINISH_WITH_RETURN (TYPE_CHECKER, NULL, return g_paste_util_get_dbus_items_result (variant))
 
+#define DBUS_ASYNC_FINISH_RET_HISTORY_MATCHES_BASE(TYPE_CHECKER) \
+    DBUS_ASYNC_FINISH_WITH_RETURN (TYPE_CHECKER, NULL, return g_paste_util_get_dbus_history_matches_result (variant))
+
+#define DBUS_ASYNC_FINISH_RET_PREVIEWS_BASE(TYPE_CHECKER) \
+    DBUS_ASYNC_FINISH_WITH_RETURN (TYPE_CHECKER, NULL, return g_paste_util_get_dbus_previews_result (variant))
+
+#define DBUS_ASYNC_FINISH_RET_CHANGES_BASE(TYPE_CHECKER, seq) \
+    DBUS_ASYNC_FINISH_WITH_RETURN_FULL (TYPE_CHECKER, NULL, FALSE, return g_paste_util_get_dbus_changes_result (variant, seq))
+
 #define DBUS_ASYNC_FINISH_RET_AU_BASE(TYPE_CHECKER, len) \
     DBUS_ASYNC_FINISH_WITH_RETURN (TYPE_CHECKER, NULL, return g_paste_util_get_dbus_au_result (variant, len))
 
@@ -279,9 +291,15 @@ G_BEGIN_DECLS
 #define DBUS_CALL_ONE_PARAM_RET_STRV_BASE(TYPE_CHECKER, param_type, param_name, method) \
     DBUS_CALL_ONE_PARAM_BASE (TYPE_CHECKER, param_type, param_name, method, NULL, return g_variant_dup_strv (variant, NULL))
 
+#define DBUS_CALL_ONE_PARAM_RET_HISTORY_MATCHES_BASE(TYPE_CHECKER, param_type, param_name, method) \
+    DBUS_CALL_ONE_PARAM_BASE (TYPE_CHECKER, param_type, param_name, method, NULL, return g_paste_util_get_dbus_history_matches_result (variant))
+
 #define DBUS_CALL_ONE_PARAM_RET_ITEM_BASE(TYPE_CHECKER, param_type, param_name, method) \
     DBUS_CALL_ONE_PARAM_BASE_FULL (TYPE_CHECKER, param_type, param_name, method, NULL, FALSE, return g_paste_util_get_dbus_item_result (variant))
 
+#define DBUS_CALL_ONE_PARAM_RET_CHANGES_BASE(TYPE_CHECKER, param_type, param_name, method, seq) \
+    DBUS_CALL_ONE_PARAM_BASE_FULL (TYPE_CHECKER, param_type, param_name, method, NULL, FALSE, return g_paste_util_get_dbus_changes_result (variant, seq))
+
 /****************************************************/
 /* Methods / Sync / Impl - With return - Two params */
 /****************************************************/
@@ -292,12 +310,27 @@ G_BEGIN_DECLS
 #define DBUS_CALL_TWO_PARAMS_RET_UINT64_BASE(TYPE_CHECKER, params, method) \
     DBUS_CALL_TWO_PARAMS_BASE(TYPE_CHECKER, params, method, 0, return g_variant_get_uint64 (variant))
 
+#define DBUS_CALL_TWO_PARAMS_RET_STRV_BASE(TYPE_CHECKER, params, method) \
+    DBUS_CALL_TWO_PARAMS_BASE(TYPE_CHECKER, params, method, NULL, return g_variant_dup_strv (variant, NULL))
+
+#define DBUS_CALL_TWO_PARAMS_RET_PREVIEWS_BASE(TYPE_CHECKER, params, method) \
+    DBUS_CALL_TWO_PARAMS_BASE(TYPE_CHECKER, params, method, NULL, return g_paste_util_get_dbus_previews_result (variant))
+
 #define DBUS_CALL_THREE_PARAMS_BASE(TYPE_CHECKER, params, method, if_fail, variant_extract) \
     DBUS_CALL_WITH_RETURN_BASE (TYPE_CHECKER, {}, method, params, 3, if_fail, variant_extract)
 
 #define DBUS_CALL_THREE_PARAMS_RET_UINT32_BASE(TYPE_CHECKER, params, method) \
     DBUS_CALL_THREE_PARAMS_BASE(TYPE_CHECKER, params, method, 0, return g_variant_get_uint32 (variant))
 
+#define DBUS_CALL_FOUR_PARAMS_BASE(TYPE_CHECKER, params, method, if_fail, variant_extract) \
+    DBUS_CALL_WITH_RETURN_BASE (TYPE_CHECKER, {}, method, params, 4, if_fail, variant_extract)
+
+#define DBUS_CALL_FOUR_PARAMS_RET_STRV_BASE(TYPE_CHECKER, params, method) \
+    DBUS_CALL_FOUR_PARAMS_BASE(TYPE_CHECKER, params, method, NULL, return g_variant_dup_strv (variant, NULL))
+
+#define DBUS_CALL_FOUR_PARAMS_RET_PREVIEWS_BASE(TYPE_CHECKER, params, method) \
+    DBUS_CALL_FOUR_PARAMS_BASE(TYPE_CHECKER, params, method, NULL, return g_paste_util_get_dbus_previews_result (variant))
+
 /************************/
 /* Properties / Getters */
 /************************/
@@ -26,8 +26,14 @@
 /* GPasteIO */
 #include <gpaste-storage-backend.h>
 #include <gpaste-file-backend.h>
+#include <gpaste-binary-backend.h>
+#include <gpaste-journal-backend.h>
+#include <gpaste-history-catalog.h>
+#include <gpaste-history-index.h>
 
 /* GPasteUtil */
+#include <gpaste-replacer.h>
+#include <gpaste-search-index.h>
 #include <gpaste-util.h>
 
 /* GPasteKeybinder */
@@ -0,0 +1,533 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-binary-backend.h>
+#include <gpaste-image-item.h>
+#include <gpaste-password-item.h>
+#include <gpaste-uris-item.h>
+#include <gpaste-util.h>
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/*
+ * The history is stored in "<name>.bin", laid out so that it can be used
+ * in place once mapped in memory, without any parsing nor decoding:
+ *
+ *   header | entries (one per item) | special values | strings
+ *
+ * Every integer is little endian. Entries and special values have a fixed
+ * size and reference their strings by offset and length. Strings are stored
+ * NUL-terminated so that they can be handed as is to the item constructors.
+ *
+ * The first time a history is read, the XML one written by GPasteFileBackend
+ * is converted, and kept as "<name>.xml.bak".
+ */
+
+#define G_PASTE_BINARY_MAGIC   "GPasteB\n"
+#define G_PASTE_BINARY_VERSION 1
+
+struct _GPasteBinaryBackend
+{
+    GPasteFileBackend parent_instance;
+};
+
+G_PASTE_DEFINE_TYPE (BinaryBackend, binary_backend, G_PASTE_TYPE_FILE_BACKEND)
+
+typedef enum
+{
+    KIND_TEXT,
+    KIND_URIS,
+    KIND_IMAGE
+} GPasteBinaryKind;
+
+typedef struct
+{
+    gchar   magic[8];
+    guint32 version;
+    guint32 n_items;
+    guint64 n_specials;
+    guint64 file_size;
+} GPasteBinaryHeader;
+
+typedef struct
+{
+    gchar   uuid[36];
+    guint32 kind;
+    gint64  date;
+    guint64 value_offset;
+    guint64 value_length;
+    guint64 first_special;
+    guint32 n_specials;
+    guint32 padding;
+} GPasteBinaryEntry;
+
+typedef struct
+{
+    guint64 mime_offset;
+    guint64 mime_length;
+    guint64 data_offset;
+    guint64 data_length;
+} GPasteBinarySpecial;
+
+G_STATIC_ASSERT (sizeof (GPasteBinaryHeader) == 32);
+G_STATIC_ASSERT (sizeof (GPasteBinaryEntry) == 80);
+G_STATIC_ASSERT (sizeof (GPasteBinarySpecial) == 32);
+
+static gchar *
+_g_paste_binary_backend_get_xml_path (const gchar *history_file_path)
+{
+    g_autofree gchar *base = g_strndup (history_file_path, strlen (history_file_path) - strlen (".bin"));
+
+    return g_strconcat (base, ".xml", NULL);
+}
+
+/***********************/
+/* Begin Binary Writer */
+/***********************/
+
+static const gchar *
+_g_paste_binary_backend_get_mime (const GPasteSpecialValue *value)
+{
+    return g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SPECIAL_ATOM), value->mime)->value_nick;
+}
+
+static guint64
+_g_paste_binary_backend_add_string (guint64     *offset,
+                                    const gchar *str,
+                                    guint64     *length)
+{
+    guint64 start = *offset;
+
+    *length = strlen (str);
+    *offset += *length + 1;
+
+    return GUINT64_TO_LE (start);
+}
+
+static gboolean
+_g_paste_binary_backend_write_string (GOutputStream *stream,
+                                      const gchar   *str)
+{
+    return g_output_stream_write_all (stream, str, strlen (str) + 1, NULL, NULL /* cancellable */, NULL /* error */);
+}
+
+static gboolean
+_g_paste_binary_backend_write (const GPasteStorageBackend *self,
+                               const gchar                *history_file_path,
+                               const GPtrArray            *items)
+{
+    g_autoptr (GArray) entries = g_array_sized_new (FALSE, TRUE, sizeof (GPasteBinaryEntry), items->len);
+    g_autoptr (GArray) specials = g_array_new (FALSE, TRUE, sizeof (GPasteBinarySpecial));
+    guint64 n_specials = 0;
+
+    for (guint i = 0; i < items->len; ++i)
+        n_specials += g_slist_length ((GSList *) g_paste_item_get_special_values (g_ptr_array_index (items, i)));
+
+    /* First pass: lay out the strings, which come after all the fixed size data */
+    guint64 offset = sizeof (GPasteBinaryHeader) + items->len * sizeof (GPasteBinaryEntry) + n_specials * sizeof (GPasteBinarySpecial);
+
+    for (guint i = 0; i < items->len; ++i)
+    {
+        const GPasteItem *item = g_ptr_array_index (items, i);
+        const gchar *uuid = g_paste_item_get_uuid (item);
+        GPasteBinaryEntry entry = { { 0 }, 0, 0, 0, 0, 0, 0, 0 };
+        guint64 value_length;
+
+        memcpy (entry.uuid, uuid, MIN (strlen (uuid), sizeof (entry.uuid)));
+        entry.first_special = GUINT64_TO_LE (specials->len);
+        entry.value_offset = _g_paste_binary_backend_add_string (&offset, g_paste_item_get_value (item), &value_length);
+        entry.value_length = GUINT64_TO_LE (value_length);
+
+        if (_G_PASTE_IS_IMAGE_ITEM (item))
+        {
+            entry.kind = GUINT32_TO_LE (KIND_IMAGE);
+            entry.date = GINT64_TO_LE (g_date_time_to_unix ((GDateTime *) g_paste_image_item_get_date (_G_PASTE_IMAGE_ITEM (item))));
+        }
+        else
+        {
+            entry.kind = GUINT32_TO_LE ((_G_PASTE_IS_URIS_ITEM (item)) ? KIND_URIS : KIND_TEXT);
+        }
+
+        guint32 count = 0;
+
+        for (const GSList *val = g_paste_item_get_special_values (item); val; val = val->next, ++count)
+        {
+            const GPasteSpecialValue *value = val->data;
+            GPasteBinarySpecial special;
+            guint64 length;
+
+            special.mime_offset = _g_paste_binary_backend_add_string (&offset, _g_paste_binary_backend_get_mime (value), &length);
+            special.mime_length = GUINT64_TO_LE (length);
+            special.data_offset = _g_paste_binary_backend_add_string (&offset, value->data, &length);
+            special.data_length = GUINT64_TO_LE (length);
+
+            g_array_append_val (specials, special);
+        }
+
+        entry.n_specials = GUINT32_TO_LE (count);
+        g_array_append_val (entries, entry);
+    }
+
+    GPasteBinaryHeader header;
+
+    memcpy (header.magic, G_PASTE_BINARY_MAGIC, sizeof (header.magic));
+    header.version = GUINT32_TO_LE (G_PASTE_BINARY_VERSION);
+    header.n_items = GUINT32_TO_LE (items->len);
+    header.n_specials = GUINT64_TO_LE (n_specials);
+    header.file_size = GUINT64_TO_LE (offset);
+
+    const GPasteFileBackend *real_self = _G_PASTE_FILE_BACKEND (self);
+    g_autoptr (GFile) history_file = g_file_new_for_path (history_file_path);
+    g_autoptr (GOutputStream) stream = _G_PASTE_FILE_BACKEND_GET_CLASS (real_self)->get_output_stream (real_self, history_file);
+
+    if (!stream ||
+        !g_output_stream_write_all (stream, &header, sizeof (header), NULL, NULL /* cancellable */, NULL /* error */) ||
+        !g_output_stream_write_all (stream, entries->data, entries->len * sizeof (GPasteBinaryEntry), NULL, NULL /* cancellable */, NULL /* error */) ||
+        !g_output_stream_write_all (stream, specials->data, specials->len * sizeof (GPasteBinarySpecial), NULL, NULL /* cancellable */, NULL /* error */))
+    {
+        return FALSE;
+    }
+
+    /* Second pass: the strings, in the same order as laid out */
+    for (guint i = 0; i < items->len; ++i)
+    {
+        const GPasteItem *item = g_ptr_array_index (items, i);
+
+        if (!_g_paste_binary_backend_write_string (stream, g_paste_item_get_value (item)))
+            return FALSE;
+
+        for (const GSList *val = g_paste_item_get_special_values (item); val; val = val->next)
+        {
+            const GPasteSpecialValue *value = val->data;
+
+            if (!_g_paste_binary_backend_write_string (stream, _g_paste_binary_backend_get_mime (value)) ||
+                !_g_paste_binary_backend_write_string (stream, value->data))
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return g_output_stream_close (stream, NULL /* cancellable */, NULL /* error */);
+}
+
+/*********************/
+/* End Binary Writer */
+/*********************/
+
+static GPtrArray *
+_g_paste_binary_backend_get_persisted_items (const GList *history)
+{
+    GPtrArray *items = g_ptr_array_new ();
+
+    for (; history; history = g_list_next (history))
+    {
+        GPasteItem *item = history->data;
+
+        /* Passwords are never saved, see GPasteFileBackend */
+        if (!_G_PASTE_IS_PASSWORD_ITEM (item))
+            g_ptr_array_add (items, item);
+    }
+
+    return items;
+}
+
+static void
+g_paste_binary_backend_write_history_file (const GPasteStorageBackend *self,
+                                           const gchar                *history_file_path,
+                                           const GList                *history)
+{
+    const GPasteSettings *settings = _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->get_settings (self);
+
+    if (!g_paste_util_ensure_history_dir_exists (settings))
+        return;
+
+    if (!g_paste_settings_get_save_history (settings))
+    {
+        g_autoptr (GFile) history_file = g_file_new_for_path (history_file_path);
+
+        g_file_delete (history_file,
+                       NULL, /* cancellable*/
+                       NULL); /* error */
+
+        return;
+    }
+
+    g_autoptr (GPtrArray) items = _g_paste_binary_backend_get_persisted_items (history);
+
+    if (!_g_paste_binary_backend_write (self, history_file_path, items))
+        g_warning ("Failed to write binary history");
+}
+
+/***********************/
+/* Begin Binary Reader */
+/***********************/
+
+typedef struct
+{
+    const gchar *contents;
+    guint64      length;
+    gboolean     images_support;
+    GHashTable  *uuids;
+} GPasteBinaryReader;
+
+static const gchar *
+_g_paste_binary_reader_get_string (const GPasteBinaryReader *reader,
+                                   guint64                   offset,
+                                   guint64                   length)
+{
+    offset = GUINT64_FROM_LE (offset);
+    length = GUINT64_FROM_LE (length);
+
+    if (offset >= reader->length || length >= reader->length - offset || reader->contents[offset + length])
+        return NULL;
+
+    return reader->contents + offset;
+}
+
+static GPasteItem *
+_g_paste_binary_reader_build_item (const GPasteBinaryReader  *reader,
+                                   const GPasteBinaryEntry   *entry,
+                                   const GPasteBinarySpecial *specials)
+{
+    const gchar *value = _g_paste_binary_reader_get_string (reader, entry->value_offset, entry->value_length);
+
+    if (!value)
+        return NULL;
+
+    GPasteItem *item = NULL;
+
+    switch (GUINT32_FROM_LE (entry->kind))
+    {
+    case KIND_TEXT:
+        item = g_paste_text_item_new (value);
+        break;
+    case KIND_URIS:
+        item = g_paste_uris_item_new (value);
+        break;
+    case KIND_IMAGE:
+        if (reader->images_support)
+        {
+            g_autoptr (GDateTime) date_time = g_date_time_new_from_unix_local (GINT64_FROM_LE (entry->date));
+
+            item = g_paste_image_item_new_from_file (value, date_time);
+        }
+        else
+        {
+            g_autoptr (GFile) img_file = g_file_new_for_path (value);
+
+            g_file_delete (img_file,
+                           NULL, /* cancellable */
+                           NULL); /* error */
+        }
+        break;
+    default:
+        g_warning ("Unknown binary item kind: %" G_GUINT32_FORMAT, GUINT32_FROM_LE (entry->kind));
+        break;
+    }
+
+    if (!item)
+        return NULL;
+
+    gchar uuid[sizeof (entry->uuid) + 1];
+
+    memcpy (uuid, entry->uuid, sizeof (entry->uuid));
+    uuid[sizeof (entry->uuid)] = '\0';
+
+    if (g_uuid_string_is_valid (uuid) && !g_hash_table_contains (reader->uuids, uuid))
+    {
+        g_paste_item_set_uuid (item, uuid);
+    }
+    else
+    {
+        g_autofree gchar *new_uuid = g_uuid_string_random ();
+
+        g_paste_item_set_uuid (item, new_uuid);
+    }
+    g_hash_table_add (reader->uuids, (gpointer) g_paste_item_get_uuid (item));
+
+    for (guint32 i = 0, n = GUINT32_FROM_LE (entry->n_specials); i < n; ++i)
+    {
+        const GPasteBinarySpecial *special = &specials[i];
+        const gchar *mime = _g_paste_binary_reader_get_string (reader, special->mime_offset, special->mime_length);
+        const gchar *data = _g_paste_binary_reader_get_string (reader, special->data_offset, special->data_length);
+        GEnumValue *gev = (mime) ? g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_SPECIAL_ATOM), mime) : NULL;
+
+        if (gev && data)
+        {
+            GPasteSpecialValue sv = { gev->value, (gchar *) data };
+
+            g_paste_item_add_special_value (item, &sv);
+        }
+        else
+        {
+            g_warning ("Invalid special value in binary history");
+        }
+    }
+
+    return item;
+}
+
+static gboolean
+_g_paste_binary_backend_read (const gchar *history_file_path,
+                              guint64      max_history_size,
+                              gboolean     images_support,
+                              GList      **history,
+                              gsize       *size)
+{
+    g_autoptr (GError) error = NULL;
+    g_autoptr (GMappedFile) mapped = g_mapped_file_new (history_file_path, FALSE, &error);
+
+    if (!mapped)
+    {
+        g_warning ("Failed to map binary history: %s", error->message);
+        return FALSE;
+    }
+
+    GPasteBinaryReader reader = {
+        g_mapped_file_get_contents (mapped),
+        g_mapped_file_get_length (mapped),
+        images_support,
+        NULL
+    };
+    GPasteBinaryHeader header;
+
+    if (reader.length < sizeof (header))
+        return FALSE;
+
+    memcpy (&header, reader.contents, sizeof (header));
+
+    guint32 n_items = GUINT32_FROM_LE (header.n_items);
+    guint64 n_specials = GUINT64_FROM_LE (header.n_specials);
+
+    if (memcmp (header.magic, G_PASTE_BINARY_MAGIC, sizeof (header.magic)))
+    {
+        g_warning ("Invalid binary history");
+        return FALSE;
+    }
+    if (GUINT32_FROM_LE (header.version) != G_PASTE_BINARY_VERSION)
+    {
+        g_warning ("Unknown binary history version: %" G_GUINT32_FORMAT, GUINT32_FROM_LE (header.version));
+        return FALSE;
+    }
+    if (GUINT64_FROM_LE (header.file_size) != reader.length ||
+        n_specials > reader.length / sizeof (GPasteBinarySpecial) ||
+        sizeof (header) + n_items * sizeof (GPasteBinaryEntry) + n_specials * sizeof (GPasteBinarySpecial) > reader.length)
+    {
+        g_warning ("Truncated binary history");
+        return FALSE;
+    }
+
+    const gchar *entries = reader.contents + sizeof (header);
+    const GPasteBinarySpecial *specials = (const GPasteBinarySpecial *) (entries + n_items * sizeof (GPasteBinaryEntry));
+    GList *items = NULL;
+    guint64 count = 0;
+
+    reader.uuids = g_hash_table_new (g_str_hash, g_str_equal);
+    *size = 0;
+
+    /* Only the entries we keep are ever touched, the others never even get paged in */
+    for (guint32 i = 0; i < n_items && count < max_history_size; ++i)
+    {
+        GPasteBinaryEntry entry;
+
+        memcpy (&entry, entries + i * sizeof (GPasteBinaryEntry), sizeof (entry));
+
+        guint64 first_special = GUINT64_FROM_LE (entry.first_special);
+
+        if (first_special > n_specials || GUINT32_FROM_LE (entry.n_specials) > n_specials - first_special)
+        {
+            g_warning ("Invalid binary history entry");
+            continue;
+        }
+
+        GPasteItem *item = _g_paste_binary_reader_build_item (&reader, &entry, specials + first_special);
+
+        if (item)
+        {
+            *size += g_paste_item_get_size (item);
+            items = g_list_prepend (items, item);
+            ++count;
+        }
+    }
+
+    g_hash_table_unref (reader.uuids);
+    *history = g_list_reverse (items);
+
+    return TRUE;
+}
+
+/*********************/
+/* End Binary Reader */
+/*********************/
+
+static void
+g_paste_binary_backend_read_history_file (const GPasteStorageBackend *self,
+                                          const gchar                *history_file_path,
+                                          GList                     **history,
+                                          gsize                      *size)
+{
+    const GPasteSettings *settings = _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->get_settings (self);
+
+    if (g_file_test (history_file_path, G_FILE_TEST_EXISTS))
+    {
+        _g_paste_binary_backend_read (history_file_path,
+                                      g_paste_settings_get_max_history_size (settings),
+                                      g_paste_settings_get_images_support (settings),
+                                      history,
+                                      size);
+        return;
+    }
+
+    g_autofree gchar *xml_path = _g_paste_binary_backend_get_xml_path (history_file_path);
+
+    if (!g_file_test (xml_path, G_FILE_TEST_EXISTS))
+    {
+        /* Create the empty file to be listed as an available history */
+        g_paste_binary_backend_write_history_file (self, history_file_path, NULL);
+        return;
+    }
+
+    g_debug ("binary: converting '%s'", xml_path);
+
+    G_PASTE_STORAGE_BACKEND_CLASS (g_paste_binary_backend_parent_class)->read_history_file (self, xml_path, history, size);
+
+    g_autoptr (GPtrArray) items = _g_paste_binary_backend_get_persisted_items (*history);
+
+    if (g_paste_util_ensure_history_dir_exists (settings) && _g_paste_binary_backend_write (self, history_file_path, items))
+    {
+        g_autofree gchar *backup_path = g_strconcat (xml_path, ".bak", NULL);
+
+        if (g_rename (xml_path, backup_path))
+            g_warning ("Failed to move away the converted XML history");
+    }
+    else
+    {
+        g_warning ("Failed to convert the XML history, keeping it");
+    }
+}
+
+static const gchar *
+g_paste_binary_backend_get_extension (const GPasteStorageBackend *self G_GNUC_UNUSED)
+{
+    return "bin";
+}
+
+static void
+g_paste_binary_backend_class_init (GPasteBinaryBackendClass *klass)
+{
+    GPasteStorageBackendClass *storage_class = G_PASTE_STORAGE_BACKEND_CLASS (klass);
+
+    storage_class->read_history_file = g_paste_binary_backend_read_history_file;
+    storage_class->write_history_file = g_paste_binary_backend_write_history_file;
+    storage_class->get_extension = g_paste_binary_backend_get_extension;
+}
+
+static void
+g_paste_binary_backend_init (GPasteBinaryBackend *self G_GNUC_UNUSED)
+{
+}
@@ -0,0 +1,24 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_BINARY_BACKEND_H__
+#define __G_PASTE_BINARY_BACKEND_H__
+
+#include <gpaste-file-backend.h>
+
+G_BEGIN_DECLS
+
+#define G_PASTE_TYPE_BINARY_BACKEND (g_paste_binary_backend_get_type ())
+
+G_PASTE_FINAL_TYPE (BinaryBackend, binary_backend, BINARY_BACKEND, GPasteFileBackend)
+
+G_END_DECLS
+
+#endif /*__G_PASTE_BINARY_BACKEND_H__*/
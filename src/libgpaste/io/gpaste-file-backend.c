@@ -142,6 +142,10 @@ typedef enum
 typedef struct
 {
     GList            *history;
+    /* Last element of history, to append in constant time */
+    GList            *tail;
+    /* uuids of the items in history, owned by the items */
+    GHashTable       *uuids;
     gsize             mem_size;
     State             state;
     Type              type;
@@ -168,18 +172,25 @@ typedef struct
     data->state = y
 
 static gboolean
-history_contains_uuid (const GList *history,
-                       const gchar *uuid)
+is_blank (const gchar *text,
+          gsize        text_len)
 {
-    for (; history; history = g_list_next (history))
+    for (gsize i = 0; i < text_len; ++i)
     {
-        const GPasteItem *item = history->data;
-
-        if (g_paste_str_equal (g_paste_item_get_uuid (item), uuid))
-            return TRUE;
+        if (!g_ascii_isspace (text[i]))
+            return FALSE;
     }
 
-    return FALSE;
+    return TRUE;
+}
+
+static gchar *
+decode_text (const gchar *text,
+             gsize        text_len)
+{
+    g_autofree gchar *txt = g_strndup (text, text_len);
+
+    return g_paste_util_xml_decode (txt);
 }
 
 static void
@@ -239,7 +250,7 @@ start_tag (GMarkupParseContext *context G_GNUC_UNUSED,
             }
             else if (g_paste_str_equal (*a, "uuid"))
             {
-                if (g_uuid_string_is_valid (*v) && !history_contains_uuid (data->history, *v))
+                if (g_uuid_string_is_valid (*v) && !g_hash_table_contains (data->uuids, *v))
                     data->uuid = g_strdup (*v);
             }
             else if (g_paste_str_equal (*a, "date"))
@@ -333,9 +344,22 @@ add_item (Data *data)
             data->uuid = g_uuid_string_random ();
 
         g_paste_item_set_uuid (item, data->uuid);
+        g_hash_table_add (data->uuids, (gpointer) g_paste_item_get_uuid (item));
         data->mem_size += g_paste_item_get_size (item);
-        data->history = g_list_append (data->history, item);
-        ++data->current_size;;
+
+        GList *link = g_list_prepend (NULL, item);
+
+        if (data->tail)
+        {
+            data->tail->next = link;
+            link->prev = data->tail;
+        }
+        else
+        {
+            data->history = link;
+        }
+        data->tail = link;
+        ++data->current_size;
     }
 
     for (GSList *d = data->special_values; d; d = d->next)
@@ -399,15 +423,17 @@ on_text (GMarkupParseContext *context G_GNUC_UNUSED,
 {
     Data *data = user_data;
 
-    g_autofree gchar *txt = g_strndup (text, text_len);
+    /* Most of the chunks we get are indentation: don't copy anything for those */
+    gboolean blank = is_blank (text, text_len);
+
     switch (data->state)
     {
     case IN_HISTORY:
     case IN_ITEM_WITH_TEXT:
     case IN_VALUE_WITH_TEXT:
-        if (*g_strstrip (txt))
+        if (!blank)
         {
-            g_warning ("Unexpected text: %s", txt);
+            g_warning ("Unexpected text: %.*s", (gint) text_len, text);
             return;
         }
         break;
@@ -415,28 +441,26 @@ on_text (GMarkupParseContext *context G_GNUC_UNUSED,
     {
         if (data->version == HISTORY_1_0)
         {
-            data->text = g_paste_util_xml_decode (txt);
-            if (*g_strstrip (txt))
+            if (!blank)
             {
+                g_free (data->text);
+                data->text = decode_text (text, text_len);
                 SWITCH_STATE (IN_ITEM, IN_ITEM_WITH_TEXT);
             }
-            else
-            {
-                g_clear_pointer (&data->text, g_free);
-            }
         }
-        else if (*g_strstrip (txt))
+        else if (!blank)
         {
-            g_warning ("Unexpected text in item for history version != 1.0 %s", txt);
+            g_warning ("Unexpected text in item for history version != 1.0 %.*s", (gint) text_len, text);
         }
         break;
     }
     case IN_VALUE:
         if (data->version == HISTORY_2_0)
         {
-            gchar *value = g_paste_util_xml_decode (txt);
-            if (*g_strstrip (txt))
+            if (!blank)
             {
+                gchar *value = decode_text (text, text_len);
+
                 SWITCH_STATE (IN_VALUE, IN_VALUE_WITH_TEXT);
                 if (data->mime == G_PASTE_SPECIAL_ATOM_INVALID)
                 {
@@ -451,10 +475,6 @@ on_text (GMarkupParseContext *context G_GNUC_UNUSED,
                     data->special_values = g_slist_prepend (data->special_values, sv);
                 }
             }
-            else
-            {
-                g_free (value);
-            }
         }
         else
         {
@@ -500,6 +520,8 @@ g_paste_file_backend_read_history_file (const GPasteStorageBackend *self,
         };
         Data data = {
             NULL,
+            NULL,
+            g_hash_table_new (g_str_hash, g_str_equal),
             0,
             BEGIN,
             TEXT,
@@ -530,6 +552,7 @@ g_paste_file_backend_read_history_file (const GPasteStorageBackend *self,
 
         *history = data.history;
         *size = data.mem_size;
+        g_hash_table_unref (data.uuids);
         g_clear_pointer (&data.date, g_free);
         g_clear_pointer (&data.name, g_free);
         g_clear_pointer (&data.text, g_free);
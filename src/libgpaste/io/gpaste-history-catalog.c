@@ -0,0 +1,301 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-history-catalog.h>
+#include <gpaste-password-item.h>
+#include <gpaste-util.h>
+
+#include <glib/gstdio.h>
+
+/*
+ * The catalog of the histories is stored in "catalog", next to them, as a
+ * serialized GVariant mapping the name of each history to whether we counted
+ * its items yet, how many there are, their size and the mtime of the history
+ * file they were counted from.
+ *
+ * It is updated each time a history is saved, so that listing the histories
+ * and getting their length never needs to read them. It is always written
+ * last, so if the history dir changed since then, someone else than us
+ * touched the histories and they have to be listed again. Histories could
+ * also have been added while we weren't running, so it isn't trusted for
+ * listing until we listed the history dir once.
+ */
+
+#define G_PASTE_HISTORY_CATALOG_TYPE "a{s(bttx)}"
+
+typedef struct
+{
+    gboolean counted;
+    guint64  n_items;
+    guint64  size;
+    gint64   mtime;
+} GPasteHistoryCatalogEntry;
+
+/* Saves happen in a thread, see GPasteHistory */
+static GMutex      g_paste_history_catalog_lock;
+static GHashTable *g_paste_history_catalog;
+/* The mtime of the history dir right after we last wrote the catalog */
+static gint64      g_paste_history_catalog_dir_mtime = -1;
+/* Whether the catalog has been synced with the history dir since we started */
+static gboolean    g_paste_history_catalog_synced = FALSE;
+
+/* In nanoseconds, seconds are too coarse to notice someone else writing right after us */
+static gint64
+_g_paste_history_catalog_get_mtime (const gchar *path)
+{
+    GStatBuf path_stat;
+
+    if (g_stat (path, &path_stat))
+        return -1;
+
+    return path_stat.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000) + path_stat.st_mtim.tv_nsec;
+}
+
+static gchar *
+_g_paste_history_catalog_get_path (void)
+{
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+
+    return g_build_filename (history_dir_path, "catalog", NULL);
+}
+
+/* Must be called with the lock held */
+static GHashTable *
+_g_paste_history_catalog_get (void)
+{
+    if (g_paste_history_catalog)
+        return g_paste_history_catalog;
+
+    g_paste_history_catalog = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    g_autofree gchar *catalog_path = _g_paste_history_catalog_get_path ();
+    gchar *contents = NULL;
+    gsize length;
+
+    if (!g_file_get_contents (catalog_path, &contents, &length, NULL /* error */))
+        return g_paste_history_catalog;
+
+    g_autoptr (GVariant) catalog = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (G_PASTE_HISTORY_CATALOG_TYPE),
+                                                                                contents,
+                                                                                length,
+                                                                                FALSE, /* trusted */
+                                                                                g_free,
+                                                                                contents));
+    GVariantIter iter;
+    const gchar *name;
+    GPasteHistoryCatalogEntry entry;
+
+    g_variant_iter_init (&iter, catalog);
+    while (g_variant_iter_next (&iter, "{&s(bttx)}", &name, &entry.counted, &entry.n_items, &entry.size, &entry.mtime))
+        g_hash_table_insert (g_paste_history_catalog, g_strdup (name), g_memdup (&entry, sizeof (entry)));
+
+    return g_paste_history_catalog;
+}
+
+/* Must be called with the lock held */
+static void
+_g_paste_history_catalog_save (void)
+{
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE (G_PASTE_HISTORY_CATALOG_TYPE));
+    g_hash_table_iter_init (&iter, _g_paste_history_catalog_get ());
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        const GPasteHistoryCatalogEntry *entry = value;
+
+        g_variant_builder_add (&builder, "{s(bttx)}", key, entry->counted, entry->n_items, entry->size, entry->mtime);
+    }
+
+    g_autoptr (GVariant) catalog = g_variant_ref_sink (g_variant_builder_end (&builder));
+    g_autofree gchar *catalog_path = _g_paste_history_catalog_get_path ();
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+    g_autoptr (GError) error = NULL;
+
+    g_paste_history_catalog_dir_mtime = -1;
+
+    if (!g_file_set_contents (catalog_path, g_variant_get_data (catalog), g_variant_get_size (catalog), &error))
+        g_warning ("Failed to write history catalog: %s", error->message);
+    else
+        g_paste_history_catalog_dir_mtime = _g_paste_history_catalog_get_mtime (history_dir_path);
+}
+
+/**
+ * g_paste_history_catalog_update:
+ * @name: the name of the history
+ * @history_file_path: the file @history was saved to or read from
+ * @history: (element-type GPasteItem): the history we just saved or read
+ *
+ * Record the length and size of a saved history in the catalog
+ */
+G_PASTE_VISIBLE void
+g_paste_history_catalog_update (const gchar *name,
+                                const gchar *history_file_path,
+                                const GList *history)
+{
+    g_return_if_fail (name);
+    g_return_if_fail (history_file_path);
+
+    gint64 mtime = _g_paste_history_catalog_get_mtime (history_file_path);
+
+    /* Nothing got saved, don't make it look like there is a history */
+    if (mtime == -1)
+        return;
+
+    GPasteHistoryCatalogEntry *entry = g_new (GPasteHistoryCatalogEntry, 1);
+
+    entry->counted = TRUE;
+    entry->n_items = 0;
+    entry->size = 0;
+    entry->mtime = mtime;
+
+    for (; history; history = g_list_next (history))
+    {
+        const GPasteItem *item = history->data;
+
+        /* Passwords are never saved, see GPasteFileBackend */
+        if (_G_PASTE_IS_PASSWORD_ITEM (item))
+            continue;
+
+        ++entry->n_items;
+        entry->size += g_paste_item_get_size (item);
+    }
+
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&g_paste_history_catalog_lock);
+
+    g_hash_table_insert (_g_paste_history_catalog_get (), g_strdup (name), entry);
+    _g_paste_history_catalog_save ();
+}
+
+/**
+ * g_paste_history_catalog_remove:
+ * @name: the name of the history
+ *
+ * Forget about a history which has been deleted
+ */
+G_PASTE_VISIBLE void
+g_paste_history_catalog_remove (const gchar *name)
+{
+    g_return_if_fail (name);
+
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&g_paste_history_catalog_lock);
+
+    if (g_hash_table_remove (_g_paste_history_catalog_get (), name))
+        _g_paste_history_catalog_save ();
+}
+
+/**
+ * g_paste_history_catalog_lookup:
+ * @name: the name of the history
+ * @history_file_path: the file the history is saved to
+ * @n_items: (out) (optional): the number of items in the history
+ * @size: (out) (optional): the size of the items
+ *
+ * Get what the catalog knows about a history
+ *
+ * Returns: whether the history has been counted since its file last changed
+ */
+G_PASTE_VISIBLE gboolean
+g_paste_history_catalog_lookup (const gchar *name,
+                                const gchar *history_file_path,
+                                guint64     *n_items,
+                                guint64     *size)
+{
+    g_return_val_if_fail (name, FALSE);
+    g_return_val_if_fail (history_file_path, FALSE);
+
+    gint64 mtime = _g_paste_history_catalog_get_mtime (history_file_path);
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&g_paste_history_catalog_lock);
+    const GPasteHistoryCatalogEntry *entry = g_hash_table_lookup (_g_paste_history_catalog_get (), name);
+
+    /* Someone else than us changed it, it has to be counted again */
+    if (!entry || !entry->counted || entry->mtime != mtime)
+        return FALSE;
+
+    if (n_items)
+        *n_items = entry->n_items;
+    if (size)
+        *size = entry->size;
+
+    return TRUE;
+}
+
+/**
+ * g_paste_history_catalog_list:
+ *
+ * Get the names of the histories, unless someone else than us touched
+ * them since we last updated the catalog, or we didn't sync it yet
+ *
+ * Returns: (transfer full) (nullable): the names of the histories,
+ *          or %NULL if the history dir has to be listed again
+ *          free it with g_strfreev
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_history_catalog_list (void)
+{
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&g_paste_history_catalog_lock);
+
+    if (!g_paste_history_catalog_synced ||
+        g_paste_history_catalog_dir_mtime == -1 ||
+        _g_paste_history_catalog_get_mtime (history_dir_path) != g_paste_history_catalog_dir_mtime)
+    {
+        return NULL;
+    }
+
+    GHashTable *catalog = _g_paste_history_catalog_get ();
+    GStrv names = g_new (gchar *, g_hash_table_size (catalog) + 1);
+    GHashTableIter iter;
+    gpointer name;
+    guint i = 0;
+
+    g_hash_table_iter_init (&iter, catalog);
+    while (g_hash_table_iter_next (&iter, &name, NULL))
+        names[i++] = g_strdup (name);
+    names[i] = NULL;
+
+    return names;
+}
+
+/**
+ * g_paste_history_catalog_sync:
+ * @names: (array zero-terminated=1): the names of the histories we just listed
+ *
+ * Make the catalog list exactly @names, the ones it didn't know
+ * about will be counted the first time someone asks for it
+ */
+G_PASTE_VISIBLE void
+g_paste_history_catalog_sync (const gchar * const *names)
+{
+    g_return_if_fail (names);
+
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&g_paste_history_catalog_lock);
+    GHashTable *catalog = _g_paste_history_catalog_get ();
+    g_autoptr (GHashTable) listed = g_hash_table_new (g_str_hash, g_str_equal);
+
+    for (const gchar * const *name = names; *name; ++name)
+    {
+        g_hash_table_add (listed, (gpointer) *name);
+
+        if (!g_hash_table_contains (catalog, *name))
+            g_hash_table_insert (catalog, g_strdup (*name), g_new0 (GPasteHistoryCatalogEntry, 1));
+    }
+
+    GHashTableIter iter;
+    gpointer name;
+
+    g_hash_table_iter_init (&iter, catalog);
+    while (g_hash_table_iter_next (&iter, &name, NULL))
+    {
+        if (!g_hash_table_contains (listed, name))
+            g_hash_table_iter_remove (&iter);
+    }
+
+    g_paste_history_catalog_synced = TRUE;
+    _g_paste_history_catalog_save ();
+}
@@ -0,0 +1,31 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_HISTORY_CATALOG_H__
+#define __G_PASTE_HISTORY_CATALOG_H__
+
+#include <gpaste-item.h>
+
+G_BEGIN_DECLS
+
+void     g_paste_history_catalog_update (const gchar         *name,
+                                         const gchar         *history_file_path,
+                                         const GList         *history);
+void     g_paste_history_catalog_remove (const gchar         *name);
+gboolean g_paste_history_catalog_lookup (const gchar         *name,
+                                         const gchar         *history_file_path,
+                                         guint64             *n_items,
+                                         guint64             *size);
+GStrv    g_paste_history_catalog_list   (void);
+void     g_paste_history_catalog_sync   (const gchar * const *names);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_HISTORY_CATALOG_H__*/
@@ -0,0 +1,402 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-history-index.h>
+#include <gpaste-password-item.h>
+#include <gpaste-search-index.h>
+#include <gpaste-util.h>
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/*
+ * The search index of a history is stored in "<name>.idx", next to it,
+ * so that the histories we're not using can be searched without loading them.
+ * It is written when we leave a history and rebuilt on demand when it is
+ * outdated, never on each save, so its header records the size and the
+ * modification time (in microseconds) of the files it was built from:
+ *
+ *   header | entries (one per item) | trigrams | texts
+ *
+ * Every integer is little endian. Each entry references the sorted distinct
+ * trigrams of its text, as computed by GPasteSearchIndex, to skip it without
+ * looking at its text when it can't contain a literal, and its NUL-terminated
+ * text, relative to the beginning of the texts, to check the candidates.
+ */
+
+#define G_PASTE_HISTORY_INDEX_MAGIC   "GPasteI\n"
+#define G_PASTE_HISTORY_INDEX_VERSION 2
+
+typedef struct
+{
+    gchar   magic[8];
+    guint32 version;
+    guint32 n_items;
+    guint64 n_trigrams;
+    guint64 file_size;
+    guint64 history_size;
+    guint64 history_mtime;
+} GPasteHistoryIndexHeader;
+
+typedef struct
+{
+    gchar   uuid[36];
+    guint32 n_trigrams;
+    guint64 first_trigram;
+    guint64 text_offset;
+    guint64 text_length;
+} GPasteHistoryIndexEntry;
+
+G_STATIC_ASSERT (sizeof (GPasteHistoryIndexHeader) == 48);
+G_STATIC_ASSERT (sizeof (GPasteHistoryIndexEntry) == 64);
+
+static gchar *
+_g_paste_history_index_get_path (const gchar *name)
+{
+    return g_paste_util_get_history_file_path (name, "idx");
+}
+
+static gboolean
+_g_paste_history_index_add_stamp (const gchar *path,
+                                  guint64     *size,
+                                  guint64     *mtime)
+{
+    g_autoptr (GFile) file = g_file_new_for_path (path);
+    g_autoptr (GFileInfo) info = g_file_query_info (file,
+                                                    G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                                    G_FILE_QUERY_INFO_NONE,
+                                                    NULL, /* cancellable */
+                                                    NULL); /* error */
+
+    if (!info)
+        return FALSE;
+
+    guint64 file_mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+                         g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+    *size += g_file_info_get_size (info);
+    *mtime = MAX (*mtime, file_mtime);
+
+    return TRUE;
+}
+
+/*
+ * Seconds are too coarse, a history can easily be saved twice within one.
+ * The journal of GPasteJournalBackend grows without touching the history file.
+ */
+static gboolean
+_g_paste_history_index_get_stamp (const gchar *history_file_path,
+                                  guint64     *size,
+                                  guint64     *mtime)
+{
+    g_autofree gchar *journal_path = g_strconcat (history_file_path, ".journal", NULL);
+
+    *size = *mtime = 0;
+
+    if (!_g_paste_history_index_add_stamp (history_file_path, size, mtime))
+        return FALSE;
+
+    _g_paste_history_index_add_stamp (journal_path, size, mtime);
+
+    return TRUE;
+}
+
+/**
+ * g_paste_history_index_is_up_to_date:
+ * @name: the name of the history
+ * @history_file_path: the file the history is saved in
+ *
+ * Check whether the search index of a history was built from
+ * the history file as it is now
+ *
+ * Returns: whether the index can be used instead of the history
+ */
+G_PASTE_VISIBLE gboolean
+g_paste_history_index_is_up_to_date (const gchar *name,
+                                     const gchar *history_file_path)
+{
+    g_return_val_if_fail (name, FALSE);
+    g_return_val_if_fail (history_file_path, FALSE);
+
+    g_autofree gchar *index_path = _g_paste_history_index_get_path (name);
+    g_autoptr (GFile) index_file = g_file_new_for_path (index_path);
+    g_autoptr (GFileInputStream) stream = g_file_read (index_file, NULL /* cancellable */, NULL /* error */);
+    GPasteHistoryIndexHeader header;
+    gsize read;
+    guint64 size, mtime;
+
+    if (!stream ||
+        !g_input_stream_read_all (G_INPUT_STREAM (stream), &header, sizeof (header), &read, NULL /* cancellable */, NULL /* error */) ||
+        read != sizeof (header) ||
+        memcmp (header.magic, G_PASTE_HISTORY_INDEX_MAGIC, sizeof (header.magic)) ||
+        GUINT32_FROM_LE (header.version) != G_PASTE_HISTORY_INDEX_VERSION)
+        return FALSE;
+
+    /* No history file, nothing to be outdated against */
+    if (!_g_paste_history_index_get_stamp (history_file_path, &size, &mtime))
+        return TRUE;
+
+    return GUINT64_FROM_LE (header.history_size) == size && GUINT64_FROM_LE (header.history_mtime) == mtime;
+}
+
+/**
+ * g_paste_history_index_write:
+ * @name: the name of the history
+ * @history_file_path: the file @history is saved in
+ * @history: (element-type GPasteItem): the history to index, as it is saved
+ *
+ * Write the search index of a history, to search it with
+ * g_paste_history_index_search later on
+ */
+G_PASTE_VISIBLE void
+g_paste_history_index_write (const gchar *name,
+                             const gchar *history_file_path,
+                             const GList *history)
+{
+    g_return_if_fail (name);
+    g_return_if_fail (history_file_path);
+
+    g_autoptr (GArray) entries = g_array_new (FALSE, TRUE, sizeof (GPasteHistoryIndexEntry));
+    g_autoptr (GArray) trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+    g_autoptr (GPtrArray) texts = g_ptr_array_new ();
+    guint64 text_offset = 0;
+
+    for (; history; history = g_list_next (history))
+    {
+        const GPasteItem *item = history->data;
+
+        /* Passwords are never saved, see GPasteFileBackend */
+        if (_G_PASTE_IS_PASSWORD_ITEM (item))
+            continue;
+
+        const gchar *uuid = g_paste_item_get_uuid (item);
+        const gchar *value = g_paste_item_get_value (item);
+        g_autoptr (GArray) item_trigrams = g_paste_search_index_get_trigrams (value);
+        GPasteHistoryIndexEntry entry = { { 0 }, 0, 0, 0, 0 };
+        guint64 text_length = strlen (value);
+
+        memcpy (entry.uuid, uuid, MIN (strlen (uuid), sizeof (entry.uuid)));
+        entry.n_trigrams = GUINT32_TO_LE (item_trigrams->len);
+        entry.first_trigram = GUINT64_TO_LE (trigrams->len);
+        entry.text_offset = GUINT64_TO_LE (text_offset);
+        entry.text_length = GUINT64_TO_LE (text_length);
+
+        for (guint i = 0; i < item_trigrams->len; ++i)
+        {
+            guint32 trigram = GUINT32_TO_LE (g_array_index (item_trigrams, guint32, i));
+
+            g_array_append_val (trigrams, trigram);
+        }
+
+        text_offset += text_length + 1;
+        g_array_append_val (entries, entry);
+        g_ptr_array_add (texts, (gpointer) value);
+    }
+
+    GPasteHistoryIndexHeader header;
+    guint64 history_size = 0, history_mtime = 0;
+
+    _g_paste_history_index_get_stamp (history_file_path, &history_size, &history_mtime);
+
+    memcpy (header.magic, G_PASTE_HISTORY_INDEX_MAGIC, sizeof (header.magic));
+    header.version = GUINT32_TO_LE (G_PASTE_HISTORY_INDEX_VERSION);
+    header.n_items = GUINT32_TO_LE (entries->len);
+    header.n_trigrams = GUINT64_TO_LE (trigrams->len);
+    header.file_size = GUINT64_TO_LE (sizeof (header) + entries->len * sizeof (GPasteHistoryIndexEntry) + trigrams->len * sizeof (guint32) + text_offset);
+    header.history_size = GUINT64_TO_LE (history_size);
+    header.history_mtime = GUINT64_TO_LE (history_mtime);
+
+    g_autofree gchar *index_path = _g_paste_history_index_get_path (name);
+    g_autoptr (GFile) index_file = g_file_new_for_path (index_path);
+    g_autoptr (GFileOutputStream) file_stream = g_file_replace (index_file,
+                                                                NULL,
+                                                                FALSE,
+                                                                G_FILE_CREATE_REPLACE_DESTINATION,
+                                                                NULL, /* cancellable */
+                                                                NULL); /* error */
+    GOutputStream *stream = G_OUTPUT_STREAM (file_stream);
+
+    if (!stream ||
+        !g_output_stream_write_all (stream, &header, sizeof (header), NULL, NULL /* cancellable */, NULL /* error */) ||
+        !g_output_stream_write_all (stream, entries->data, entries->len * sizeof (GPasteHistoryIndexEntry), NULL, NULL /* cancellable */, NULL /* error */) ||
+        !g_output_stream_write_all (stream, trigrams->data, trigrams->len * sizeof (guint32), NULL, NULL /* cancellable */, NULL /* error */))
+    {
+        g_warning ("Failed to write search index for history %s", name);
+        return;
+    }
+
+    for (guint i = 0; i < texts->len; ++i)
+    {
+        const gchar *text = g_ptr_array_index (texts, i);
+
+        if (!g_output_stream_write_all (stream, text, strlen (text) + 1, NULL, NULL /* cancellable */, NULL /* error */))
+        {
+            g_warning ("Failed to write search index for history %s", name);
+            return;
+        }
+    }
+
+    if (!g_output_stream_close (stream, NULL /* cancellable */, NULL /* error */))
+        g_warning ("Failed to finish writing search index for history %s", name);
+}
+
+/**
+ * g_paste_history_index_delete:
+ * @name: the name of the history
+ *
+ * Delete the search index of a history
+ */
+G_PASTE_VISIBLE void
+g_paste_history_index_delete (const gchar *name)
+{
+    g_return_if_fail (name);
+
+    g_autofree gchar *index_path = _g_paste_history_index_get_path (name);
+
+    g_unlink (index_path);
+}
+
+/* Both are sorted, check that every needle is part of the trigrams */
+static gboolean
+_g_paste_history_index_has_trigrams (const gchar  *trigrams,
+                                     guint32       n_trigrams,
+                                     const GArray *needles)
+{
+    guint32 i = 0;
+
+    for (guint n = 0; n < needles->len; ++n)
+    {
+        guint32 needle = g_array_index (needles, guint32, n);
+        guint32 trigram = 0;
+
+        for (; i < n_trigrams; ++i)
+        {
+            memcpy (&trigram, trigrams + i * sizeof (guint32), sizeof (guint32));
+            trigram = GUINT32_FROM_LE (trigram);
+
+            if (trigram >= needle)
+                break;
+        }
+
+        if (i == n_trigrams || trigram != needle)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * g_paste_history_index_search:
+ * @name: the name of the history
+ * @pattern: the pattern to look for
+ * @error: a #GError
+ *
+ * Search a history through its search index, without loading it.
+ * This matches the items like g_paste_history_search would.
+ *
+ * Returns: (transfer full) (nullable): the uuids of the matching items
+ *          free it with g_strfreev
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_history_index_search (const gchar *name,
+                              const gchar *pattern,
+                              GError     **error)
+{
+    g_return_val_if_fail (name, NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    g_autofree gchar *index_path = _g_paste_history_index_get_path (name);
+    g_autoptr (GMappedFile) mapped = g_mapped_file_new (index_path, FALSE, error);
+
+    if (!mapped)
+        return NULL;
+
+    const gchar *contents = g_mapped_file_get_contents (mapped);
+    guint64 length = g_mapped_file_get_length (mapped);
+    GPasteHistoryIndexHeader header;
+
+    if (length < sizeof (header))
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Truncated search index for history %s", name);
+        return NULL;
+    }
+
+    memcpy (&header, contents, sizeof (header));
+
+    guint32 n_items = GUINT32_FROM_LE (header.n_items);
+    guint64 n_trigrams = GUINT64_FROM_LE (header.n_trigrams);
+
+    if (memcmp (header.magic, G_PASTE_HISTORY_INDEX_MAGIC, sizeof (header.magic)) ||
+        GUINT32_FROM_LE (header.version) != G_PASTE_HISTORY_INDEX_VERSION)
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Invalid search index for history %s", name);
+        return NULL;
+    }
+    if (GUINT64_FROM_LE (header.file_size) != length ||
+        n_trigrams > length / sizeof (guint32) ||
+        sizeof (header) + n_items * sizeof (GPasteHistoryIndexEntry) + n_trigrams * sizeof (guint32) > length)
+    {
+        g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "Truncated search index for history %s", name);
+        return NULL;
+    }
+
+    g_autoptr (GRegex) regex = g_regex_new (pattern,
+                                            G_REGEX_CASELESS|G_REGEX_MULTILINE|G_REGEX_DOTALL|G_REGEX_OPTIMIZE,
+                                            G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY,
+                                            error);
+
+    if (!regex)
+        return NULL;
+
+    /* Same rule as GPasteHistory: only plain text patterns can use the trigrams */
+    g_autoptr (GArray) needles = (strpbrk (pattern, "\\^$.|?*+()[]{}")) ? NULL : g_paste_search_index_get_trigrams (pattern);
+    const gchar *entries = contents + sizeof (header);
+    const gchar *trigrams = entries + n_items * sizeof (GPasteHistoryIndexEntry);
+    const gchar *texts = trigrams + n_trigrams * sizeof (guint32);
+    guint64 texts_length = length - (texts - contents);
+    g_autoptr (GArray) results = g_array_new (TRUE, /* zero-terminated */
+                                              TRUE, /* clear */
+                                              sizeof (gchar *));
+
+    for (guint32 i = 0; i < n_items; ++i)
+    {
+        GPasteHistoryIndexEntry entry;
+        gchar uuid[sizeof (entry.uuid) + 1];
+
+        memcpy (&entry, entries + i * sizeof (GPasteHistoryIndexEntry), sizeof (entry));
+        memcpy (uuid, entry.uuid, sizeof (entry.uuid));
+        uuid[sizeof (entry.uuid)] = '\0';
+
+        /* The pattern may be the uuid of an item not containing it */
+        if (!g_paste_str_equal (pattern, uuid))
+        {
+            guint64 first_trigram = GUINT64_FROM_LE (entry.first_trigram);
+            guint32 entry_trigrams = GUINT32_FROM_LE (entry.n_trigrams);
+            guint64 text_offset = GUINT64_FROM_LE (entry.text_offset);
+            guint64 text_length = GUINT64_FROM_LE (entry.text_length);
+
+            if (first_trigram > n_trigrams || entry_trigrams > n_trigrams - first_trigram ||
+                text_offset >= texts_length || text_length >= texts_length - text_offset || texts[text_offset + text_length])
+            {
+                g_warning ("Invalid search index entry for history %s", name);
+                continue;
+            }
+
+            if (needles && needles->len && !_g_paste_history_index_has_trigrams (trigrams + first_trigram * sizeof (guint32), entry_trigrams, needles))
+                continue;
+            if (!g_regex_match (regex, texts + text_offset, G_REGEX_MATCH_NOTEMPTY|G_REGEX_MATCH_NEWLINE_ANY, NULL))
+                continue;
+        }
+
+        gchar *id = g_strdup (uuid);
+        g_array_append_val (results, id);
+    }
+
+    return g_array_steal (results, NULL);
+}
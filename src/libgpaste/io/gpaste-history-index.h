@@ -0,0 +1,30 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_HISTORY_INDEX_H__
+#define __G_PASTE_HISTORY_INDEX_H__
+
+#include <gpaste-item.h>
+
+G_BEGIN_DECLS
+
+gboolean g_paste_history_index_is_up_to_date (const gchar  *name,
+                                              const gchar  *history_file_path);
+void     g_paste_history_index_write         (const gchar  *name,
+                                              const gchar  *history_file_path,
+                                              const GList  *history);
+void     g_paste_history_index_delete        (const gchar  *name);
+GStrv    g_paste_history_index_search        (const gchar  *name,
+                                              const gchar  *pattern,
+                                              GError      **error);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_HISTORY_INDEX_H__*/
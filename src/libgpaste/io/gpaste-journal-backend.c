@@ -0,0 +1,918 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-image-item.h>
+#include <gpaste-journal-backend.h>
+#include <gpaste-password-item.h>
+#include <gpaste-uris-item.h>
+#include <gpaste-util.h>
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/*
+ * The history file written by GPasteFileBackend is used as a base snapshot,
+ * and every change made since is appended to "<history file>.journal" as one
+ * of those records:
+ *
+ *   + <index> <uuid> <kind> <date|-> <n special values>\n
+ *   <mime|-> <length>\n<value>\n   (the value, then each special value)
+ *   - <uuid>\n
+ *   > <index> <uuid>\n
+ *
+ * The journal starts with a header identifying the base it applies to, and
+ * gets compacted into a new base in a worker thread once it grows too big.
+ * The new base is written aside, then the journal it needs (what was appended
+ * since the compaction started) is written to "<journal>.next" before both
+ * are renamed into place, so that whenever we die, either the old base and
+ * journal or the new base and the next journal make a valid pair.
+ */
+
+#define G_PASTE_JOURNAL_MAGIC       "GPasteJournal 1"
+#define G_PASTE_JOURNAL_MIN_RECORDS 256
+
+struct _GPasteJournalBackend
+{
+    GPasteFileBackend parent_instance;
+};
+
+typedef struct
+{
+    /* Writes can come from the history's saving thread, compactions end in the main context */
+    GMutex      lock;
+    /* history file path -> GPasteJournalState */
+    GHashTable *states;
+    /* Never reused, even when a state gets dropped, so that stale compactions can tell */
+    guint64     next_generation;
+} GPasteJournalBackendPrivate;
+
+G_PASTE_DEFINE_TYPE_WITH_PRIVATE (JournalBackend, journal_backend, G_PASTE_TYPE_FILE_BACKEND)
+
+typedef struct
+{
+    /* uuids of the persisted items, in order */
+    GPtrArray *uuids;
+    guint64    records;
+    goffset    journal_size;
+    guint64    generation;
+    gboolean   compacting;
+} GPasteJournalState;
+
+typedef struct
+{
+    gchar   *path;
+    GList   *history;
+    guint64  records;
+    goffset  journal_size;
+    guint64  generation;
+} GPasteJournalCompaction;
+
+typedef struct
+{
+    const gchar *cursor;
+    const gchar *end;
+} GPasteJournalReader;
+
+static void
+g_paste_journal_state_free (gpointer data)
+{
+    GPasteJournalState *state = data;
+
+    g_ptr_array_unref (state->uuids);
+    g_free (state);
+}
+
+static void
+g_paste_journal_compaction_free (gpointer data)
+{
+    GPasteJournalCompaction *compaction = data;
+
+    g_free (compaction->path);
+    g_list_free_full (compaction->history, g_object_unref);
+    g_free (compaction);
+}
+
+static GPasteJournalBackendPrivate *
+_g_paste_journal_backend_get_private (const GPasteStorageBackend *self)
+{
+    /* Our state is a cache of what's on disk, updating it doesn't change the backend */
+    return g_paste_journal_backend_get_instance_private ((GPasteJournalBackend *) self);
+}
+
+static gchar *
+_g_paste_journal_backend_get_journal_path (const gchar *history_file_path)
+{
+    return g_strconcat (history_file_path, ".journal", NULL);
+}
+
+static gchar *
+_g_paste_journal_backend_get_next_journal_path (const gchar *history_file_path)
+{
+    return g_strconcat (history_file_path, ".journal.next", NULL);
+}
+
+static gchar *
+_g_paste_journal_backend_get_compacted_path (const gchar *history_file_path)
+{
+    return g_strconcat (history_file_path, ".compacted", NULL);
+}
+
+/* Identifies the base history file a journal applies to */
+static gchar *
+_g_paste_journal_backend_get_header (const gchar *history_file_path)
+{
+    g_autoptr (GFile) history_file = g_file_new_for_path (history_file_path);
+    g_autoptr (GFileInfo) info = g_file_query_info (history_file,
+                                                    G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                                    G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                                    G_FILE_QUERY_INFO_NONE,
+                                                    NULL, /* cancellable */
+                                                    NULL); /* error */
+
+    if (!info)
+        return NULL;
+
+    return g_strdup_printf (G_PASTE_JOURNAL_MAGIC " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT ".%06" G_GUINT32_FORMAT "\n",
+                            (guint64) g_file_info_get_size (info),
+                            g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                            g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+}
+
+/* Write a journal made of records, applying to the base at base_path */
+static gboolean
+_g_paste_journal_backend_write_journal (const gchar *journal_path,
+                                        const gchar *base_path,
+                                        const gchar *records,
+                                        gsize        records_length,
+                                        goffset     *journal_size)
+{
+    g_autofree gchar *header = _g_paste_journal_backend_get_header (base_path);
+
+    if (!header)
+        return FALSE;
+
+    g_autoptr (GString) contents = g_string_new (header);
+
+    g_string_append_len (contents, records, records_length);
+
+    if (!g_file_set_contents (journal_path, contents->str, contents->len, NULL /* error */))
+        return FALSE;
+
+    *journal_size = contents->len;
+    return TRUE;
+}
+
+static gboolean
+_g_paste_journal_backend_reset_journal (const gchar *history_file_path,
+                                        const gchar *records,
+                                        gsize        records_length,
+                                        goffset     *journal_size)
+{
+    g_autofree gchar *journal_path = _g_paste_journal_backend_get_journal_path (history_file_path);
+
+    return _g_paste_journal_backend_write_journal (journal_path, history_file_path, records, records_length, journal_size);
+}
+
+static void
+_g_paste_journal_backend_delete_journal (const gchar *history_file_path)
+{
+    g_autofree gchar *journal_path = _g_paste_journal_backend_get_journal_path (history_file_path);
+    g_autoptr (GFile) journal = g_file_new_for_path (journal_path);
+
+    g_file_delete (journal,
+                   NULL, /* cancellable */
+                   NULL); /* error */
+}
+
+/************************/
+/* Begin Journal Writer */
+/************************/
+
+static void
+_g_paste_journal_backend_write_value (GString     *records,
+                                      const gchar *mime,
+                                      const gchar *value)
+{
+    gsize length = strlen (value);
+
+    g_string_append_printf (records, "%s %" G_GSIZE_FORMAT "\n", mime, length);
+    g_string_append_len (records, value, length);
+    g_string_append_c (records, '\n');
+}
+
+static void
+_g_paste_journal_backend_write_add (GString          *records,
+                                    const GPasteItem *item,
+                                    guint             index)
+{
+    const GSList *special_values = g_paste_item_get_special_values (item);
+    g_autofree gchar *date = NULL;
+
+    if (_G_PASTE_IS_IMAGE_ITEM (item))
+        date = g_date_time_format ((GDateTime *) g_paste_image_item_get_date (_G_PASTE_IMAGE_ITEM (item)), "%s");
+
+    g_string_append_printf (records, "+ %u %s %s %s %u\n",
+                            index,
+                            g_paste_item_get_uuid (item),
+                            g_paste_item_get_kind (item),
+                            (date) ? date : "-",
+                            g_slist_length ((GSList *) special_values));
+    _g_paste_journal_backend_write_value (records, "-", g_paste_item_get_value (item));
+
+    for (const GSList *val = special_values; val; val = val->next)
+    {
+        const GPasteSpecialValue *value = val->data;
+        const gchar *mime = g_enum_get_value (g_type_class_peek (G_PASTE_TYPE_SPECIAL_ATOM), value->mime)->value_nick;
+
+        _g_paste_journal_backend_write_value (records, mime, value->data);
+    }
+}
+
+/*
+ * Emit the records turning the persisted order (old_uuids) into items.
+ * Returns the number of records emitted.
+ */
+static guint64
+_g_paste_journal_backend_diff (GString         *records,
+                               const GPtrArray *old_uuids,
+                               const GPtrArray *items)
+{
+    g_autoptr (GHashTable) new_uuids = g_hash_table_new (g_str_hash, g_str_equal);
+    g_autoptr (GHashTable) current_uuids = g_hash_table_new (g_str_hash, g_str_equal);
+    g_autoptr (GPtrArray) current = g_ptr_array_sized_new (old_uuids->len);
+    guint64 count = 0;
+
+    for (guint i = 0; i < items->len; ++i)
+        g_hash_table_add (new_uuids, (gpointer) g_paste_item_get_uuid (g_ptr_array_index (items, i)));
+
+    for (guint i = 0; i < old_uuids->len; ++i)
+    {
+        gpointer uuid = g_ptr_array_index (old_uuids, i);
+
+        if (g_hash_table_contains (new_uuids, uuid))
+        {
+            g_ptr_array_add (current, uuid);
+            g_hash_table_add (current_uuids, uuid);
+        }
+        else
+        {
+            g_string_append_printf (records, "- %s\n", (const gchar *) uuid);
+            ++count;
+        }
+    }
+
+    /* Invariant: current[0..i) matches items[0..i) */
+    for (guint i = 0; i < items->len; ++i)
+    {
+        const GPasteItem *item = g_ptr_array_index (items, i);
+        const gchar *uuid = g_paste_item_get_uuid (item);
+
+        if (i < current->len && g_paste_str_equal (g_ptr_array_index (current, i), uuid))
+            continue;
+
+        if (g_hash_table_contains (current_uuids, uuid))
+        {
+            for (guint j = i + 1; j < current->len; ++j)
+            {
+                if (g_paste_str_equal (g_ptr_array_index (current, j), uuid))
+                {
+                    g_ptr_array_remove_index (current, j);
+                    break;
+                }
+            }
+            g_string_append_printf (records, "> %u %s\n", i, uuid);
+        }
+        else
+        {
+            g_hash_table_add (current_uuids, (gpointer) uuid);
+            _g_paste_journal_backend_write_add (records, item, i);
+        }
+
+        g_ptr_array_insert (current, i, (gpointer) uuid);
+        ++count;
+    }
+
+    return count;
+}
+
+/**********************/
+/* End Journal Writer */
+/**********************/
+
+/************************/
+/* Begin Journal Reader */
+/************************/
+
+static gchar *
+_g_paste_journal_reader_next_line (GPasteJournalReader *reader)
+{
+    if (reader->cursor >= reader->end)
+        return NULL;
+
+    const gchar *eol = memchr (reader->cursor, '\n', reader->end - reader->cursor);
+
+    if (!eol)
+        return NULL;
+
+    gchar *line = g_strndup (reader->cursor, eol - reader->cursor);
+
+    reader->cursor = eol + 1;
+
+    return line;
+}
+
+static gchar *
+_g_paste_journal_reader_next_value (GPasteJournalReader *reader,
+                                    GPasteSpecialAtom   *mime)
+{
+    g_autofree gchar *line = _g_paste_journal_reader_next_line (reader);
+
+    if (!line)
+        return NULL;
+
+    g_auto (GStrv) fields = g_strsplit (line, " ", 2);
+
+    if (g_strv_length (fields) != 2)
+        return NULL;
+
+    guint64 length = g_ascii_strtoull (fields[1], NULL, 10);
+
+    if (length >= (guint64) (reader->end - reader->cursor) || reader->cursor[length] != '\n')
+        return NULL;
+
+    gchar *value = g_strndup (reader->cursor, length);
+
+    reader->cursor += length + 1;
+
+    if (mime)
+    {
+        GEnumValue *gev = g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_SPECIAL_ATOM), fields[0]);
+
+        *mime = (gev) ? gev->value : G_PASTE_SPECIAL_ATOM_INVALID;
+    }
+
+    return value;
+}
+
+/* by_uuid maps the uuid of each item of items to it, most records are about new items and don't need a scan */
+static gint64
+_g_paste_journal_backend_find (const GPtrArray  *items,
+                               GHashTable       *by_uuid,
+                               const gchar      *uuid)
+{
+    GPasteItem *item = g_hash_table_lookup (by_uuid, uuid);
+    guint index;
+
+    if (!item || !g_ptr_array_find (items, item, &index))
+        return -1;
+
+    return index;
+}
+
+static void
+_g_paste_journal_backend_insert (GPtrArray  *items,
+                                 GPasteItem *item,
+                                 guint64     index)
+{
+    g_ptr_array_insert (items, MIN (index, items->len), item);
+}
+
+static void
+_g_paste_journal_backend_remove (GPtrArray  *items,
+                                 GHashTable *by_uuid,
+                                 guint64     index)
+{
+    GPasteItem *item = g_ptr_array_steal_index (items, index);
+
+    g_hash_table_remove (by_uuid, g_paste_item_get_uuid (item));
+    g_object_unref (item);
+}
+
+static GPasteItem *
+_g_paste_journal_backend_read_add (GPasteJournalReader *reader,
+                                   gchar              **fields,
+                                   gboolean             images_support)
+{
+    const gchar *kind = fields[3];
+    const gchar *date = fields[4];
+    guint64 n_special_values = g_ascii_strtoull (fields[5], NULL, 10);
+    g_autofree gchar *value = _g_paste_journal_reader_next_value (reader, NULL);
+    GSList *special_values = NULL;
+    GPasteItem *item = NULL;
+
+    if (!value)
+        return NULL;
+
+    for (guint64 i = 0; i < n_special_values; ++i)
+    {
+        GPasteSpecialValue *sv = g_new (GPasteSpecialValue, 1);
+
+        sv->data = _g_paste_journal_reader_next_value (reader, &sv->mime);
+        if (!sv->data)
+        {
+            g_free (sv);
+            break;
+        }
+        special_values = g_slist_prepend (special_values, sv);
+    }
+
+    if (g_paste_str_equal (kind, "Text"))
+    {
+        item = g_paste_text_item_new (value);
+    }
+    else if (g_paste_str_equal (kind, "Uris"))
+    {
+        item = g_paste_uris_item_new (value);
+    }
+    else if (g_paste_str_equal (kind, "Image"))
+    {
+        if (images_support && !g_paste_str_equal (date, "-"))
+        {
+            g_autoptr (GDateTime) date_time = g_date_time_new_from_unix_local (g_ascii_strtoll (date,
+                                                                                                NULL, /* end */
+                                                                                                0)); /* base */
+            item = g_paste_image_item_new_from_file (value, date_time);
+        }
+    }
+    else
+    {
+        g_warning ("Unknown item kind in journal: %s", kind);
+    }
+
+    if (item && g_uuid_string_is_valid (fields[2]))
+        g_paste_item_set_uuid (item, fields[2]);
+
+    /* special_values is reversed, and adding them reverses it back */
+    for (GSList *sv = special_values; sv; sv = sv->next)
+    {
+        GPasteSpecialValue *v = sv->data;
+
+        if (item && v->mime != G_PASTE_SPECIAL_ATOM_INVALID)
+            g_paste_item_add_special_value (item, v);
+
+        g_free (v->data);
+        g_free (v);
+    }
+    g_slist_free (special_values);
+
+    return item;
+}
+
+/*
+ * Replays the journal records on top of items.
+ * Returns the number of records replayed.
+ */
+static guint64
+_g_paste_journal_backend_replay (GPtrArray   *items,
+                                 const gchar *journal,
+                                 gsize        length,
+                                 gboolean     images_support)
+{
+    GPasteJournalReader reader = { journal, journal + length };
+    /* uuid (owned by the item) -> item */
+    g_autoptr (GHashTable) by_uuid = g_hash_table_new (g_str_hash, g_str_equal);
+    guint64 count = 0;
+    gchar *line;
+
+    for (guint i = 0; i < items->len; ++i)
+    {
+        GPasteItem *item = g_ptr_array_index (items, i);
+
+        g_hash_table_insert (by_uuid, (gpointer) g_paste_item_get_uuid (item), item);
+    }
+
+    while ((line = _g_paste_journal_reader_next_line (&reader)))
+    {
+        g_autofree gchar *_line = line;
+        g_auto (GStrv) fields = g_strsplit (line, " ", 6);
+        guint n_fields = g_strv_length (fields);
+
+        if (g_paste_str_equal (fields[0], "+") && n_fields == 6)
+        {
+            GPasteItem *item = _g_paste_journal_backend_read_add (&reader, fields, images_support);
+            gint64 old = _g_paste_journal_backend_find (items, by_uuid, fields[2]);
+
+            if (old >= 0)
+                _g_paste_journal_backend_remove (items, by_uuid, old);
+            if (item)
+            {
+                _g_paste_journal_backend_insert (items, item, g_ascii_strtoull (fields[1], NULL, 10));
+                g_hash_table_insert (by_uuid, (gpointer) g_paste_item_get_uuid (item), item);
+            }
+        }
+        else if (g_paste_str_equal (fields[0], "-") && n_fields == 2)
+        {
+            gint64 old = _g_paste_journal_backend_find (items, by_uuid, fields[1]);
+
+            if (old >= 0)
+                _g_paste_journal_backend_remove (items, by_uuid, old);
+        }
+        else if (g_paste_str_equal (fields[0], ">") && n_fields == 3)
+        {
+            gint64 old = _g_paste_journal_backend_find (items, by_uuid, fields[2]);
+
+            if (old >= 0)
+                _g_paste_journal_backend_insert (items, g_ptr_array_steal_index (items, old), g_ascii_strtoull (fields[1], NULL, 10));
+        }
+        else
+        {
+            g_warning ("Invalid journal record, ignoring the rest of the journal");
+            break;
+        }
+
+        ++count;
+    }
+
+    return count;
+}
+
+/**********************/
+/* End Journal Reader */
+/**********************/
+
+static void
+g_paste_journal_state_set_uuids (GPasteJournalState *state,
+                                 const GPtrArray    *items)
+{
+    g_ptr_array_set_size (state->uuids, 0);
+
+    for (guint i = 0; i < items->len; ++i)
+        g_ptr_array_add (state->uuids, g_strdup (g_paste_item_get_uuid (g_ptr_array_index (items, i))));
+}
+
+/* Start tracking a new base for history_file_path */
+static GPasteJournalState *
+_g_paste_journal_backend_set_state (GPasteJournalBackendPrivate *priv,
+                                    const gchar                 *history_file_path,
+                                    const GPtrArray             *items,
+                                    guint64                      records,
+                                    goffset                      journal_size)
+{
+    GPasteJournalState *state = g_new0 (GPasteJournalState, 1);
+
+    state->uuids = g_ptr_array_new_full (items->len, g_free);
+    state->records = records;
+    state->journal_size = journal_size;
+    state->generation = priv->next_generation++;
+
+    g_paste_journal_state_set_uuids (state, items);
+
+    g_hash_table_insert (priv->states, g_strdup (history_file_path), state);
+
+    return state;
+}
+
+static GPtrArray *
+_g_paste_journal_backend_get_persisted_items (const GList *history)
+{
+    GPtrArray *items = g_ptr_array_new ();
+
+    for (; history; history = g_list_next (history))
+    {
+        GPasteItem *item = history->data;
+
+        /* Passwords are never saved, see GPasteFileBackend */
+        if (!_G_PASTE_IS_PASSWORD_ITEM (item))
+            g_ptr_array_add (items, item);
+    }
+
+    return items;
+}
+
+static void
+g_paste_journal_backend_full_write (const GPasteStorageBackend *self,
+                                    const gchar                *history_file_path,
+                                    const GList                *history)
+{
+    GPasteJournalBackendPrivate *priv = _g_paste_journal_backend_get_private (self);
+    g_autoptr (GPtrArray) items = _g_paste_journal_backend_get_persisted_items (history);
+    goffset journal_size;
+
+    G_PASTE_STORAGE_BACKEND_CLASS (g_paste_journal_backend_parent_class)->write_history_file (self, history_file_path, history);
+
+    if (_g_paste_journal_backend_reset_journal (history_file_path, NULL, 0, &journal_size))
+    {
+        _g_paste_journal_backend_set_state (priv, history_file_path, items, 0, journal_size);
+    }
+    else
+    {
+        _g_paste_journal_backend_delete_journal (history_file_path);
+        g_hash_table_remove (priv->states, history_file_path);
+    }
+}
+
+static void
+g_paste_journal_backend_compact_thread (GTask        *task,
+                                        gpointer      source_object,
+                                        gpointer      task_data,
+                                        GCancellable *cancellable G_GNUC_UNUSED)
+{
+    const GPasteJournalCompaction *compaction = task_data;
+    g_autofree gchar *compacted_path = _g_paste_journal_backend_get_compacted_path (compaction->path);
+
+    /* The new base is only put in place along with its journal, see compact_done */
+    g_unlink (compacted_path);
+    G_PASTE_STORAGE_BACKEND_CLASS (g_paste_journal_backend_parent_class)->write_history_file (source_object, compacted_path, compaction->history);
+
+    g_task_return_boolean (task, g_file_test (compacted_path, G_FILE_TEST_EXISTS));
+}
+
+static void
+g_paste_journal_backend_compact_done (GObject      *source_object,
+                                      GAsyncResult *res,
+                                      gpointer      user_data G_GNUC_UNUSED)
+{
+    GPasteStorageBackend *self = G_PASTE_STORAGE_BACKEND (source_object);
+    GPasteJournalBackendPrivate *priv = _g_paste_journal_backend_get_private (self);
+    const GPasteJournalCompaction *compaction = g_task_get_task_data (G_TASK (res));
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&priv->lock);
+    GPasteJournalState *state = g_hash_table_lookup (priv->states, compaction->path);
+    g_autofree gchar *compacted_path = _g_paste_journal_backend_get_compacted_path (compaction->path);
+
+    /* The history was entirely rewritten meanwhile */
+    if (!state || state->generation != compaction->generation)
+    {
+        g_unlink (compacted_path);
+        return;
+    }
+
+    state->compacting = FALSE;
+
+    if (!g_task_propagate_boolean (G_TASK (res), NULL /* error */))
+    {
+        g_warning ("Failed to compact history journal");
+        g_unlink (compacted_path);
+        return;
+    }
+
+    g_autofree gchar *journal_path = _g_paste_journal_backend_get_journal_path (compaction->path);
+    g_autofree gchar *next_journal_path = _g_paste_journal_backend_get_next_journal_path (compaction->path);
+    g_autofree gchar *journal = NULL;
+    gsize length;
+    goffset journal_size;
+
+    /* Only keep what was appended since the compaction started, nothing can be appended while we hold the lock */
+    if (!g_file_get_contents (journal_path, &journal, &length, NULL /* error */) || length < (gsize) compaction->journal_size ||
+        !_g_paste_journal_backend_write_journal (next_journal_path,
+                                                 compacted_path, /* renaming it keeps its size and mtime */
+                                                 journal + compaction->journal_size,
+                                                 length - compaction->journal_size,
+                                                 &journal_size))
+    {
+        g_debug ("journal: couldn't write the journal of the compacted history");
+        g_unlink (compacted_path);
+        return;
+    }
+
+    if (g_rename (compacted_path, compaction->path))
+    {
+        g_warning ("Failed to compact history journal");
+        g_unlink (next_journal_path);
+        g_unlink (compacted_path);
+        return;
+    }
+
+    /* Should we die right now, read_history_file picks up the next journal */
+    if (g_rename (next_journal_path, journal_path))
+    {
+        g_warning ("Failed to replace history journal, rewriting history on next save");
+        g_hash_table_remove (priv->states, compaction->path);
+        return;
+    }
+
+    state->journal_size = journal_size;
+    state->records -= compaction->records;
+}
+
+static void
+g_paste_journal_backend_compact (const GPasteStorageBackend *self,
+                                 const gchar                *history_file_path,
+                                 GPasteJournalState         *state,
+                                 const GPtrArray            *items)
+{
+    GPasteJournalCompaction *compaction = g_new0 (GPasteJournalCompaction, 1);
+
+    g_debug ("journal: compact '%s'", history_file_path);
+
+    compaction->path = g_strdup (history_file_path);
+    compaction->records = state->records;
+    compaction->journal_size = state->journal_size;
+    compaction->generation = state->generation;
+
+    /* Items are immutable as far as serialization is concerned, a ref is enough of a snapshot */
+    for (guint i = items->len; i > 0; --i)
+        compaction->history = g_list_prepend (compaction->history, g_object_ref (g_ptr_array_index (items, i - 1)));
+
+    state->compacting = TRUE;
+
+    g_autoptr (GTask) task = g_task_new ((gpointer) self,
+                                         NULL, /* cancellable */
+                                         g_paste_journal_backend_compact_done,
+                                         NULL); /* user_data */
+
+    g_task_set_task_data (task, compaction, g_paste_journal_compaction_free);
+    g_task_run_in_thread (task, g_paste_journal_backend_compact_thread);
+}
+
+static void
+g_paste_journal_backend_write_history_file (const GPasteStorageBackend *self,
+                                            const gchar                *history_file_path,
+                                            const GList                *history)
+{
+    const GPasteSettings *settings = _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->get_settings (self);
+    GPasteJournalBackendPrivate *priv = _g_paste_journal_backend_get_private (self);
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&priv->lock);
+
+    if (!g_paste_settings_get_save_history (settings))
+    {
+        G_PASTE_STORAGE_BACKEND_CLASS (g_paste_journal_backend_parent_class)->write_history_file (self, history_file_path, history);
+        _g_paste_journal_backend_delete_journal (history_file_path);
+        g_hash_table_remove (priv->states, history_file_path);
+        return;
+    }
+
+    GPasteJournalState *state = g_hash_table_lookup (priv->states, history_file_path);
+
+    if (!state || !g_file_test (history_file_path, G_FILE_TEST_EXISTS))
+    {
+        g_paste_journal_backend_full_write (self, history_file_path, history);
+        return;
+    }
+
+    g_autoptr (GPtrArray) items = _g_paste_journal_backend_get_persisted_items (history);
+    g_autoptr (GString) records = g_string_new (NULL);
+    guint64 count = _g_paste_journal_backend_diff (records, state->uuids, items);
+
+    if (!count)
+        return;
+
+    g_autofree gchar *journal_path = _g_paste_journal_backend_get_journal_path (history_file_path);
+    g_autoptr (GFile) journal = g_file_new_for_path (journal_path);
+    g_autoptr (GFileOutputStream) stream = g_file_append_to (journal,
+                                                             G_FILE_CREATE_NONE,
+                                                             NULL, /* cancellable */
+                                                             NULL); /* error */
+
+    if (!stream ||
+        !g_output_stream_write_all (G_OUTPUT_STREAM (stream), records->str, records->len, NULL, NULL /* cancellable */, NULL /* error */) ||
+        !g_output_stream_close (G_OUTPUT_STREAM (stream), NULL /* cancellable */, NULL /* error */))
+    {
+        g_warning ("Failed to append to history journal, rewriting history");
+        g_paste_journal_backend_full_write (self, history_file_path, history);
+        return;
+    }
+
+    g_paste_journal_state_set_uuids (state, items);
+    state->records += count;
+    state->journal_size += records->len;
+
+    if (!state->compacting && state->records > MAX (G_PASTE_JOURNAL_MIN_RECORDS, items->len))
+        g_paste_journal_backend_compact (self, history_file_path, state, items);
+}
+
+static void
+g_paste_journal_backend_read_history_file (const GPasteStorageBackend *self,
+                                           const gchar                *history_file_path,
+                                           GList                     **history,
+                                           gsize                      *size)
+{
+    const GPasteSettings *settings = _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->get_settings (self);
+    GPasteJournalBackendPrivate *priv = _g_paste_journal_backend_get_private (self);
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&priv->lock);
+    gboolean had_base = g_file_test (history_file_path, G_FILE_TEST_EXISTS);
+
+    G_PASTE_STORAGE_BACKEND_CLASS (g_paste_journal_backend_parent_class)->read_history_file (self, history_file_path, history, size);
+
+    g_autoptr (GPtrArray) items = g_ptr_array_new ();
+
+    for (GList *h = *history; h; h = g_list_next (h))
+        g_ptr_array_add (items, h->data);
+    g_clear_pointer (history, g_list_free);
+
+    g_autofree gchar *journal_path = _g_paste_journal_backend_get_journal_path (history_file_path);
+    g_autofree gchar *next_journal_path = _g_paste_journal_backend_get_next_journal_path (history_file_path);
+    g_autofree gchar *header = _g_paste_journal_backend_get_header (history_file_path);
+    g_autofree gchar *journal = NULL;
+    gsize length = 0;
+    guint64 records = 0;
+    gboolean valid = FALSE;
+
+    if (had_base && header)
+    {
+        if (g_file_get_contents (journal_path, &journal, &length, NULL /* error */) && g_str_has_prefix (journal, header))
+        {
+            valid = TRUE;
+        }
+        else
+        {
+            g_clear_pointer (&journal, g_free);
+
+            /* We died in the middle of putting a compacted base in place */
+            if (g_file_get_contents (next_journal_path, &journal, &length, NULL /* error */) && g_str_has_prefix (journal, header))
+                valid = !g_rename (next_journal_path, journal_path);
+        }
+    }
+
+    /* Either we just used it, or it belongs to a compaction that never made it */
+    g_unlink (next_journal_path);
+
+    if (valid)
+    {
+        gsize header_length = strlen (header);
+
+        records = _g_paste_journal_backend_replay (items,
+                                                   journal + header_length,
+                                                   length - header_length,
+                                                   g_paste_settings_get_images_support (settings));
+
+        guint64 max_history_size = g_paste_settings_get_max_history_size (settings);
+
+        while (items->len > max_history_size)
+            g_object_unref (g_ptr_array_steal_index (items, items->len - 1));
+    }
+    else
+    {
+        /* Missing, or written for another base: start a new one */
+        g_clear_pointer (&journal, g_free);
+        length = 0;
+    }
+
+    *size = 0;
+    for (guint i = items->len; i > 0; --i)
+    {
+        GPasteItem *item = g_ptr_array_index (items, i - 1);
+
+        *size += g_paste_item_get_size (item);
+        *history = g_list_prepend (*history, item);
+    }
+
+    if (journal)
+    {
+        GPasteJournalState *state = _g_paste_journal_backend_set_state (priv, history_file_path, items, records, length);
+
+        if (state->records > MAX (G_PASTE_JOURNAL_MIN_RECORDS, items->len))
+            g_paste_journal_backend_compact (self, history_file_path, state, items);
+    }
+    else if (g_paste_util_ensure_history_dir_exists (settings))
+    {
+        goffset journal_size;
+
+        if (_g_paste_journal_backend_reset_journal (history_file_path, NULL, 0, &journal_size))
+            _g_paste_journal_backend_set_state (priv, history_file_path, items, 0, journal_size);
+    }
+}
+
+static void
+g_paste_journal_backend_delete_history_file (const GPasteStorageBackend *self,
+                                             const gchar                *history_file_path,
+                                             GError                    **error)
+{
+    GPasteJournalBackendPrivate *priv = _g_paste_journal_backend_get_private (self);
+    g_autoptr (GMutexLocker) locker = g_mutex_locker_new (&priv->lock);
+    g_autofree gchar *next_journal_path = _g_paste_journal_backend_get_next_journal_path (history_file_path);
+    g_autofree gchar *compacted_path = _g_paste_journal_backend_get_compacted_path (history_file_path);
+
+    /* A compaction still running will notice the state is gone and throw its result away */
+    g_hash_table_remove (priv->states, history_file_path);
+    _g_paste_journal_backend_delete_journal (history_file_path);
+    g_unlink (next_journal_path);
+    g_unlink (compacted_path);
+
+    G_PASTE_STORAGE_BACKEND_CLASS (g_paste_journal_backend_parent_class)->delete_history_file (self, history_file_path, error);
+}
+
+static void
+g_paste_journal_backend_finalize (GObject *object)
+{
+    GPasteJournalBackendPrivate *priv = g_paste_journal_backend_get_instance_private (G_PASTE_JOURNAL_BACKEND (object));
+
+    g_hash_table_unref (priv->states);
+    g_mutex_clear (&priv->lock);
+
+    G_OBJECT_CLASS (g_paste_journal_backend_parent_class)->finalize (object);
+}
+
+static void
+g_paste_journal_backend_class_init (GPasteJournalBackendClass *klass)
+{
+    GPasteStorageBackendClass *storage_class = G_PASTE_STORAGE_BACKEND_CLASS (klass);
+
+    storage_class->read_history_file = g_paste_journal_backend_read_history_file;
+    storage_class->write_history_file = g_paste_journal_backend_write_history_file;
+    storage_class->delete_history_file = g_paste_journal_backend_delete_history_file;
+
+    G_OBJECT_CLASS (klass)->finalize = g_paste_journal_backend_finalize;
+}
+
+static void
+g_paste_journal_backend_init (GPasteJournalBackend *self)
+{
+    GPasteJournalBackendPrivate *priv = g_paste_journal_backend_get_instance_private (self);
+
+    g_mutex_init (&priv->lock);
+    priv->states = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_paste_journal_state_free);
+}
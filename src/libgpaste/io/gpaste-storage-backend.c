@@ -4,7 +4,11 @@
  * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
  */
 
+#include <gpaste-binary-backend.h>
 #include <gpaste-file-backend.h>
+#include <gpaste-history-catalog.h>
+#include <gpaste-history-index.h>
+#include <gpaste-journal-backend.h>
 #include <gpaste-util.h>
 
 typedef struct
@@ -64,6 +68,114 @@ g_paste_storage_backend_write_history (const GPasteStorageBackend *self,
     g_autofree gchar *history_file_path = _g_paste_storage_backend_get_history_file_path (self, name);
 
     _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->write_history_file (self, history_file_path, history);
+
+    const GPasteStorageBackendPrivate *priv = _g_paste_storage_backend_get_instance_private (self);
+
+    /* The search index is only written when we leave the history, see g_paste_storage_backend_index_history */
+    if (g_paste_settings_get_save_history (priv->settings))
+    {
+        g_paste_history_catalog_update (name, history_file_path, history);
+    }
+    else
+    {
+        g_paste_history_index_delete (name);
+        g_paste_history_catalog_remove (name);
+    }
+}
+
+/**
+ * g_paste_storage_backend_delete_history:
+ * @self: a #GPasteStorageBackend instance
+ * @name: the name of the history to delete
+ * @error: a #GError
+ *
+ * Delete a saved history along with everything we keep about it
+ */
+G_PASTE_VISIBLE void
+g_paste_storage_backend_delete_history (const GPasteStorageBackend *self,
+                                        const gchar                *name,
+                                        GError                    **error)
+{
+    g_return_if_fail (_G_PASTE_IS_STORAGE_BACKEND (self));
+    g_return_if_fail (name);
+    g_return_if_fail (!error || !(*error));
+
+    g_autofree gchar *history_file_path = _g_paste_storage_backend_get_history_file_path (self, name);
+
+    _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->delete_history_file (self, history_file_path, error);
+
+    g_paste_history_index_delete (name);
+    g_paste_history_catalog_remove (name);
+}
+
+/**
+ * g_paste_storage_backend_index_history:
+ * @self: a #GPasteStorageBackend instance
+ * @name: the name of the history
+ * @history: (element-type GPasteItem): the history, exactly as it was last saved
+ *
+ * Write the search index of a history we're done with, so that
+ * searching it doesn't have to load it first
+ */
+G_PASTE_VISIBLE void
+g_paste_storage_backend_index_history (const GPasteStorageBackend *self,
+                                       const gchar                *name,
+                                       const GList                *history)
+{
+    g_return_if_fail (_G_PASTE_IS_STORAGE_BACKEND (self));
+    g_return_if_fail (name);
+
+    const GPasteStorageBackendPrivate *priv = _g_paste_storage_backend_get_instance_private (self);
+
+    if (!g_paste_settings_get_save_history (priv->settings))
+        return;
+
+    g_autofree gchar *history_file_path = _g_paste_storage_backend_get_history_file_path (self, name);
+
+    if (!g_paste_history_index_is_up_to_date (name, history_file_path))
+        g_paste_history_index_write (name, history_file_path, history);
+}
+
+/**
+ * g_paste_storage_backend_search_history:
+ * @self: a #GPasteStorageBackend instance
+ * @name: the name of the history to search
+ * @pattern: the pattern to look for
+ * @error: a #GError
+ *
+ * Search a saved history through its search index, without loading it.
+ * The index is only rebuilt from the history when missing or outdated.
+ *
+ * Returns: (transfer full) (nullable): the uuids of the matching items
+ *          free it with g_strfreev
+ */
+G_PASTE_VISIBLE GStrv
+g_paste_storage_backend_search_history (const GPasteStorageBackend *self,
+                                        const gchar                *name,
+                                        const gchar                *pattern,
+                                        GError                    **error)
+{
+    g_return_val_if_fail (_G_PASTE_IS_STORAGE_BACKEND (self), NULL);
+    g_return_val_if_fail (name, NULL);
+    g_return_val_if_fail (pattern && g_utf8_validate (pattern, -1, NULL), NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    g_autofree gchar *history_file_path = _g_paste_storage_backend_get_history_file_path (self, name);
+
+    /* Histories saved before we had indexes, or modified by someone else */
+    if (!g_paste_history_index_is_up_to_date (name, history_file_path))
+    {
+        GList *history = NULL;
+        gsize size;
+
+        g_debug ("storage: index '%s'", name);
+
+        _G_PASTE_STORAGE_BACKEND_GET_CLASS (self)->read_history_file (self, history_file_path, &history, &size);
+        g_paste_history_index_write (name, history_file_path, history);
+        g_list_free_full (history, g_object_unref);
+    }
+
+    return g_paste_history_index_search (name, pattern, error);
 }
 
 static void
@@ -76,6 +188,22 @@ g_paste_storage_backend_dispose (GObject *object)
     G_OBJECT_CLASS (g_paste_storage_backend_parent_class)->dispose (object);
 }
 
+static void
+g_paste_storage_backend_delete_history_file (const GPasteStorageBackend *self G_GNUC_UNUSED,
+                                             const gchar                *history_file_path,
+                                             GError                    **error)
+{
+    g_autoptr (GFile) history_file = g_file_new_for_path (history_file_path);
+
+    if (g_file_query_exists (history_file,
+                             NULL)) /* cancellable */
+    {
+        g_file_delete (history_file,
+                       NULL, /* cancellable */
+                       error);
+    }
+}
+
 static const GPasteSettings *
 g_paste_storage_backend_get_settings (const GPasteStorageBackend *self)
 {
@@ -89,6 +217,7 @@ g_paste_storage_backend_class_init (GPasteStorageBackendClass *klass)
 {
     klass->read_history_file = NULL;
     klass->write_history_file = NULL;
+    klass->delete_history_file = g_paste_storage_backend_delete_history_file;
     klass->get_extension = NULL;
     klass->get_settings = g_paste_storage_backend_get_settings;
 
@@ -107,6 +236,10 @@ _g_paste_storage_backend_get_type (GPasteStorage storage_kind)
     {
     case G_PASTE_STORAGE_FILE:
         return G_PASTE_TYPE_FILE_BACKEND;
+    case G_PASTE_STORAGE_JOURNAL:
+        return G_PASTE_TYPE_JOURNAL_BACKEND;
+    case G_PASTE_STORAGE_BINARY:
+        return G_PASTE_TYPE_BINARY_BACKEND;
     default:
         return _g_paste_storage_backend_get_type (G_PASTE_STORAGE_DEFAULT);
     }
@@ -17,6 +17,8 @@ G_BEGIN_DECLS
 
 typedef enum {
     G_PASTE_STORAGE_FILE,
+    G_PASTE_STORAGE_JOURNAL,
+    G_PASTE_STORAGE_BINARY,
     G_PASTE_STORAGE_DEFAULT = G_PASTE_STORAGE_FILE
 } GPasteStorage;
 
@@ -37,18 +39,33 @@ struct _GPasteStorageBackendClass
                                 const gchar                *history_file_path,
                                 const GList                *history);
 
+    /*< virtual >*/
+    void (*delete_history_file) (const GPasteStorageBackend *self,
+                                 const gchar                *history_file_path,
+                                 GError                    **error);
+
     /*< protected >*/
     const gchar          *(*get_extension) (const GPasteStorageBackend *self);
     const GPasteSettings *(*get_settings)  (const GPasteStorageBackend *self);
 };
 
-void g_paste_storage_backend_read_history  (const GPasteStorageBackend *self,
-                                            const gchar                *name,
-                                            GList                     **history,
-                                            gsize                      *size);
-void g_paste_storage_backend_write_history (const GPasteStorageBackend *self,
-                                            const gchar                *name,
-                                            const GList                *history);
+void  g_paste_storage_backend_read_history   (const GPasteStorageBackend *self,
+                                              const gchar                *name,
+                                              GList                     **history,
+                                              gsize                      *size);
+void  g_paste_storage_backend_write_history  (const GPasteStorageBackend *self,
+                                              const gchar                *name,
+                                              const GList                *history);
+void  g_paste_storage_backend_delete_history (const GPasteStorageBackend *self,
+                                              const gchar                *name,
+                                              GError                    **error);
+void  g_paste_storage_backend_index_history  (const GPasteStorageBackend *self,
+                                              const gchar                *name,
+                                              const GList                *history);
+GStrv g_paste_storage_backend_search_history (const GPasteStorageBackend *self,
+                                              const gchar                *name,
+                                              const gchar                *pattern,
+                                              GError                    **error);
 
 GPasteStorageBackend *g_paste_storage_backend_new (GPasteStorage   storage_kind,
                                                    GPasteSettings *settings);
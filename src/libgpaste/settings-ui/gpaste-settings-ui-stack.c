@@ -41,6 +41,7 @@ typedef struct
     GtkSpinButton   *max_memory_usage_button;
     GtkSpinButton   *max_text_item_size_button;
     GtkSpinButton   *min_text_item_size_button;
+    GtkSpinButton   *save_delay_button;
     GtkEntry        *launch_ui_entry;
     GtkEntry        *make_password_entry;
     GtkEntry        *pop_entry;
@@ -190,6 +191,7 @@ UINT64_CALLBACK (max_history_size)
 UINT64_CALLBACK (max_memory_usage)
 UINT64_CALLBACK (max_text_item_size)
 UINT64_CALLBACK (min_text_item_size)
+UINT64_CALLBACK (save_delay)
 
 static GPasteSettingsUiPanel *
 g_paste_settings_ui_stack_private_make_history_settings_panel (GPasteSettingsUiStackPrivate *priv)
@@ -239,6 +241,13 @@ g_paste_settings_ui_stack_private_make_history_settings_panel (GPasteSettingsUiS
                                                                                    min_text_item_size_callback,
                                                                                    (GPasteResetCallback) g_paste_settings_reset_min_text_item_size,
                                                                                    settings);
+    priv->save_delay_button = g_paste_settings_ui_panel_add_range_setting (panel,
+                                                                           _("Delay before saving history (ms)"),
+                                                                           (gdouble) g_paste_settings_get_save_delay (settings),
+                                                                           0, 60000, 100,
+                                                                           save_delay_callback,
+                                                                           (GPasteResetCallback) g_paste_settings_reset_save_delay,
+                                                                           settings);
 
     return panel;
 }
@@ -369,6 +378,8 @@ g_paste_settings_ui_stack_settings_changed (GPasteSettings *settings,
         gtk_entry_set_text (priv->pop_entry, g_paste_settings_get_pop (settings));
     else if (g_paste_str_equal (key, G_PASTE_PRIMARY_TO_HISTORY_SETTING ))
         gtk_switch_set_active (GTK_SWITCH (priv->primary_to_history_switch), g_paste_settings_get_primary_to_history (settings));
+    else if (g_paste_str_equal (key, G_PASTE_SAVE_DELAY_SETTING))
+        gtk_spin_button_set_value (priv->save_delay_button, g_paste_settings_get_save_delay (settings));
     else if (g_paste_str_equal (key, G_PASTE_SAVE_HISTORY_SETTING))
         gtk_switch_set_active (GTK_SWITCH (priv->save_history_switch), g_paste_settings_get_save_history (settings));
     else if (g_paste_str_equal (key, G_PASTE_SHOW_HISTORY_SETTING))
@@ -44,6 +44,7 @@ typedef struct
     gchar     *pop;
     gboolean   primary_to_history;
     gboolean   rich_text_support;
+    guint64    save_delay;
     gboolean   save_history;
     gchar     *show_history;
     gchar     *sync_clipboard_to_primary;
@@ -498,6 +499,29 @@ BOOLEAN_SETTING (primary_to_history, PRIMARY_TO_HISTORY)
  */
 BOOLEAN_SETTING (rich_text_support, RICH_TEXT_SUPPORT)
 
+/**
+ * g_paste_settings_get_save_delay:
+ * @self: a #GPasteSettings instance
+ *
+ * Get the "save-delay" setting
+ *
+ * Returns: the value of the "save-delay" setting
+ */
+/**
+ * g_paste_settings_reset_save_delay:
+ * @self: a #GPasteSettings instance
+ *
+ * Reset the "save-delay" setting
+ */
+/**
+ * g_paste_settings_set_save_delay:
+ * @self: a #GPasteSettings instance
+ * @value: the delay (in milliseconds) during which history writes are coalesced
+ *
+ * Change the "save-delay" setting
+ */
+UNSIGNED_SETTING (save_delay, SAVE_DELAY)
+
 /**
  * g_paste_settings_get_save_history:
  * @self: a #GPasteSettings instance
@@ -865,6 +889,8 @@ g_paste_settings_settings_changed (GSettings   *settings G_GNUC_UNUSED,
         g_paste_settings_private_set_primary_to_history_from_dconf (priv);
     else if (g_paste_str_equal (key, G_PASTE_RICH_TEXT_SUPPORT_SETTING))
         g_paste_settings_private_set_rich_text_support_from_dconf (priv);
+    else if (g_paste_str_equal (key, G_PASTE_SAVE_DELAY_SETTING))
+        g_paste_settings_private_set_save_delay_from_dconf (priv);
     else if (g_paste_str_equal (key, G_PASTE_SAVE_HISTORY_SETTING))
         g_paste_settings_private_set_save_history_from_dconf (priv);
     else if (g_paste_str_equal (key, G_PASTE_SHOW_HISTORY_SETTING))
@@ -1053,6 +1079,7 @@ g_paste_settings_init (GPasteSettings *self)
     g_paste_settings_private_set_pop_from_dconf (priv);
     g_paste_settings_private_set_primary_to_history_from_dconf (priv);
     g_paste_settings_private_set_rich_text_support_from_dconf (priv);
+    g_paste_settings_private_set_save_delay_from_dconf (priv);
     g_paste_settings_private_set_save_history_from_dconf (priv);
     g_paste_settings_private_set_show_history_from_dconf (priv);
     g_paste_settings_private_set_sync_clipboard_to_primary_from_dconf (priv);
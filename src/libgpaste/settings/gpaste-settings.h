@@ -35,6 +35,7 @@ guint64      g_paste_settings_get_min_text_item_size         (const GPasteSettin
 const gchar *g_paste_settings_get_pop                        (const GPasteSettings *self);
 gboolean     g_paste_settings_get_primary_to_history         (const GPasteSettings *self);
 gboolean     g_paste_settings_get_rich_text_support          (const GPasteSettings *self);
+guint64      g_paste_settings_get_save_delay                 (const GPasteSettings *self);
 gboolean     g_paste_settings_get_save_history               (const GPasteSettings *self);
 const gchar *g_paste_settings_get_show_history               (const GPasteSettings *self);
 const gchar *g_paste_settings_get_sync_clipboard_to_primary  (const GPasteSettings *self);
@@ -61,6 +62,7 @@ void g_paste_settings_reset_min_text_item_size         (GPasteSettings *self);
 void g_paste_settings_reset_pop                        (GPasteSettings *self);
 void g_paste_settings_reset_primary_to_history         (GPasteSettings *self);
 void g_paste_settings_reset_rich_text_support          (GPasteSettings *self);
+void g_paste_settings_reset_save_delay                 (GPasteSettings *self);
 void g_paste_settings_reset_save_history               (GPasteSettings *self);
 void g_paste_settings_reset_show_history               (GPasteSettings *self);
 void g_paste_settings_reset_sync_clipboard_to_primary  (GPasteSettings *self);
@@ -103,6 +105,8 @@ void g_paste_settings_set_primary_to_history         (GPasteSettings *self,
                                                       gboolean        value);
 void g_paste_settings_set_rich_text_support          (GPasteSettings *self,
                                                       gboolean        value);
+void g_paste_settings_set_save_delay                 (GPasteSettings *self,
+                                                      guint64         value);
 void g_paste_settings_set_save_history               (GPasteSettings *self,
                                                       gboolean        value);
 void g_paste_settings_set_show_history               (GPasteSettings *self,
@@ -0,0 +1,189 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-replacer.h>
+
+#include <string.h>
+
+struct _GPasteReplacer
+{
+    GObject parent_instance;
+};
+
+typedef struct
+{
+    gchar *pattern;
+    gsize  pattern_length;
+    gchar *substitution;
+    gsize  substitution_length;
+} GPasteReplacement;
+
+typedef struct
+{
+    /* GPasteReplacement, by priority */
+    GArray  *replacements;
+    /* The first byte of each pattern, to skip to the next candidate with strcspn */
+    GString *first_bytes;
+} GPasteReplacerPrivate;
+
+G_PASTE_DEFINE_TYPE_WITH_PRIVATE (Replacer, replacer, G_TYPE_OBJECT)
+
+static void
+g_paste_replacement_clear (gpointer data)
+{
+    GPasteReplacement *replacement = data;
+
+    g_free (replacement->pattern);
+    g_free (replacement->substitution);
+}
+
+/**
+ * g_paste_replacer_add:
+ * @self: a #GPasteReplacer instance
+ * @pattern: the literal text to replace
+ * @substitution: the replacement text
+ *
+ * Add a pattern to replace. When several patterns match at the
+ * same position, the first one added wins.
+ * All the patterns must be added before using the #GPasteReplacer.
+ */
+G_PASTE_VISIBLE void
+g_paste_replacer_add (GPasteReplacer *self,
+                      const gchar    *pattern,
+                      const gchar    *substitution)
+{
+    g_return_if_fail (_G_PASTE_IS_REPLACER (self));
+    g_return_if_fail (pattern && *pattern);
+    g_return_if_fail (substitution);
+
+    GPasteReplacerPrivate *priv = g_paste_replacer_get_instance_private (self);
+    GPasteReplacement replacement = {
+        g_strdup (pattern),
+        strlen (pattern),
+        g_strdup (substitution),
+        strlen (substitution)
+    };
+
+    g_array_append_val (priv->replacements, replacement);
+
+    if (!strchr (priv->first_bytes->str, *pattern))
+        g_string_append_c (priv->first_bytes, *pattern);
+}
+
+static const GPasteReplacement *
+g_paste_replacer_private_match (const GPasteReplacerPrivate *priv,
+                                const gchar                 *text)
+{
+    for (guint i = 0; i < priv->replacements->len; ++i)
+    {
+        const GPasteReplacement *replacement = &g_array_index (priv->replacements, GPasteReplacement, i);
+
+        /* text is NUL-terminated, strncmp won't read past its end */
+        if (!strncmp (text, replacement->pattern, replacement->pattern_length))
+            return replacement;
+    }
+
+    return NULL;
+}
+
+/**
+ * g_paste_replacer_replace:
+ * @self: a #GPasteReplacer instance
+ * @text: the initial text
+ *
+ * Replace all the occurrences of the patterns in one pass
+ *
+ * Returns: the newly allocated string
+ */
+G_PASTE_VISIBLE gchar *
+g_paste_replacer_replace (const GPasteReplacer *self,
+                          const gchar          *text)
+{
+    g_return_val_if_fail (_G_PASTE_IS_REPLACER (self), NULL);
+    g_return_val_if_fail (text, NULL);
+
+    const GPasteReplacerPrivate *priv = _g_paste_replacer_get_instance_private (self);
+    const gchar *first_bytes = priv->first_bytes->str;
+    gsize span = strcspn (text, first_bytes);
+
+    /* Nothing to replace */
+    if (!text[span])
+        return g_strdup (text);
+
+    GString *result = g_string_sized_new (span + strlen (text + span));
+
+    for (;;)
+    {
+        g_string_append_len (result, text, span);
+        text += span;
+
+        if (!*text)
+            break;
+
+        const GPasteReplacement *replacement = g_paste_replacer_private_match (priv, text);
+
+        if (replacement)
+        {
+            g_string_append_len (result, replacement->substitution, replacement->substitution_length);
+            text += replacement->pattern_length;
+        }
+        else
+        {
+            g_string_append_c (result, *text);
+            ++text;
+        }
+
+        span = strcspn (text, first_bytes);
+    }
+
+    return g_string_free (result, FALSE);
+}
+
+static void
+g_paste_replacer_finalize (GObject *object)
+{
+    const GPasteReplacerPrivate *priv = _g_paste_replacer_get_instance_private (G_PASTE_REPLACER (object));
+
+    g_array_unref (priv->replacements);
+    g_string_free (priv->first_bytes, TRUE);
+
+    G_OBJECT_CLASS (g_paste_replacer_parent_class)->finalize (object);
+}
+
+static void
+g_paste_replacer_class_init (GPasteReplacerClass *klass)
+{
+    G_OBJECT_CLASS (klass)->finalize = g_paste_replacer_finalize;
+}
+
+static void
+g_paste_replacer_init (GPasteReplacer *self)
+{
+    GPasteReplacerPrivate *priv = g_paste_replacer_get_instance_private (self);
+
+    priv->replacements = g_array_new (FALSE, /* zero-terminated */
+                                      FALSE, /* clear */
+                                      sizeof (GPasteReplacement));
+    g_array_set_clear_func (priv->replacements, g_paste_replacement_clear);
+    priv->first_bytes = g_string_new (NULL);
+}
+
+/**
+ * g_paste_replacer_new:
+ *
+ * Create a new instance of #GPasteReplacer, to replace several
+ * literal patterns at once. The patterns are only processed once,
+ * so keep it around to replace in many texts.
+ * Once all its patterns are added, it can be shared between threads.
+ *
+ * Returns: a newly allocated #GPasteReplacer
+ *          free it with g_object_unref
+ */
+G_PASTE_VISIBLE GPasteReplacer *
+g_paste_replacer_new (void)
+{
+    return g_object_new (G_PASTE_TYPE_REPLACER, NULL);
+}
@@ -0,0 +1,32 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_REPLACER_H__
+#define __G_PASTE_REPLACER_H__
+
+#include <gpaste-macros.h>
+
+G_BEGIN_DECLS
+
+#define G_PASTE_TYPE_REPLACER (g_paste_replacer_get_type ())
+
+G_PASTE_FINAL_TYPE (Replacer, replacer, REPLACER, GObject)
+
+void   g_paste_replacer_add     (GPasteReplacer       *self,
+                                 const gchar          *pattern,
+                                 const gchar          *substitution);
+gchar *g_paste_replacer_replace (const GPasteReplacer *self,
+                                 const gchar          *text);
+
+GPasteReplacer *g_paste_replacer_new (void);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_REPLACER_H__*/
@@ -0,0 +1,313 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste-search-index.h>
+
+struct _GPasteSearchIndex
+{
+    GObject parent_instance;
+};
+
+typedef struct
+{
+    /* trigram -> set of handles */
+    GHashTable *postings;
+    /* handle -> GArray of its distinct trigrams, to unindex it */
+    GHashTable *handles;
+} GPasteSearchIndexPrivate;
+
+G_PASTE_DEFINE_TYPE_WITH_PRIVATE (SearchIndex, search_index, G_TYPE_OBJECT)
+
+/*
+ * Trigrams are made of case folded characters, packed in a guint32.
+ * Only ASCII characters are indexed, anything else breaks the trigrams,
+ * so that the index never misses a caseless match.
+ */
+static guchar
+g_paste_search_index_fold (gunichar c)
+{
+    if (c < 0x80)
+        return g_ascii_tolower (c);
+
+    /* The only non-ASCII characters caselessly matching ASCII ones */
+    switch (c)
+    {
+    case 0x017F: /* LATIN SMALL LETTER LONG S */
+        return 's';
+    case 0x212A: /* KELVIN SIGN */
+        return 'k';
+    default:
+        return 0;
+    }
+}
+
+static gint
+g_paste_search_index_compare_trigrams (gconstpointer a,
+                                       gconstpointer b)
+{
+    guint32 _a = *((const guint32 *) a);
+    guint32 _b = *((const guint32 *) b);
+
+    return (_a > _b) - (_a < _b);
+}
+
+/**
+ * g_paste_search_index_get_trigrams:
+ * @text: the text to split
+ *
+ * Get the trigrams the index uses for @text, so that they can be persisted
+ *
+ * Returns: (transfer full) (element-type guint32): the sorted distinct trigrams
+ *          free it with g_array_unref
+ */
+G_PASTE_VISIBLE GArray *
+g_paste_search_index_get_trigrams (const gchar *text)
+{
+    g_return_val_if_fail (text, NULL);
+
+    GArray *trigrams = g_array_new (FALSE, /* zero-terminated */
+                                    FALSE, /* clear */
+                                    sizeof (guint32));
+    guint32 trigram = 0;
+    guint run = 0;
+
+    while (*text)
+    {
+        gunichar c = g_utf8_get_char_validated (text, -1);
+        guchar folded;
+
+        if (c == (gunichar) -1 || c == (gunichar) -2)
+        {
+            /* Invalid UTF-8 never matches a regex, just skip that byte */
+            folded = 0;
+            ++text;
+        }
+        else
+        {
+            folded = g_paste_search_index_fold (c);
+            text = g_utf8_next_char (text);
+        }
+
+        if (!folded)
+        {
+            run = 0;
+            continue;
+        }
+
+        trigram = ((trigram << 8) | folded) & 0xFFFFFF;
+        if (++run >= 3)
+            g_array_append_val (trigrams, trigram);
+    }
+
+    if (trigrams->len > 1)
+    {
+        guint32 *data = (guint32 *) (gpointer) trigrams->data;
+        guint len = 1;
+
+        g_array_sort (trigrams, g_paste_search_index_compare_trigrams);
+        for (guint i = 1; i < trigrams->len; ++i)
+        {
+            if (data[i] != data[len - 1])
+                data[len++] = data[i];
+        }
+        g_array_set_size (trigrams, len);
+    }
+
+    return trigrams;
+}
+
+/**
+ * g_paste_search_index_add:
+ * @self: a #GPasteSearchIndex instance
+ * @handle: the handle to return when @text matches
+ * @text: the text to index
+ *
+ * Index @text under @handle, replacing what was previously indexed for it
+ */
+G_PASTE_VISIBLE void
+g_paste_search_index_add (GPasteSearchIndex *self,
+                          gconstpointer      handle,
+                          const gchar       *text)
+{
+    g_return_if_fail (_G_PASTE_IS_SEARCH_INDEX (self));
+    g_return_if_fail (text);
+
+    GPasteSearchIndexPrivate *priv = g_paste_search_index_get_instance_private (self);
+
+    g_paste_search_index_remove (self, handle);
+
+    GArray *trigrams = g_paste_search_index_get_trigrams (text);
+
+    for (guint i = 0; i < trigrams->len; ++i)
+    {
+        gpointer trigram = GUINT_TO_POINTER (g_array_index (trigrams, guint32, i));
+        GHashTable *posting = g_hash_table_lookup (priv->postings, trigram);
+
+        if (!posting)
+        {
+            posting = g_hash_table_new (NULL, NULL);
+            g_hash_table_insert (priv->postings, trigram, posting);
+        }
+
+        g_hash_table_add (posting, (gpointer) handle);
+    }
+
+    g_hash_table_insert (priv->handles, (gpointer) handle, trigrams);
+}
+
+/**
+ * g_paste_search_index_remove:
+ * @self: a #GPasteSearchIndex instance
+ * @handle: the handle to forget
+ *
+ * Remove everything indexed under @handle
+ */
+G_PASTE_VISIBLE void
+g_paste_search_index_remove (GPasteSearchIndex *self,
+                             gconstpointer      handle)
+{
+    g_return_if_fail (_G_PASTE_IS_SEARCH_INDEX (self));
+
+    GPasteSearchIndexPrivate *priv = g_paste_search_index_get_instance_private (self);
+    const GArray *trigrams = g_hash_table_lookup (priv->handles, handle);
+
+    if (!trigrams)
+        return;
+
+    for (guint i = 0; i < trigrams->len; ++i)
+    {
+        gpointer trigram = GUINT_TO_POINTER (g_array_index (trigrams, guint32, i));
+        GHashTable *posting = g_hash_table_lookup (priv->postings, trigram);
+
+        if (posting && g_hash_table_remove (posting, handle) && !g_hash_table_size (posting))
+            g_hash_table_remove (priv->postings, trigram);
+    }
+
+    g_hash_table_remove (priv->handles, handle);
+}
+
+/**
+ * g_paste_search_index_clear:
+ * @self: a #GPasteSearchIndex instance
+ *
+ * Remove everything from the index
+ */
+G_PASTE_VISIBLE void
+g_paste_search_index_clear (GPasteSearchIndex *self)
+{
+    g_return_if_fail (_G_PASTE_IS_SEARCH_INDEX (self));
+
+    GPasteSearchIndexPrivate *priv = g_paste_search_index_get_instance_private (self);
+
+    g_hash_table_remove_all (priv->postings);
+    g_hash_table_remove_all (priv->handles);
+}
+
+/**
+ * g_paste_search_index_lookup:
+ * @self: a #GPasteSearchIndex instance
+ * @literal: the text to look for, compared caselessly
+ *
+ * Get the handles of the texts which may contain @literal.
+ * Those are only candidates, the caller still has to check them.
+ *
+ * Returns: (transfer full) (nullable): the unordered candidates,
+ *          or %NULL if @literal is too short for the index to help
+ *          free it with g_ptr_array_unref
+ */
+G_PASTE_VISIBLE GPtrArray *
+g_paste_search_index_lookup (const GPasteSearchIndex *self,
+                             const gchar             *literal)
+{
+    g_return_val_if_fail (_G_PASTE_IS_SEARCH_INDEX (self), NULL);
+    g_return_val_if_fail (literal, NULL);
+
+    const GPasteSearchIndexPrivate *priv = _g_paste_search_index_get_instance_private (self);
+    g_autoptr (GArray) trigrams = g_paste_search_index_get_trigrams (literal);
+
+    if (!trigrams->len)
+        return NULL;
+
+    g_autoptr (GPtrArray) postings = g_ptr_array_sized_new (trigrams->len);
+    GHashTable *smallest = NULL;
+
+    for (guint i = 0; i < trigrams->len; ++i)
+    {
+        GHashTable *posting = g_hash_table_lookup (priv->postings, GUINT_TO_POINTER (g_array_index (trigrams, guint32, i)));
+
+        /* One of the trigrams is nowhere to be found */
+        if (!posting)
+            return g_ptr_array_new ();
+
+        g_ptr_array_add (postings, posting);
+        if (!smallest || g_hash_table_size (posting) < g_hash_table_size (smallest))
+            smallest = posting;
+    }
+
+    GPtrArray *candidates = g_ptr_array_sized_new (g_hash_table_size (smallest));
+    GHashTableIter iter;
+    gpointer handle;
+
+    g_hash_table_iter_init (&iter, smallest);
+    while (g_hash_table_iter_next (&iter, &handle, NULL))
+    {
+        gboolean everywhere = TRUE;
+
+        for (guint i = 0; everywhere && i < postings->len; ++i)
+        {
+            GHashTable *posting = g_ptr_array_index (postings, i);
+
+            if (posting != smallest)
+                everywhere = g_hash_table_contains (posting, handle);
+        }
+
+        if (everywhere)
+            g_ptr_array_add (candidates, handle);
+    }
+
+    return candidates;
+}
+
+static void
+g_paste_search_index_finalize (GObject *object)
+{
+    const GPasteSearchIndexPrivate *priv = _g_paste_search_index_get_instance_private (G_PASTE_SEARCH_INDEX (object));
+
+    g_hash_table_unref (priv->postings);
+    g_hash_table_unref (priv->handles);
+
+    G_OBJECT_CLASS (g_paste_search_index_parent_class)->finalize (object);
+}
+
+static void
+g_paste_search_index_class_init (GPasteSearchIndexClass *klass)
+{
+    G_OBJECT_CLASS (klass)->finalize = g_paste_search_index_finalize;
+}
+
+static void
+g_paste_search_index_init (GPasteSearchIndex *self)
+{
+    GPasteSearchIndexPrivate *priv = g_paste_search_index_get_instance_private (self);
+
+    priv->postings = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_hash_table_unref);
+    priv->handles = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+}
+
+/**
+ * g_paste_search_index_new:
+ *
+ * Create a new instance of #GPasteSearchIndex, a trigram index
+ * to quickly find the texts containing a literal
+ *
+ * Returns: a newly allocated #GPasteSearchIndex
+ *          free it with g_object_unref
+ */
+G_PASTE_VISIBLE GPasteSearchIndex *
+g_paste_search_index_new (void)
+{
+    return g_object_new (G_PASTE_TYPE_SEARCH_INDEX, NULL);
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#if !defined (__G_PASTE_H_INSIDE__) && !defined (G_PASTE_COMPILATION)
+#error "Only <gpaste.h> can be included directly."
+#endif
+
+#ifndef __G_PASTE_SEARCH_INDEX_H__
+#define __G_PASTE_SEARCH_INDEX_H__
+
+#include <gpaste-macros.h>
+
+G_BEGIN_DECLS
+
+#define G_PASTE_TYPE_SEARCH_INDEX (g_paste_search_index_get_type ())
+
+G_PASTE_FINAL_TYPE (SearchIndex, search_index, SEARCH_INDEX, GObject)
+
+void       g_paste_search_index_add    (GPasteSearchIndex       *self,
+                                        gconstpointer            handle,
+                                        const gchar             *text);
+void       g_paste_search_index_remove (GPasteSearchIndex       *self,
+                                        gconstpointer            handle);
+void       g_paste_search_index_clear  (GPasteSearchIndex       *self);
+GPtrArray *g_paste_search_index_lookup (const GPasteSearchIndex *self,
+                                        const gchar             *literal);
+
+GArray *g_paste_search_index_get_trigrams (const gchar *text);
+
+GPasteSearchIndex *g_paste_search_index_new (void);
+
+G_END_DECLS
+
+#endif /*__G_PASTE_SEARCH_INDEX_H__*/
@@ -4,11 +4,26 @@
  * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
  */
 
+/* For memfd_create and file sealing */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 #include <gpaste-gsettings-keys.h>
+#include <gpaste-replacer.h>
 #include <gpaste-util.h>
 
 #include "gpaste-gtk-compat.h"
 
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 /**
  * g_paste_util_confirm_dialog:
  * @parent: (nullable): the parent #GtkWindow
@@ -344,6 +359,7 @@ g_paste_util_empty_with_confirmation_sync (GPasteClient         *client,
  * @substitution: the replacement text
  *
  * Replace some text
+ * Use a #GPasteReplacer instead to replace in many texts
  *
  * Returns: the newly allocated string
  */
@@ -356,18 +372,14 @@ g_paste_util_replace (const gchar *text,
     g_return_val_if_fail (g_utf8_validate (pattern, -1, NULL), NULL);
     g_return_val_if_fail (g_utf8_validate (substitution, -1, NULL), NULL);
 
-    g_autofree gchar *regex_string = g_regex_escape_string (pattern, -1);
-    g_autoptr (GRegex) regex = g_regex_new (regex_string,
-                                            0, /* Compile options */
-                                            0, /* Match options */
-                                            NULL); /* Error */
-    return g_regex_replace_literal (regex,
-                                    text,
-                                    (gssize) -1,
-                                    0, /* Start position */
-                                    substitution,
-                                    0, /* Match options */
-                                    NULL); /* Error */
+    if (!*pattern)
+        return g_strdup (text);
+
+    g_autoptr (GPasteReplacer) replacer = g_paste_replacer_new ();
+
+    g_paste_replacer_add (replacer, pattern, substitution);
+
+    return g_paste_replacer_replace (replacer, text);
 }
 
 /**
@@ -515,6 +527,392 @@ g_paste_util_get_dbus_items_result (GVariant *variant)
     return items;
 }
 
+/**
+ * g_paste_util_get_dbus_history_matches_result:
+ * @variant: a #GVariant
+ *
+ * Get the "a(ss)" GVariant of (history name, uuid) pairs as a list of items,
+ * the value of each one being the name of its history
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_util_get_dbus_history_matches_result (GVariant *variant)
+{
+    GList *items = NULL;
+    GVariantIter iter;
+    const gchar *name, *uuid;
+
+    g_variant_iter_init (&iter, variant);
+    while (g_variant_iter_next (&iter, "(&s&s)", &name, &uuid))
+        items = g_list_prepend (items, g_paste_client_item_new (uuid, name));
+
+    return g_list_reverse (items);
+}
+
+/**
+ * g_paste_util_get_dbus_preview_result:
+ * @variant: a #GVariant
+ *
+ * Get the "(sss)" GVariant (uuid, kind, preview) as an item
+ *
+ * Returns: (transfer full): The item
+ */
+G_PASTE_VISIBLE GPasteClientItem *
+g_paste_util_get_dbus_preview_result (GVariant *variant)
+{
+    const gchar *uuid, *kind, *preview;
+
+    g_variant_get (variant, "(&s&s&s)", &uuid, &kind, &preview);
+
+    GEnumValue *k = g_enum_get_value_by_nick (g_type_class_peek (G_PASTE_TYPE_ITEM_KIND), kind);
+
+    return g_paste_client_item_new_with_kind (uuid, (k) ? (GPasteItemKind) k->value : G_PASTE_ITEM_KIND_INVALID, preview);
+}
+
+/**
+ * g_paste_util_get_dbus_previews_result:
+ * @variant: a #GVariant
+ *
+ * Get the "a(sss)" GVariant as a list of items holding previews
+ *
+ * Returns: (element-type GPasteClientItem) (transfer full): The items
+ */
+G_PASTE_VISIBLE GList *
+g_paste_util_get_dbus_previews_result (GVariant *variant)
+{
+    GList *items = NULL;
+    GVariantIter iter;
+    GVariant *v;
+
+    g_variant_iter_init (&iter, variant);
+    while ((v = g_variant_iter_next_value (&iter)))
+    {
+        items = g_list_prepend (items, g_paste_util_get_dbus_preview_result (v));
+        g_variant_unref (v);
+    }
+
+    return g_list_reverse (items);
+}
+
+/**
+ * g_paste_util_get_dbus_changes_result:
+ * @variant: a #GVariant
+ * @seq: (out) (optional): the sequence number
+ *
+ * Split the "(ta(sttsss))" GVariant into the sequence number and the changes
+ *
+ * Returns: (transfer full): The "a(sttsss)" changes
+ */
+G_PASTE_VISIBLE GVariant *
+g_paste_util_get_dbus_changes_result (GVariant *variant,
+                                      guint64  *seq)
+{
+    if (seq)
+    {
+        g_autoptr (GVariant) v = g_variant_get_child_value (variant, 0);
+
+        *seq = g_variant_get_uint64 (v);
+    }
+
+    return g_variant_get_child_value (variant, 1);
+}
+
+static void
+g_paste_util_set_errno_error (GError     **error,
+                              const gchar *what)
+{
+    gint saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno), "%s: %s", what, g_strerror (saved_errno));
+}
+
+static gboolean
+g_paste_util_write_all (gint          fd,
+                        gconstpointer data,
+                        gsize         length,
+                        GError      **error)
+{
+    const gchar *cursor = data;
+
+    while (length)
+    {
+        gssize written = write (fd, cursor, length);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            g_paste_util_set_errno_error (error, "write");
+            return FALSE;
+        }
+
+        cursor += written;
+        length -= written;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+g_paste_util_memfd_seal (gint     fd,
+                         GError **error)
+{
+    if (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0 ||
+        lseek (fd, 0, SEEK_SET) < 0)
+    {
+        g_paste_util_set_errno_error (error, "memfd seal");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * g_paste_util_memfd_new:
+ * @name: the name of the memfd, only used for debugging
+ * @data: (array length=length): the data to put in the memfd
+ * @length: the length of @data
+ * @error: a #GError
+ *
+ * Put @data in a new memfd, sealed so that whoever we send it
+ * to over D-Bus can safely map it
+ *
+ * Returns: the file descriptor, or -1 on error
+ */
+G_PASTE_VISIBLE gint
+g_paste_util_memfd_new (const gchar  *name,
+                        gconstpointer data,
+                        gsize         length,
+                        GError      **error)
+{
+    g_return_val_if_fail (name, -1);
+    g_return_val_if_fail (data || !length, -1);
+    g_return_val_if_fail (!error || !(*error), -1);
+
+    gint fd = memfd_create (name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+    if (fd < 0)
+    {
+        g_paste_util_set_errno_error (error, "memfd_create");
+        return -1;
+    }
+
+    if (!g_paste_util_write_all (fd, data, length, error) ||
+        !g_paste_util_memfd_seal (fd, error))
+    {
+        g_close (fd, NULL);
+        return -1;
+    }
+
+    return fd;
+}
+
+static gboolean
+g_paste_util_memfd_fill (gint     memfd,
+                         gint     fd,
+                         gsize    max_length,
+                         gsize   *length,
+                         GError **error)
+{
+    gboolean can_splice = TRUE;
+    guint8 buffer[65536];
+
+    *length = 0;
+
+    for (;;)
+    {
+        /* Ask for one byte more than allowed to know when there's too much */
+        gsize left = max_length - *length;
+        gsize wanted = (left < sizeof (buffer)) ? left + 1 : sizeof (buffer);
+        gssize r;
+
+        if (can_splice)
+        {
+            /* Let the kernel move the pages from the pipe itself */
+            r = splice (fd, NULL, memfd, NULL, wanted, SPLICE_F_MOVE);
+
+            if (r < 0 && errno == EINVAL)
+            {
+                /* Not a pipe, fall back to copying */
+                can_splice = FALSE;
+                continue;
+            }
+        }
+        else
+        {
+            r = read (fd, buffer, wanted);
+
+            if (r > 0 && !g_paste_util_write_all (memfd, buffer, r, error))
+                return FALSE;
+        }
+
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            g_paste_util_set_errno_error (error, (can_splice) ? "splice" : "read");
+            return FALSE;
+        }
+
+        if (!r)
+            return TRUE;
+
+        *length += r;
+
+        if (*length > max_length)
+        {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE, "the contents are larger than %" G_GSIZE_FORMAT " bytes", max_length);
+            return FALSE;
+        }
+    }
+}
+
+/**
+ * g_paste_util_memfd_new_from_fd:
+ * @name: the name of the memfd, only used for debugging
+ * @fd: the file descriptor to read, typically a pipe
+ * @max_length: the maximum size we accept
+ * @length: (out) (optional): the length of the contents
+ * @error: a #GError
+ *
+ * Move everything that can be read from @fd into a new memfd, sealed
+ * like the ones g_paste_util_memfd_new creates. Pipes are spliced so
+ * their contents are never copied to userspace, and we give up as soon
+ * as more than @max_length bytes have been read.
+ *
+ * Returns: the file descriptor, or -1 on error
+ */
+G_PASTE_VISIBLE gint
+g_paste_util_memfd_new_from_fd (const gchar *name,
+                                gint         fd,
+                                gsize        max_length,
+                                gsize       *length,
+                                GError     **error)
+{
+    g_return_val_if_fail (name, -1);
+    g_return_val_if_fail (fd >= 0, -1);
+    g_return_val_if_fail (!error || !(*error), -1);
+
+    gint memfd = memfd_create (name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    gsize _length;
+
+    if (memfd < 0)
+    {
+        g_paste_util_set_errno_error (error, "memfd_create");
+        return -1;
+    }
+
+    if (!g_paste_util_memfd_fill (memfd, fd, max_length, &_length, error) ||
+        !g_paste_util_memfd_seal (memfd, error))
+    {
+        g_close (memfd, NULL);
+        return -1;
+    }
+
+    if (length)
+        *length = _length;
+
+    return memfd;
+}
+
+/**
+ * g_paste_util_memfd_read:
+ * @fd: the file descriptor we've been sent
+ * @max_length: the maximum size we accept
+ * @error: a #GError
+ *
+ * Get the contents of a memfd, mapping it if it has been sealed
+ * against any resizing or writing like g_paste_util_memfd_new does,
+ * reading it otherwise as nothing prevents it from changing under our feet
+ *
+ * Returns: (transfer full) (nullable): the contents, which are not nul-terminated
+ */
+G_PASTE_VISIBLE GBytes *
+g_paste_util_memfd_read (gint     fd,
+                         gsize    max_length,
+                         GError **error)
+{
+    g_return_val_if_fail (fd >= 0, NULL);
+    g_return_val_if_fail (!error || !(*error), NULL);
+
+    struct stat st;
+
+    if (fstat (fd, &st) < 0)
+    {
+        g_paste_util_set_errno_error (error, "fstat");
+        return NULL;
+    }
+
+    /* Reading a pipe could block us until whoever sent it decides to close it */
+    if (!S_ISREG (st.st_mode))
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_REGULAR_FILE, "only memfds and regular files can be read");
+        return NULL;
+    }
+
+    if ((guint64) st.st_size > max_length)
+    {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE, "the contents are larger than %" G_GSIZE_FORMAT " bytes", max_length);
+        return NULL;
+    }
+
+    gint seals = fcntl (fd, F_GET_SEALS);
+    const gint needed_seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+    /* Without F_SEAL_GROW, it could have grown past max_length since we checked */
+    if (seals >= 0 && (seals & needed_seals) == needed_seals)
+    {
+        if (!st.st_size)
+            return g_bytes_new (NULL, 0);
+
+        g_autoptr (GMappedFile) file = g_mapped_file_new_from_fd (fd, FALSE, error);
+
+        if (!file)
+            return NULL;
+
+        if (g_mapped_file_get_length (file) > max_length)
+        {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE, "the contents are larger than %" G_GSIZE_FORMAT " bytes", max_length);
+            return NULL;
+        }
+
+        return g_mapped_file_get_bytes (file);
+    }
+
+    g_autoptr (GByteArray) contents = g_byte_array_new ();
+    guint8 buffer[65536];
+
+    for (;;)
+    {
+        gssize r = read (fd, buffer, sizeof (buffer));
+
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            g_paste_util_set_errno_error (error, "read");
+            return NULL;
+        }
+
+        if (!r)
+            break;
+
+        if (contents->len + r > max_length)
+        {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE, "the contents are larger than %" G_GSIZE_FORMAT " bytes", max_length);
+            return NULL;
+        }
+
+        g_byte_array_append (contents, buffer, r);
+    }
+
+    return g_byte_array_free_to_bytes (g_steal_pointer (&contents));
+}
+
 static gchar *
 g_paste_util_get_runtime_dir (const gchar *component)
 {
@@ -584,9 +982,39 @@ g_paste_util_xml_decode (const gchar *text)
 {
     g_return_val_if_fail (text, NULL);
 
-    g_autofree gchar *_decoded_text = g_paste_util_replace (text, "&gt;", ">");
+    gsize length = strlen (text);
+    const gchar *end = text + length;
+    /* Decoding never makes the text grow */
+    gchar *decoded = g_malloc (length + 1);
+    gchar *out = decoded;
+
+    for (const gchar *amp; (amp = memchr (text, '&', end - text)); )
+    {
+        memcpy (out, text, amp - text);
+        out += amp - text;
+
+        /* Same result as decoding all the "&gt;" first, then all the "&amp;" */
+        if (!strncmp (amp, "&gt;", 4))
+        {
+            *out++ = '>';
+            text = amp + 4;
+        }
+        else if (!strncmp (amp, "&amp;", 5))
+        {
+            *out++ = '&';
+            text = amp + 5;
+        }
+        else
+        {
+            *out++ = '&';
+            text = amp + 1;
+        }
+    }
+
+    memcpy (out, text, end - text);
+    out[end - text] = '\0';
 
-    return g_paste_util_replace (_decoded_text, "&amp;", "&");
+    return decoded;
 }
 
 /**
@@ -602,9 +1030,44 @@ g_paste_util_xml_encode (const gchar *text)
 {
     g_return_val_if_fail (text, NULL);
 
-    g_autofree gchar *_encoded_text = g_paste_util_replace (text, "&", "&amp;");
+    gsize extra = 0;
+
+    for (const gchar *c = text; (c = strpbrk (c, "&>")); ++c)
+        extra += (*c == '&') ? strlen ("amp;") : strlen ("gt;");
+
+    if (!extra)
+        return g_strdup (text);
+
+    gchar *encoded = g_malloc (strlen (text) + extra + 1);
+    gchar *out = encoded;
+
+    for (;;)
+    {
+        gsize span = strcspn (text, "&>");
+
+        memcpy (out, text, span);
+        out += span;
+        text += span;
+
+        if (!*text)
+            break;
+
+        if (*text == '&')
+        {
+            memcpy (out, "&amp;", 5);
+            out += 5;
+        }
+        else
+        {
+            memcpy (out, "&gt;", 4);
+            out += 4;
+        }
+        ++text;
+    }
+
+    *out = '\0';
 
-    return g_paste_util_replace (_encoded_text, ">", "&gt;");
+    return encoded;
 }
 
 /**
@@ -53,8 +53,26 @@ void g_paste_util_show_win (GApplication *application);
 guint32 *g_paste_util_get_dbus_au_result (GVariant *variant,
                                           guint64  *len);
 
-GPasteClientItem *g_paste_util_get_dbus_item_result  (GVariant *variant);
-GList            *g_paste_util_get_dbus_items_result (GVariant *variant);
+GPasteClientItem *g_paste_util_get_dbus_item_result            (GVariant *variant);
+GList            *g_paste_util_get_dbus_items_result           (GVariant *variant);
+GList            *g_paste_util_get_dbus_history_matches_result (GVariant *variant);
+GPasteClientItem *g_paste_util_get_dbus_preview_result         (GVariant *variant);
+GList            *g_paste_util_get_dbus_previews_result        (GVariant *variant);
+GVariant         *g_paste_util_get_dbus_changes_result         (GVariant *variant,
+                                                                guint64  *seq);
+
+gint    g_paste_util_memfd_new         (const gchar  *name,
+                                        gconstpointer data,
+                                        gsize         length,
+                                        GError      **error);
+gint    g_paste_util_memfd_new_from_fd (const gchar  *name,
+                                        gint          fd,
+                                        gsize         max_length,
+                                        gsize        *length,
+                                        GError      **error);
+GBytes *g_paste_util_memfd_read        (gint          fd,
+                                        gsize         max_length,
+                                        GError      **error);
 
 void g_paste_util_write_pid_file (const gchar *component);
 GPid g_paste_util_read_pid_file  (const gchar *component);
@@ -116,6 +116,37 @@ typedef struct {
     guint64          from_index;
 } OnUpdateCallbackData;
 
+typedef struct {
+    GPasteUiHistory *self;
+    guint64          from_index;
+} OnRangeCallbackData;
+
+static void
+g_paste_ui_history_on_range_ready (GObject      *source_object G_GNUC_UNUSED,
+                                   GAsyncResult *res,
+                                   gpointer      user_data)
+{
+    g_autofree OnRangeCallbackData *data = user_data;
+    const GPasteUiHistoryPrivate *priv = _g_paste_ui_history_get_instance_private (data->self);
+    g_autoptr (GError) error = NULL;
+    GList *results = g_paste_client_get_elements_range_finish (priv->client, res, &error);
+
+    if (error)
+        return;
+
+    /* We may have been resized or switched to a search since we asked for this page */
+    if (!priv->search)
+    {
+        GSList *item = g_slist_nth (priv->items, data->from_index);
+        guint64 i = data->from_index;
+
+        for (const GList *r = results; r && item; r = g_list_next (r), item = g_slist_next (item), ++i)
+            g_paste_ui_item_set_index_and_preview (item->data, i, r->data);
+    }
+
+    g_list_free_full (results, g_object_unref);
+}
+
 static void
 g_paste_ui_history_refresh_history (GObject      *source_object G_GNUC_UNUSED,
                                     GAsyncResult *res,
@@ -127,7 +158,6 @@ g_paste_ui_history_refresh_history (GObject      *source_object G_GNUC_UNUSED,
     GPasteUiHistoryPrivate *priv = g_paste_ui_history_get_instance_private (self);
 
     guint64 old_size = priv->size;
-    guint64 refreshTextBound = old_size;
     guint64 new_size = g_paste_client_get_history_size_finish (priv->client, res, NULL);
     guint64 max_size = g_paste_settings_get_max_displayed_history_size (priv->settings);
 
@@ -144,11 +174,11 @@ g_paste_ui_history_refresh_history (GObject      *source_object G_GNUC_UNUSED,
     {
         for (guint64 i = old_size; i < priv->size; ++i)
         {
-            GtkWidget *item = g_paste_ui_item_new (priv->client, priv->settings, priv->rootwin, i);
+            /* Filled in along with the others by g_paste_ui_history_on_range_ready */
+            GtkWidget *item = g_paste_ui_item_new (priv->client, priv->settings, priv->rootwin, (guint64) -1);
             priv->items = g_slist_append (priv->items, item);
         }
         g_paste_ui_history_add_list (GTK_CONTAINER (self), g_slist_nth (priv->items, old_size));
-        refreshTextBound = old_size;
     }
     else if (old_size > priv->size)
     {
@@ -164,15 +194,20 @@ g_paste_ui_history_refresh_history (GObject      *source_object G_GNUC_UNUSED,
             g_paste_ui_history_drop_list (GTK_CONTAINER (self), priv->items);
             priv->items = NULL;
         }
-        refreshTextBound = priv->size;
     }
 
-    GSList *item = priv->items;
-
-    for (guint64 i = 0; i < data->from_index; ++i)
-        item = g_slist_next (item);
-    for (guint64 i = data->from_index; i < refreshTextBound && item; ++i, item = g_slist_next (item))
-        g_paste_ui_item_set_index (item->data, i);
+    if (data->from_index < priv->size)
+    {
+        OnRangeCallbackData *range_data = g_new (OnRangeCallbackData, 1);
+        range_data->self = self;
+        range_data->from_index = data->from_index;
+
+        g_paste_client_get_elements_range (priv->client,
+                                           data->from_index, /* offset */
+                                           priv->size - data->from_index, /* count */
+                                           g_paste_ui_history_on_range_ready,
+                                           range_data);
+    }
 
     if (!priv->item_height)
     {
@@ -222,18 +257,24 @@ on_search_ready (GObject      *source_object G_GNUC_UNUSED,
     GPasteUiHistory *self = user_data;
     GPasteUiHistoryPrivate *priv = g_paste_ui_history_get_instance_private (self);
     GSList *item = priv->items;
+    g_autoptr (GError) error = NULL;
+    GList *results = g_paste_client_search_previews_finish (priv->client, res, &error);
+    guint64 search_results_size = 0;
 
     g_clear_pointer (&priv->search_results, g_strfreev);
-    priv->search_results = g_paste_client_search_finish (priv->client, res, NULL /* error */);
-    guint64 search_results_size = g_strv_length (priv->search_results);
 
-    if (priv->search_results)
+    if (!error)
     {
-        if (search_results_size > priv->size)
-            search_results_size = priv->size;
+        priv->search_results = g_new0 (gchar *, priv->size + 1);
+
+        /* We may have been resized since we asked for priv->size results */
+        for (const GList *r = results; r && search_results_size < priv->size; r = g_list_next (r), item = g_slist_next (item))
+        {
+            priv->search_results[search_results_size++] = g_strdup (g_paste_client_item_get_uuid (r->data));
+            g_paste_ui_item_set_preview (item->data, r->data);
+        }
 
-        for (guint64 i = 0; i < search_results_size; ++i, item = g_slist_next (item))
-            g_paste_ui_item_set_uuid (item->data, priv->search_results[i]);
+        g_list_free_full (results, g_object_unref);
     }
     else
     {
@@ -272,7 +313,13 @@ g_paste_ui_history_search (GPasteUiHistory *self,
             g_free (priv->search);
             priv->search = g_strdup (search);
         }
-        g_paste_client_search (priv->client, search, on_search_ready, self);
+        g_paste_client_search_previews (priv->client,
+                                        search,
+                                        G_PASTE_SEARCH_MODE_REGEX,
+                                        0, /* offset */
+                                        priv->size, /* limit */
+                                        on_search_ready,
+                                        self);
     }
 }
 
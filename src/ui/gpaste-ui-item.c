@@ -4,6 +4,7 @@
  * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
  */
 
+#include <gpaste-replacer.h>
 #include <gpaste-ui-item.h>
 #include <gpaste-util.h>
 
@@ -73,14 +74,42 @@ g_paste_ui_item_on_kind_ready (GObject      *source_object G_GNUC_UNUSED,
     g_paste_ui_item_skeleton_set_uploadable (sk, kind == G_PASTE_ITEM_KIND_TEXT);
 }
 
+static const GPasteReplacer *
+g_paste_ui_item_get_oneline_replacer (void)
+{
+    static gsize initialized = 0;
+    static GPasteReplacer *replacer = NULL;
+
+    if (g_once_init_enter (&initialized))
+    {
+        replacer = g_paste_replacer_new ();
+        g_paste_replacer_add (replacer, "\n", " ");
+        g_once_init_leave (&initialized, 1);
+    }
+
+    return replacer;
+}
+
 static void
-_g_paste_ui_item_ready (GPasteUiItem *self,
-                        const gchar  *txt)
+_g_paste_ui_item_ready (GPasteUiItem  *self,
+                        const gchar   *txt,
+                        GPasteItemKind kind)
 {
     GPasteUiItemPrivate *priv = g_paste_ui_item_get_instance_private (self);
-    g_autofree gchar *oneline = g_paste_util_replace (txt, "\n", " ");
+    g_autofree gchar *oneline = g_paste_replacer_replace (g_paste_ui_item_get_oneline_replacer (), txt);
+
+    if (kind == G_PASTE_ITEM_KIND_INVALID)
+    {
+        g_paste_client_get_element_kind (priv->client, priv->uuid, g_paste_ui_item_on_kind_ready, self);
+    }
+    else
+    {
+        GPasteUiItemSkeleton *sk = G_PASTE_UI_ITEM_SKELETON (self);
+
+        g_paste_ui_item_skeleton_set_editable (sk, kind == G_PASTE_ITEM_KIND_TEXT);
+        g_paste_ui_item_skeleton_set_uploadable (sk, kind == G_PASTE_ITEM_KIND_TEXT);
+    }
 
-    g_paste_client_get_element_kind (priv->client, priv->uuid, g_paste_ui_item_on_kind_ready, self);
     g_paste_ui_item_skeleton_set_index_and_uuid (G_PASTE_UI_ITEM_SKELETON (self), priv->index, priv->uuid);
 
     if (!priv->index)
@@ -107,7 +136,7 @@ g_paste_ui_item_on_text_ready (GObject      *source_object G_GNUC_UNUSED,
     if (!txt || error)
         return;
 
-    _g_paste_ui_item_ready (self, txt);
+    _g_paste_ui_item_ready (self, txt, G_PASTE_ITEM_KIND_INVALID);
 }
 
 static void
@@ -126,7 +155,7 @@ g_paste_ui_item_on_item_ready (GObject      *source_object G_GNUC_UNUSED,
     g_autofree gchar *uuid = priv->uuid;
     priv->uuid = g_strdup (g_paste_client_item_get_uuid (txt));
 
-    _g_paste_ui_item_ready (self, g_paste_client_item_get_value (txt));
+    _g_paste_ui_item_ready (self, g_paste_client_item_get_value (txt), G_PASTE_ITEM_KIND_INVALID);
 }
 
 static void
@@ -214,6 +243,61 @@ g_paste_ui_item_set_uuid (GPasteUiItem *self,
     _g_paste_ui_item_set_index (self, (guint64) -2, TRUE);
 }
 
+static void
+_g_paste_ui_item_set_preview (GPasteUiItem           *self,
+                              guint64                 index,
+                              gboolean                fake_index,
+                              const GPasteClientItem *preview)
+{
+    GPasteUiItemPrivate *priv = g_paste_ui_item_get_instance_private (self);
+    g_autofree gchar *_uuid = priv->uuid;
+
+    priv->uuid = g_strdup (g_paste_client_item_get_uuid (preview));
+    priv->index = index;
+    priv->fake_index = fake_index;
+
+    _g_paste_ui_item_ready (self, g_paste_client_item_get_value (preview), g_paste_client_item_get_kind (preview));
+    gtk_widget_show (GTK_WIDGET (self));
+}
+
+/**
+ * g_paste_ui_item_set_preview:
+ * @self: a #GPasteUiItem instance
+ * @preview: a #GPasteClientItem holding the kind and preview of the item
+ *
+ * Track a new uuid, displaying the preview we already got instead of
+ * asking the daemon for the item
+ */
+G_PASTE_VISIBLE void
+g_paste_ui_item_set_preview (GPasteUiItem           *self,
+                             const GPasteClientItem *preview)
+{
+    g_return_if_fail (_G_PASTE_IS_UI_ITEM (self));
+    g_return_if_fail (_G_PASTE_IS_CLIENT_ITEM (preview));
+
+    _g_paste_ui_item_set_preview (self, (guint64) -2, TRUE, preview);
+}
+
+/**
+ * g_paste_ui_item_set_index_and_preview:
+ * @self: a #GPasteUiItem instance
+ * @index: the index of the corresponding item
+ * @preview: a #GPasteClientItem holding the kind and preview of the item
+ *
+ * Track a new index, displaying the preview we already got instead of
+ * asking the daemon for the item
+ */
+G_PASTE_VISIBLE void
+g_paste_ui_item_set_index_and_preview (GPasteUiItem           *self,
+                                       guint64                 index,
+                                       const GPasteClientItem *preview)
+{
+    g_return_if_fail (_G_PASTE_IS_UI_ITEM (self));
+    g_return_if_fail (_G_PASTE_IS_CLIENT_ITEM (preview));
+
+    _g_paste_ui_item_set_preview (self, index, FALSE, preview);
+}
+
 static void
 g_paste_ui_item_dispose (GObject *object)
 {
@@ -28,6 +28,13 @@ void      g_paste_ui_item_set_index (GPasteUiItem *self,
 void      g_paste_ui_item_set_uuid (GPasteUiItem *self,
                                     const gchar  *uuid);
 
+void      g_paste_ui_item_set_preview (GPasteUiItem           *self,
+                                       const GPasteClientItem *preview);
+
+void      g_paste_ui_item_set_index_and_preview (GPasteUiItem           *self,
+                                                 guint64                 index,
+                                                 const GPasteClientItem *preview);
+
 GtkWidget *g_paste_ui_item_new (GPasteClient   *client,
                                 GPasteSettings *settings,
                                 GtkWindow      *rootwin,
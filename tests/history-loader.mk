@@ -0,0 +1,23 @@
+## This file is part of GPaste.
+##
+## Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+
+# Not part of TESTS, run it by hand: bin/bench-history-loader [n_items...]
+noinst_PROGRAMS+=                  \
+	bin/bench-history-loader \
+	$(NULL)
+
+bin_bench_history_loader_SOURCES =                   \
+	%D%/history-loader/bench-history-loader.c \
+	$(NULL)
+
+bin_bench_history_loader_CFLAGS = \
+	$(GLIB_CFLAGS)            \
+	$(GTK_CFLAGS)             \
+	$(NULL)
+
+bin_bench_history_loader_LDADD =         \
+	$(builddir)/$(libgpaste_la_file) \
+	$(GLIB_LIBS)                     \
+	$(GTK_LIBS)                      \
+	$(NULL)
@@ -0,0 +1,151 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste.h>
+
+#include <glib/gstdio.h>
+#include <sys/resource.h>
+
+#define EXIT_TEST_SKIP 77
+
+/* The upper bound of max-history-size, loading more would only measure truncation */
+#define MAX_ITEMS 65535
+
+static gboolean
+write_history (const gchar *history_file_path,
+               guint64      n_items,
+               GError     **error)
+{
+    g_autoptr (GString) contents = g_string_new ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                                 "<history version=\"2.0\">\n");
+
+    for (guint64 i = 0; i < n_items; ++i)
+    {
+        g_autofree gchar *uuid = g_uuid_string_random ();
+
+        g_string_append_printf (contents,
+                                "  <item kind=\"Text\" uuid=\"%s\">\n"
+                                "    <value><![CDATA[Item %" G_GUINT64_FORMAT ": some text with an &amp; and a &gt; to decode]]></value>\n"
+                                "  </item>\n",
+                                uuid, i);
+    }
+
+    g_string_append (contents, "</history>\n");
+
+    return g_file_set_contents (history_file_path, contents->str, contents->len, error);
+}
+
+/* This is the peak of the whole process, sizes are benchmarked in increasing order */
+static glong
+get_peak_rss (void)
+{
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage))
+        return -1;
+
+    return usage.ru_maxrss;
+}
+
+static gboolean
+bench_history_loader (GPasteStorageBackend *backend,
+                      guint64               n_items,
+                      GError              **error)
+{
+    g_autofree gchar *name = g_strdup_printf ("bench-%" G_GUINT64_FORMAT, n_items);
+    g_autofree gchar *history_file_path = g_paste_util_get_history_file_path (name, "xml");
+
+    if (!write_history (history_file_path, n_items, error))
+        return FALSE;
+
+    GList *history = NULL;
+    gsize size = 0;
+    gint64 start = g_get_monotonic_time ();
+
+    g_paste_storage_backend_read_history (backend, name, &history, &size);
+
+    gint64 elapsed = g_get_monotonic_time () - start;
+
+    g_print ("%6" G_GUINT64_FORMAT " items: loaded %u items (%" G_GSIZE_FORMAT " bytes) in %.3f ms, peak RSS %ld KiB\n",
+             n_items,
+             g_list_length (history),
+             size,
+             elapsed / 1000.,
+             get_peak_rss ());
+
+    g_list_free_full (history, g_object_unref);
+    g_unlink (history_file_path);
+
+    return TRUE;
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+    g_autoptr (GError) error = NULL;
+    g_autofree gchar *tmp_dir = g_dir_make_tmp ("gpaste-bench-XXXXXX", &error);
+
+    if (!tmp_dir)
+    {
+        g_critical ("Couldn't create a temporary directory: %s", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Don't touch the real histories nor settings */
+    g_setenv ("XDG_DATA_HOME", tmp_dir, TRUE);
+    g_setenv ("XDG_CONFIG_HOME", tmp_dir, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+    g_autoptr (GSettingsSchema) schema = g_settings_schema_source_lookup (g_settings_schema_source_get_default (), G_PASTE_SETTINGS_NAME, TRUE);
+
+    if (!schema)
+    {
+        g_print ("GPaste settings schema isn't installed, skipping\n");
+        g_rmdir (tmp_dir);
+        return EXIT_TEST_SKIP;
+    }
+
+    g_autoptr (GPasteSettings) settings = g_paste_settings_new ();
+
+    /* Load as much as we can, the parser has to go through the whole file anyway */
+    g_paste_settings_set_max_history_size (settings, MAX_ITEMS);
+
+    g_autoptr (GPasteStorageBackend) backend = g_paste_storage_backend_new (G_PASTE_STORAGE_FILE, settings);
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+    gint ret = EXIT_SUCCESS;
+
+    if (!g_paste_util_ensure_history_dir_exists (settings))
+    {
+        g_critical ("Couldn't create the history directory");
+        ret = EXIT_FAILURE;
+    }
+    else if (argc > 1)
+    {
+        for (gint i = 1; i < argc && ret == EXIT_SUCCESS; ++i)
+        {
+            if (!bench_history_loader (backend, MIN (g_ascii_strtoull (argv[i], NULL, 10), MAX_ITEMS), &error))
+                ret = EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        static const guint64 sizes[] = { 1000, 10000, MAX_ITEMS };
+
+        for (guint i = 0; i < G_N_ELEMENTS (sizes) && ret == EXIT_SUCCESS; ++i)
+        {
+            if (!bench_history_loader (backend, sizes[i], &error))
+                ret = EXIT_FAILURE;
+        }
+    }
+
+    if (error)
+        g_critical ("Couldn't write the history: %s", error->message);
+
+    g_rmdir (history_dir_path);
+    g_rmdir (tmp_dir);
+
+    return ret;
+}
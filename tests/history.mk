@@ -0,0 +1,22 @@
+## This file is part of GPaste.
+##
+## Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+
+TESTS+=                  \
+	bin/test-history \
+	$(NULL)
+
+bin_test_history_SOURCES =         \
+	%D%/history/test-history.c \
+	$(NULL)
+
+bin_test_history_CFLAGS = \
+	$(GLIB_CFLAGS)    \
+	$(GTK_CFLAGS)     \
+	$(NULL)
+
+bin_test_history_LDADD =                 \
+	$(builddir)/$(libgpaste_la_file) \
+	$(GLIB_LIBS)                     \
+	$(GTK_LIBS)                      \
+	$(NULL)
@@ -0,0 +1,110 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste.h>
+
+#include <glib/gstdio.h>
+
+#define EXIT_TEST_SKIP 77
+
+static gboolean
+check_history (GPasteHistory *history,
+               const gchar   *what,
+               const gchar   *expected[],
+               guint64        n_expected)
+{
+    if (g_paste_history_get_length (history) != n_expected || g_list_length ((GList *) g_paste_history_get_history (history)) != n_expected)
+    {
+        g_critical ("%s: expected %" G_GUINT64_FORMAT " items, got %" G_GUINT64_FORMAT, what, n_expected, g_paste_history_get_length (history));
+        return FALSE;
+    }
+
+    for (guint64 i = 0; i < n_expected; ++i)
+    {
+        const gchar *value = g_paste_item_get_value (g_paste_history_get (history, i));
+
+        if (!g_paste_str_equal (value, expected[i]))
+        {
+            g_critical ("%s: expected '%s' at %" G_GUINT64_FORMAT ", got '%s'", what, expected[i], i, value);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Passwords never compare equal to anything, selecting one must still move it rather than add it again */
+static gboolean
+test_select_password (GPasteHistory *history)
+{
+    g_paste_history_add (history, g_paste_text_item_new ("first"));
+    g_paste_history_add (history, g_paste_password_item_new ("name", "secret"));
+    g_paste_history_add (history, g_paste_text_item_new ("last"));
+
+    g_autofree gchar *uuid = g_strdup (g_paste_item_get_uuid (g_paste_history_get (history, 1)));
+    const gchar *selected[] = { "secret", "last", "first" };
+    const gchar *deleted[] = { "last", "first" };
+
+    if (!g_paste_history_select (history, uuid))
+    {
+        g_critical ("Couldn't select the password");
+        return FALSE;
+    }
+
+    if (!check_history (history, "select password", selected, G_N_ELEMENTS (selected)))
+        return FALSE;
+
+    if (!g_paste_history_remove_by_uuid (history, uuid))
+    {
+        g_critical ("Couldn't delete the password");
+        return FALSE;
+    }
+
+    return check_history (history, "delete password", deleted, G_N_ELEMENTS (deleted));
+}
+
+gint
+main (gint argc G_GNUC_UNUSED, gchar *argv[] G_GNUC_UNUSED)
+{
+    g_autoptr (GError) error = NULL;
+    g_autofree gchar *tmp_dir = g_dir_make_tmp ("gpaste-test-XXXXXX", &error);
+
+    if (!tmp_dir)
+    {
+        g_critical ("Couldn't create a temporary directory: %s", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Don't touch the real histories nor settings */
+    g_setenv ("XDG_DATA_HOME", tmp_dir, TRUE);
+    g_setenv ("XDG_CONFIG_HOME", tmp_dir, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+    g_autoptr (GSettingsSchema) schema = g_settings_schema_source_lookup (g_settings_schema_source_get_default (), G_PASTE_SETTINGS_NAME, TRUE);
+
+    if (!schema)
+    {
+        g_print ("GPaste settings schema isn't installed, skipping\n");
+        g_rmdir (tmp_dir);
+        return EXIT_TEST_SKIP;
+    }
+
+    g_autoptr (GPasteSettings) settings = g_paste_settings_new ();
+    g_autoptr (GPasteHistory) history = g_paste_history_new (settings);
+
+    g_paste_history_load (history, NULL);
+
+    gint ret = (test_select_password (history)) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    g_paste_history_delete (history, g_paste_history_get_current (history), NULL);
+
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+
+    g_rmdir (history_dir_path);
+    g_rmdir (tmp_dir);
+
+    return ret;
+}
@@ -0,0 +1,23 @@
+## This file is part of GPaste.
+##
+## Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+
+# Not part of TESTS, run it by hand: bin/bench-replacer [n_lines...]
+noinst_PROGRAMS+=           \
+	bin/bench-replacer \
+	$(NULL)
+
+bin_bench_replacer_SOURCES =             \
+	%D%/replacer/bench-replacer.c \
+	$(NULL)
+
+bin_bench_replacer_CFLAGS = \
+	$(GLIB_CFLAGS)      \
+	$(GTK_CFLAGS)       \
+	$(NULL)
+
+bin_bench_replacer_LDADD =               \
+	$(builddir)/$(libgpaste_la_file) \
+	$(GLIB_LIBS)                     \
+	$(GTK_LIBS)                      \
+	$(NULL)
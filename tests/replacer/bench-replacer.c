@@ -0,0 +1,129 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste.h>
+
+#include <string.h>
+
+#define N_ROUNDS 20
+
+/* What the callers used to do: one GRegex compiled per pattern and per call */
+static gchar *
+regex_replace (const gchar *text,
+               const gchar *pattern,
+               const gchar *substitution)
+{
+    g_autofree gchar *regex_string = g_regex_escape_string (pattern, -1);
+    g_autoptr (GRegex) regex = g_regex_new (regex_string,
+                                            0, /* Compile options */
+                                            0, /* Match options */
+                                            NULL); /* Error */
+
+    return g_regex_replace_literal (regex,
+                                    text,
+                                    (gssize) -1,
+                                    0, /* Start position */
+                                    substitution,
+                                    0, /* Match options */
+                                    NULL); /* Error */
+}
+
+static gchar *
+make_uris (guint64 n_uris)
+{
+    g_autoptr (GString) uris = g_string_new (NULL);
+    const gchar *home = g_get_home_dir ();
+
+    for (guint64 i = 0; i < n_uris; ++i)
+        g_string_append_printf (uris, "%s/Documents/some/deep/folder/file-%" G_GUINT64_FORMAT ".txt\n", home, i);
+
+    return g_string_free (g_steal_pointer (&uris), FALSE);
+}
+
+static gchar *
+make_text (guint64 n_lines)
+{
+    g_autoptr (GString) text = g_string_new (NULL);
+
+    for (guint64 i = 0; i < n_lines; ++i)
+        g_string_append_printf (text, "Line %" G_GUINT64_FORMAT " of some text copied from a terminal or an editor\n", i);
+
+    return g_string_free (g_steal_pointer (&text), FALSE);
+}
+
+static void
+bench (const gchar          *what,
+       const gchar          *text,
+       const GPasteReplacer *replacer,
+       gboolean              with_home)
+{
+    const gchar *home = g_get_home_dir ();
+    gint64 start = g_get_monotonic_time ();
+
+    for (guint i = 0; i < N_ROUNDS; ++i)
+    {
+        g_autofree gchar *replaced = NULL;
+
+        if (with_home)
+        {
+            g_autofree gchar *tmp = regex_replace (text, home, "~");
+
+            replaced = regex_replace (tmp, "\n", " ");
+        }
+        else
+        {
+            replaced = regex_replace (text, "\n", " ");
+        }
+    }
+
+    gint64 regex_elapsed = g_get_monotonic_time () - start;
+
+    start = g_get_monotonic_time ();
+    for (guint i = 0; i < N_ROUNDS; ++i)
+        g_free (g_paste_replacer_replace (replacer, text));
+
+    gint64 replacer_elapsed = g_get_monotonic_time () - start;
+
+    g_print ("%-8s %9" G_GSIZE_FORMAT " bytes: regex %8.3f ms, replacer %8.3f ms\n",
+             what, strlen (text),
+             regex_elapsed / 1000.0 / N_ROUNDS,
+             replacer_elapsed / 1000.0 / N_ROUNDS);
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+    g_autoptr (GPasteReplacer) uris_replacer = g_paste_replacer_new ();
+    g_autoptr (GPasteReplacer) text_replacer = g_paste_replacer_new ();
+    guint64 sizes[] = { 100, 10000, 100000 };
+    guint64 *n_lines = sizes;
+    gsize n_sizes = G_N_ELEMENTS (sizes);
+    g_autofree guint64 *custom_sizes = NULL;
+
+    if (argc > 1)
+    {
+        custom_sizes = g_new (guint64, argc - 1);
+        for (gint i = 1; i < argc; ++i)
+            custom_sizes[i - 1] = g_ascii_strtoull (argv[i], NULL, 10);
+        n_lines = custom_sizes;
+        n_sizes = argc - 1;
+    }
+
+    g_paste_replacer_add (uris_replacer, g_get_home_dir (), "~");
+    g_paste_replacer_add (uris_replacer, "\n", " ");
+    g_paste_replacer_add (text_replacer, "\n", " ");
+
+    for (gsize i = 0; i < n_sizes; ++i)
+    {
+        g_autofree gchar *uris = make_uris (n_lines[i]);
+        g_autofree gchar *text = make_text (n_lines[i]);
+
+        bench ("uris", uris, uris_replacer, TRUE);
+        bench ("text", text, text_replacer, FALSE);
+    }
+
+    return EXIT_SUCCESS;
+}
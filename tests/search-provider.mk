@@ -0,0 +1,22 @@
+## This file is part of GPaste.
+##
+## Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+
+TESTS+=                          \
+	bin/test-search-provider \
+	$(NULL)
+
+bin_test_search_provider_SOURCES =                 \
+	%D%/search-provider/test-search-provider.c \
+	$(NULL)
+
+bin_test_search_provider_CFLAGS = \
+	$(GLIB_CFLAGS)            \
+	$(GTK_CFLAGS)             \
+	$(NULL)
+
+bin_test_search_provider_LDADD =         \
+	$(builddir)/$(libgpaste_la_file) \
+	$(GLIB_LIBS)                     \
+	$(GTK_LIBS)                      \
+	$(NULL)
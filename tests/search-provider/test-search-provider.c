@@ -0,0 +1,309 @@
+/*
+ * This file is part of GPaste.
+ *
+ * Copyright (c) 2010-2018, Marc-Antoine Perennou <Marc-Antoine@Perennou.com>
+ */
+
+#include <gpaste.h>
+
+#include <glib/gstdio.h>
+
+#define EXIT_TEST_SKIP 77
+
+#define N_ITEMS  1000
+#define N_ROUNDS 200
+
+/*
+ * Compare the search provider going through the bus to the daemon,
+ * as it would from another process, to the one using the daemon's
+ * history directly, as registered by gpaste-daemon.
+ * Both answer GetInitialResultSet and GetResultMetas, like the shell does
+ * on each keystroke, and must give the same results and metas.
+ */
+
+typedef struct
+{
+    const gchar *what;
+    const gchar *bus_name;
+    GStrv        results;
+    GVariant    *metas;
+    gint64       elapsed;
+} Measure;
+
+typedef struct
+{
+    const gchar *address;
+    Measure      measures[2];
+    gboolean     success;
+    GMainLoop   *loop;
+} TestData;
+
+static GDBusConnection *
+new_connection (const gchar *address,
+                GError     **error)
+{
+    return g_dbus_connection_new_for_address_sync (address,
+                                                   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT|G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                                   NULL, /* observer */
+                                                   NULL, /* cancellable */
+                                                   error);
+}
+
+static GVariant *
+call_provider (GDBusConnection *connection,
+               const gchar     *bus_name,
+               const gchar     *method,
+               GVariant        *parameters,
+               const gchar     *reply_type,
+               GError         **error)
+{
+    return g_dbus_connection_call_sync (connection,
+                                        bus_name,
+                                        G_PASTE_SEARCH_PROVIDER_OBJECT_PATH,
+                                        G_PASTE_SEARCH_PROVIDER_INTERFACE_NAME,
+                                        method,
+                                        parameters,
+                                        G_VARIANT_TYPE (reply_type),
+                                        G_DBUS_CALL_FLAGS_NONE,
+                                        -1, /* timeout */
+                                        NULL, /* cancellable */
+                                        error);
+}
+
+/* What the shell does when the user types "item 12" */
+static GStrv
+search (GDBusConnection *connection,
+        const gchar     *bus_name,
+        GVariant       **metas,
+        GError         **error)
+{
+    const gchar *terms[] = { "item", "12", NULL };
+    g_autoptr (GVariant) ans = call_provider (connection, bus_name,
+                                              G_PASTE_SEARCH_PROVIDER_GET_INITIAL_RESULT_SET,
+                                              g_variant_new ("(^as)", terms),
+                                              "(as)",
+                                              error);
+
+    if (!ans)
+        return NULL;
+
+    GStrv results = NULL;
+
+    g_variant_get (ans, "(^as)", &results);
+
+    if (results[0])
+    {
+        g_autoptr (GVariant) ans_metas = call_provider (connection, bus_name,
+                                                        G_PASTE_SEARCH_PROVIDER_GET_RESULT_METAS,
+                                                        g_variant_new ("(^as)", results),
+                                                        "(aa{sv})",
+                                                        error);
+
+        if (!ans_metas)
+            g_clear_pointer (&results, g_strfreev);
+        else if (metas)
+            *metas = g_variant_get_child_value (ans_metas, 0);
+    }
+
+    return results;
+}
+
+static gboolean
+measure (GDBusConnection *connection,
+         Measure         *m,
+         GError         **error)
+{
+    /* Warm up, and wait for the proxy to find the daemon */
+    for (guint i = 0; i < 500; ++i)
+    {
+        g_auto (GStrv) results = search (connection, m->bus_name, NULL, error);
+
+        if (!results)
+            return FALSE;
+        if (results[0])
+            break;
+
+        g_usleep (10000);
+    }
+
+    gint64 start = g_get_monotonic_time ();
+
+    for (guint i = 0; i < N_ROUNDS; ++i)
+    {
+        g_strfreev (m->results);
+        g_clear_pointer (&m->metas, g_variant_unref);
+        if (!(m->results = search (connection, m->bus_name, &m->metas, error)))
+            return FALSE;
+    }
+
+    m->elapsed = g_get_monotonic_time () - start;
+
+    g_print ("%-12s %8.1f µs per search, %u results\n", m->what, (gdouble) m->elapsed / N_ROUNDS, g_strv_length (m->results));
+
+    return TRUE;
+}
+
+static gpointer
+test_thread (gpointer user_data)
+{
+    TestData *data = user_data;
+    g_autoptr (GError) error = NULL;
+    g_autoptr (GDBusConnection) connection = new_connection (data->address, &error);
+
+    data->success = (connection &&
+                     measure (connection, &data->measures[0], &error) &&
+                     measure (connection, &data->measures[1], &error));
+
+    if (error)
+        g_critical ("Search failed: %s", error->message);
+
+    g_main_loop_quit (data->loop);
+
+    return NULL;
+}
+
+/* Each provider lives on its own connection, at the usual object path */
+static GDBusConnection *
+register_provider (const gchar     *address,
+                   GPasteBusObject *provider,
+                   GError         **error)
+{
+    g_autoptr (GDBusConnection) connection = new_connection (address, error);
+
+    if (!connection || !g_paste_bus_object_register_on_connection (provider, connection, error))
+        return NULL;
+
+    return g_steal_pointer (&connection);
+}
+
+static gint
+run_test (const gchar *address)
+{
+    g_autoptr (GError) error = NULL;
+    g_autoptr (GPasteSettings) settings = g_paste_settings_new ();
+
+    g_paste_settings_set_max_history_size (settings, N_ITEMS);
+
+    g_autoptr (GPasteDaemon) daemon = g_paste_daemon_new ();
+    GPasteHistory *history = g_paste_daemon_get_history (daemon);
+
+    for (guint i = 0; i < N_ITEMS; ++i)
+    {
+        g_autofree gchar *text = g_strdup_printf ("item %u: some text\nspanning several lines", i);
+
+        g_paste_history_add (history, g_paste_text_item_new (text));
+    }
+
+    g_autoptr (GDBusConnection) session = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+
+    if (!session || !g_paste_bus_object_register_on_connection (G_PASTE_BUS_OBJECT (daemon), session, &error))
+    {
+        g_critical ("Couldn't register the daemon: %s", error->message);
+        return EXIT_FAILURE;
+    }
+
+    guint owner_id = g_bus_own_name_on_connection (session,
+                                                   G_PASTE_BUS_NAME,
+                                                   G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                   NULL, /* on_name_acquired */
+                                                   NULL, /* on_name_lost */
+                                                   NULL, /* user_data */
+                                                   NULL); /* user_data_free_func */
+
+    g_autoptr (GPasteBusObject) remote = g_paste_search_provider_new ();
+    g_autoptr (GPasteBusObject) local = g_paste_search_provider_new_for_history (history);
+    g_autoptr (GDBusConnection) remote_connection = register_provider (address, remote, &error);
+    g_autoptr (GDBusConnection) local_connection = (remote_connection) ? register_provider (address, local, &error) : NULL;
+
+    if (!local_connection)
+    {
+        g_critical ("Couldn't register the search providers: %s", error->message);
+        g_bus_unown_name (owner_id);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+    TestData data = {
+        address,
+        {
+            { "over the bus", g_dbus_connection_get_unique_name (remote_connection), NULL, NULL, 0 },
+            { "in process",   g_dbus_connection_get_unique_name (local_connection),  NULL, NULL, 0 }
+        },
+        FALSE,
+        loop
+    };
+    GThread *thread = g_thread_new ("test-search-provider", test_thread, &data);
+
+    g_main_loop_run (loop);
+    g_thread_join (thread);
+
+    if (data.success)
+    {
+        g_print ("in process is %.1fx faster\n", (gdouble) data.measures[0].elapsed / MAX (data.measures[1].elapsed, 1));
+
+        if (!g_strv_length (data.measures[0].results) ||
+            !g_strv_equal ((const gchar * const *) data.measures[0].results, (const gchar * const *) data.measures[1].results))
+        {
+            g_critical ("Both search providers should find the same results");
+            data.success = FALSE;
+        }
+        else if (!data.measures[0].metas || !data.measures[1].metas || !g_variant_equal (data.measures[0].metas, data.measures[1].metas))
+        {
+            g_critical ("Both search providers should give the same result metas");
+            data.success = FALSE;
+        }
+    }
+
+    g_strfreev (data.measures[0].results);
+    g_strfreev (data.measures[1].results);
+    g_clear_pointer (&data.measures[0].metas, g_variant_unref);
+    g_clear_pointer (&data.measures[1].metas, g_variant_unref);
+    g_bus_unown_name (owner_id);
+    g_paste_history_delete (history, g_paste_history_get_current (history), NULL);
+
+    return (data.success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+gint
+main (gint argc, gchar *argv[])
+{
+    g_autoptr (GError) error = NULL;
+    g_autofree gchar *tmp_dir = g_dir_make_tmp ("gpaste-test-XXXXXX", &error);
+
+    if (!tmp_dir)
+    {
+        g_critical ("Couldn't create a temporary directory: %s", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Don't touch the real histories nor settings */
+    g_setenv ("XDG_DATA_HOME", tmp_dir, TRUE);
+    g_setenv ("XDG_CONFIG_HOME", tmp_dir, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+    g_autoptr (GSettingsSchema) schema = g_settings_schema_source_lookup (g_settings_schema_source_get_default (), G_PASTE_SETTINGS_NAME, TRUE);
+    g_autofree gchar *dbus_daemon = g_find_program_in_path ("dbus-daemon");
+
+    if (!schema || !dbus_daemon || !gtk_init_check (&argc, &argv))
+    {
+        g_print ("Needs the GPaste settings schema, dbus-daemon and a display, skipping\n");
+        g_rmdir (tmp_dir);
+        return EXIT_TEST_SKIP;
+    }
+
+    /* A private session bus, not to conflict with a running daemon */
+    g_autoptr (GTestDBus) bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+
+    g_test_dbus_up (bus);
+
+    gint ret = run_test (g_test_dbus_get_bus_address (bus));
+
+    g_test_dbus_down (bus);
+
+    g_autofree gchar *history_dir_path = g_paste_util_get_history_dir_path ();
+
+    g_rmdir (history_dir_path);
+    g_rmdir (tmp_dir);
+
+    return ret;
+}